@@ -74,6 +74,43 @@ constexpr auto popcount(T value) -> u8 {
     return count;
 }
 
+//Count trailing zeros, value must not be zero
+template<typename T>
+inline auto ctz(T value) -> u8 {
+    static_assert(std::is_integral_v<T>);
+    assert(value != 0);
+
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(static_cast<unsigned long long>(value));
+    #else
+    u8 count = 0;
+    for(; (value & 1) == 0; value >>= 1) {
+        count++;
+    }
+
+    return count;
+    #endif
+}
+
+//Swaps between host order and little-endian, a no-op on little-endian hosts
+template<typename T>
+constexpr auto to_le(T value) -> T {
+    static_assert(std::is_integral_v<T>);
+
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if constexpr(sizeof(T) > 1) {
+        std::make_unsigned_t<T> swapped = 0;
+        for(size_t i = 0; i < sizeof(T); i++) {
+            swapped = (swapped << 8) | (static_cast<std::make_unsigned_t<T>>(value) >> (i * 8) & 0xFF);
+        }
+
+        return static_cast<T>(swapped);
+    }
+    #endif
+
+    return value;
+}
+
 template<u8 start_size, typename R, typename T>
 constexpr auto sign_extend(T value) -> R {
     static_assert(std::is_integral_v<T>);
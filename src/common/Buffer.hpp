@@ -1,8 +1,10 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
 #include <cstring>
 #include <cassert>
+#include <utility>
 
 
 namespace common {
@@ -195,4 +197,196 @@ private:
     mutable std::mutex m_access_mutex;
 };
 
+
+//A lock-free queue for exactly one producer thread and one consumer thread.
+//The head is only written by the producer and the tail only by the consumer,
+//so neither side ever blocks the other. Capacity must be a power of two.
+template<typename T, size_t _capacity>
+class SPSCRingBuffer {
+public:
+
+    static_assert((_capacity & (_capacity - 1)) == 0, "SPSCRingBuffer capacity must be a power of two!");
+
+    SPSCRingBuffer() {
+        head.store(0);
+        tail.store(0);
+    }
+
+    //Producer side, returns false if there is not enough space.
+    inline auto push(const T &value) -> bool {
+        const size_t current_head = head.load(std::memory_order_relaxed);
+
+        if(current_head - tail.load(std::memory_order_acquire) == _capacity) {
+            return false;
+        }
+
+        data[current_head & (_capacity - 1)] = value;
+        head.store(current_head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //Producer side, pushes either all or none of the values.
+    inline auto push_many(const T *src, size_t amount) -> bool {
+        const size_t current_head = head.load(std::memory_order_relaxed);
+
+        if(_capacity - (current_head - tail.load(std::memory_order_acquire)) < amount) {
+            return false;
+        }
+
+        const size_t start = current_head & (_capacity - 1);
+        const size_t to_end = _capacity - start;
+        if(to_end >= amount) {
+            std::memcpy(&data[start], src, amount * sizeof(T));
+        } else {
+            std::memcpy(&data[start], src, to_end * sizeof(T));
+            std::memcpy(data, src + to_end, (amount - to_end) * sizeof(T));
+        }
+
+        head.store(current_head + amount, std::memory_order_release);
+
+        return true;
+    }
+
+    //Consumer side, returns false if the buffer is empty.
+    inline auto pop(T &value) -> bool {
+        const size_t current_tail = tail.load(std::memory_order_relaxed);
+
+        if(head.load(std::memory_order_acquire) == current_tail) {
+            return false;
+        }
+
+        value = data[current_tail & (_capacity - 1)];
+        tail.store(current_tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //Consumer side, pops up to amount values and returns the number actually popped.
+    inline auto pop_many(T *dst, size_t amount) -> size_t {
+        const size_t current_tail = tail.load(std::memory_order_relaxed);
+        const size_t available = head.load(std::memory_order_acquire) - current_tail;
+
+        if(amount > available) {
+            amount = available;
+        }
+
+        const size_t start = current_tail & (_capacity - 1);
+        const size_t to_end = _capacity - start;
+        if(to_end >= amount) {
+            std::memcpy(dst, &data[start], amount * sizeof(T));
+        } else {
+            std::memcpy(dst, &data[start], to_end * sizeof(T));
+            std::memcpy(dst + to_end, data, (amount - to_end) * sizeof(T));
+        }
+
+        tail.store(current_tail + amount, std::memory_order_release);
+
+        return amount;
+    }
+
+    //Only safe to call while neither side is active.
+    inline void clear() {
+        head.store(0);
+        tail.store(0);
+    }
+
+    inline auto size() const -> size_t {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    inline auto empty() const -> bool {
+        return size() == 0;
+    }
+
+    constexpr auto capacity() const -> size_t {
+        return _capacity;
+    }
+
+private:
+
+    T data[_capacity];
+
+    //Kept on separate cache lines to avoid false sharing between the two threads
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+
+//A lock-free queue for any number of producer threads and one consumer thread.
+//Producers claim a slot by moving the head forward, and each slot has its own
+//sequence number that says when it's been filled or emptied, so a producer
+//never waits on a lock. Capacity must be a power of two.
+template<typename T, size_t _capacity>
+class MPSCRingBuffer {
+public:
+
+    static_assert((_capacity & (_capacity - 1)) == 0, "MPSCRingBuffer capacity must be a power of two!");
+
+    MPSCRingBuffer() {
+        for(size_t i = 0; i < _capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        head.store(0);
+        tail = 0;
+    }
+
+    //Producer side, returns false if there is not enough space.
+    inline auto push(T &&value) -> bool {
+        size_t position = head.load(std::memory_order_relaxed);
+        Slot *slot;
+
+        while(true) {
+            slot = &slots[position & (_capacity - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+            if(sequence == position) {
+                if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(sequence < position) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = std::move(value);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //Consumer side, returns false if the buffer is empty or the next value is still being written.
+    inline auto pop(T &value) -> bool {
+        Slot &slot = slots[tail & (_capacity - 1)];
+
+        if(slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+            return false;
+        }
+
+        value = std::move(slot.value);
+        slot.sequence.store(tail + _capacity, std::memory_order_release);
+        tail++;
+
+        return true;
+    }
+
+    constexpr auto capacity() const -> size_t {
+        return _capacity;
+    }
+
+private:
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot slots[_capacity];
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) size_t tail;
+};
+
 } //namespace common
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "Compression.hpp"
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 0xFFFF;
+constexpr size_t HASH_BITS = 14;
+constexpr size_t NO_POSITION = ~static_cast<size_t>(0);
+
+
+namespace common {
+
+static inline auto read32(const u8 *data) -> u32 {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline auto hash(u32 sequence) -> size_t {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+//Lengths that don't fit in the token's nibble carry on in bytes of up to 255
+static inline void writeLength(std::vector<u8> &output, size_t length) {
+    while(length >= 255) {
+        output.push_back(255);
+        length -= 255;
+    }
+
+    output.push_back(length);
+}
+
+static inline auto readLength(const u8 *&data, const u8 *end, size_t &length) -> bool {
+    u8 byte;
+
+    do {
+        if(data == end) {
+            return false;
+        }
+
+        byte = *data++;
+        length += byte;
+    } while(byte == 255);
+
+    return true;
+}
+
+static void writeSequence(std::vector<u8> &output, const u8 *literals, size_t literal_length, size_t offset, size_t match_length) {
+    const size_t match_code = match_length - MIN_MATCH;
+    const bool last = match_length == 0;
+
+    output.push_back((std::min<size_t>(literal_length, 15) << 4) | (last ? 0 : std::min<size_t>(match_code, 15)));
+
+    if(literal_length >= 15) {
+        writeLength(output, literal_length - 15);
+    }
+
+    output.insert(output.end(), literals, literals + literal_length);
+
+    //The last sequence is only literals
+    if(last) {
+        return;
+    }
+
+    output.push_back(offset & 0xFF);
+    output.push_back(offset >> 8);
+
+    if(match_code >= 15) {
+        writeLength(output, match_code - 15);
+    }
+}
+
+void compress(const u8 *data, size_t size, std::vector<u8> &output) {
+    std::vector<size_t> table(static_cast<size_t>(1) << HASH_BITS, NO_POSITION);
+    size_t anchor = 0;
+    size_t i = 0;
+    size_t misses = 0;
+
+    output.clear();
+
+    while(i + MIN_MATCH <= size) {
+        const u32 sequence = read32(&data[i]);
+        const size_t h = hash(sequence);
+        const size_t candidate = table[h];
+        table[h] = i;
+
+        if(candidate == NO_POSITION || i - candidate > MAX_OFFSET || read32(&data[candidate]) != sequence) {
+            //Step further the longer nothing matches, so data that doesn't compress goes by quickly
+            i += 1 + (misses++ >> 6);
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while(i + length < size && data[candidate + length] == data[i + length]) {
+            length++;
+        }
+
+        writeSequence(output, &data[anchor], i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+        misses = 0;
+    }
+
+    writeSequence(output, &data[anchor], size - anchor, 0, 0);
+}
+
+//Fails instead of reading or writing out of bounds when the data is corrupt
+auto decompress(const u8 *data, size_t size, u8 *output, size_t output_size) -> bool {
+    const u8 *end = data + size;
+    size_t position = 0;
+
+    //Always ends on a sequence of only literals, so data cut off after a match isn't taken as whole
+    while(data < end) {
+        const u8 token = *data++;
+        size_t literal_length = token >> 4;
+
+        if(literal_length == 15 && !readLength(data, end, literal_length)) {
+            return false;
+        }
+        if(literal_length > static_cast<size_t>(end - data) || literal_length > output_size - position) {
+            return false;
+        }
+
+        std::memcpy(&output[position], data, literal_length);
+        data += literal_length;
+        position += literal_length;
+
+        if(data == end) {
+            return position == output_size;
+        }
+        if(end - data < 2) {
+            return false;
+        }
+
+        const size_t offset = data[0] | data[1] << 8;
+        size_t match_length = token & 15;
+        data += 2;
+
+        if(match_length == 15 && !readLength(data, end, match_length)) {
+            return false;
+        }
+
+        match_length += MIN_MATCH;
+
+        if(offset == 0 || offset > position || match_length > output_size - position) {
+            return false;
+        }
+
+        //Matches can overlap what they're copying, which repeats it
+        if(offset >= match_length) {
+            std::memcpy(&output[position], &output[position - offset], match_length);
+        } else {
+            for(size_t i = 0; i < match_length; i++) {
+                output[position + i] = output[position - offset + i];
+            }
+        }
+
+        position += match_length;
+    }
+
+    return false;
+}
+
+} //namespace common
\ No newline at end of file
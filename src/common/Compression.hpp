@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Types.hpp"
+#include <vector>
+#include <cstddef>
+
+
+namespace common {
+
+/*
+ * A small LZ77 block compressor, meant for things like save states that are
+ * mostly runs of zeroes and repeated data. Each sequence is a run of literal
+ * bytes followed by a copy from up to 64 KiB back, the same way LZ4 lays out
+ * its blocks. The decompressed size isn't stored, so it has to be kept next
+ * to the compressed data.
+ */
+void compress(const u8 *data, size_t size, std::vector<u8> &output);
+auto decompress(const u8 *data, size_t size, u8 *output, size_t output_size) -> bool;
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Types.hpp"
+#include "Bits.hpp"
+#include <cstring>
+#include <cstddef>
+
+
+namespace common {
+
+//Keeps one dirty bit per block of a memory region, used to find out which
+//parts of a region have been written to since the last time it was cleared.
+template<size_t _region_size, size_t _block_size>
+class DirtyTracker {
+public:
+
+    static_assert((_block_size & (_block_size - 1)) == 0, "DirtyTracker block size must be a power of two!");
+    static_assert(_region_size % _block_size == 0);
+
+    static constexpr size_t BLOCK_SIZE = _block_size;
+    static constexpr size_t NUM_BLOCKS = _region_size / _block_size;
+
+    DirtyTracker() {
+        clear();
+    }
+
+    inline void mark(size_t offset) {
+        const size_t block = offset / _block_size;
+        dirty[block >> 6] |= static_cast<u64>(1) << (block & 63);
+    }
+
+    inline void markRange(size_t offset, size_t size) {
+        for(size_t block = offset / _block_size; block <= (offset + size - 1) / _block_size; block++) {
+            dirty[block >> 6] |= static_cast<u64>(1) << (block & 63);
+        }
+    }
+
+    inline void markAll() {
+        std::memset(dirty, 0xFF, sizeof(dirty));
+    }
+
+    inline auto isDirty(size_t block) const -> bool {
+        return (dirty[block >> 6] >> (block & 63)) & 1;
+    }
+
+    inline auto any() const -> bool {
+        for(size_t i = 0; i < WORDS; i++) {
+            if(dirty[i] != 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline void clear() {
+        std::memset(dirty, 0, sizeof(dirty));
+    }
+
+    //One bit per block, lowest block in the lowest bit
+    inline auto data() const -> const u64* {
+        return dirty;
+    }
+
+    inline auto data() -> u64* {
+        return dirty;
+    }
+
+    //Calls func(block) for every dirty block in ascending order.
+    template<typename Func>
+    inline void forEach(Func &&func) const {
+        for(size_t i = 0; i < WORDS; i++) {
+            u64 word = dirty[i];
+
+            while(word != 0) {
+                const size_t block = i * 64 + bits::ctz(word);
+                word &= word - 1;
+
+                if(block < NUM_BLOCKS) {
+                    func(block);
+                }
+            }
+        }
+    }
+
+private:
+
+    static constexpr size_t WORDS = (NUM_BLOCKS + 63) / 64;
+    u64 dirty[WORDS];
+};
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "Hash.hpp"
+#include "Bits.hpp"
+#include <cstring>
+
+constexpr u64 PRIME1 = 0x9E3779B185EBCA87;
+constexpr u64 PRIME2 = 0xC2B2AE3D27D4EB4F;
+constexpr u64 PRIME3 = 0x165667B19E3779F9;
+constexpr u64 PRIME4 = 0x85EBCA77C2B2AE63;
+constexpr u64 PRIME5 = 0x27D4EB2F165667C5;
+
+
+namespace common {
+
+static inline auto rotl(u64 value, int rotate) -> u64 {
+    return (value << rotate) | (value >> (64 - rotate));
+}
+
+static inline auto read64(const u8 *data) -> u64 {
+    u64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return bits::to_le(value);
+}
+
+static inline auto read32(const u8 *data) -> u32 {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return bits::to_le(value);
+}
+
+static inline auto round(u64 accumulator, u64 input) -> u64 {
+    accumulator += input * PRIME2;
+    return rotl(accumulator, 31) * PRIME1;
+}
+
+static inline auto merge(u64 hash, u64 accumulator) -> u64 {
+    hash ^= round(0, accumulator);
+    return hash * PRIME1 + PRIME4;
+}
+
+auto hash64(const void *data, size_t size, u64 seed) -> u64 {
+    const u8 *bytes = reinterpret_cast<const u8*>(data);
+    const u8 *end = bytes + size;
+    u64 hash;
+
+    //Four lanes over 32 bytes at a time
+    if(size >= 32) {
+        u64 v1 = seed + PRIME1 + PRIME2;
+        u64 v2 = seed + PRIME2;
+        u64 v3 = seed;
+        u64 v4 = seed - PRIME1;
+
+        do {
+            v1 = round(v1, read64(bytes));
+            v2 = round(v2, read64(bytes + 8));
+            v3 = round(v3, read64(bytes + 16));
+            v4 = round(v4, read64(bytes + 24));
+            bytes += 32;
+        } while(end - bytes >= 32);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = merge(hash, v1);
+        hash = merge(hash, v2);
+        hash = merge(hash, v3);
+        hash = merge(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    hash += size;
+
+    while(end - bytes >= 8) {
+        hash ^= round(0, read64(bytes));
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+        bytes += 8;
+    }
+
+    if(end - bytes >= 4) {
+        hash ^= read32(bytes) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        bytes += 4;
+    }
+
+    while(bytes < end) {
+        hash ^= *bytes * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+        bytes++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Types.hpp"
+#include <cstddef>
+
+
+namespace common {
+
+/*
+ * 64-bit xxHash (XXH64). Fast enough to run over all of a core's memory every
+ * frame, and gives the same result on every host, so hashes can be compared
+ * between builds and machines.
+ */
+auto hash64(const void *data, size_t size, u64 seed = 0) -> u64;
+
+} //namespace common
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "Log.hpp"
+#include "Buffer.hpp"
+#include <condition_variable>
+#include <fstream>
+#include <thread>
+#include <mutex>
 #include <chrono>
+#include <cstdio>
 
 
 namespace common {
@@ -7,30 +13,176 @@ namespace common {
 namespace log {
 
 //Default to all log levels
-static u8 s_log_filter = 0xFF;
+u8 s_log_filter = 0xFF;
 
+//Set once the sink is gone at exit, anything logged after that is printed straight away
+static bool s_sink_destroyed = false;
+
+struct Message {
+    LogLevel level;
+    std::string text;
+};
+
+static auto levelTag(LogLevel level) -> const char* {
+    switch(level) {
+        case LEVEL_DEBUG :   return "[D]";
+        case LEVEL_TRACE :   return "[T]";
+        case LEVEL_INFO :    return "[I]";
+        case LEVEL_WARNING : return "[W]";
+        case LEVEL_ERROR :   return "[E]";
+        case LEVEL_FATAL :   return "[F]";
+    }
+
+    return "[?]";
+}
+
+static auto levelColor(LogLevel level) -> const char* {
+    switch(level) {
+        case LEVEL_DEBUG :   return "34m";
+        case LEVEL_TRACE :   return "35m";
+        case LEVEL_INFO :    return "32m";
+        case LEVEL_WARNING : return "33m";
+        case LEVEL_ERROR :   return "91m";
+        case LEVEL_FATAL :   return "31m";
+    }
+
+    return "39m";
+}
+
+static void print(const Message &message) {
+    fmt::print("\33[{}{} {}\33[39m\n", levelColor(message.level), levelTag(message.level), message.text);
+}
+
+/*
+ * Messages are queued by whichever thread logs them and written out by a
+ * background thread, so logging never waits on the terminal or a file. The
+ * queue is lock-free, a thread only has to wait if it fills up.
+ */
+class Sink final {
+public:
+
+    Sink() {
+        thread = std::thread([this]() { drain(); });
+    }
+
+    ~Sink() {
+        {
+            std::lock_guard lock(mutex);
+            running = false;
+        }
+
+        wake.notify_one();
+        thread.join();
+        s_sink_destroyed = true;
+    }
+
+    void push(Message &&message) {
+        while(!queue.push(std::move(message))) {
+            wake.notify_one();
+            std::this_thread::yield();
+        }
+
+        pushed.fetch_add(1, std::memory_order_release);
+    }
+
+    //Waits until everything logged so far has been written
+    void flush() {
+        const size_t target = pushed.load(std::memory_order_acquire);
+        std::unique_lock lock(mutex);
+
+        wake.notify_one();
+        flushed.wait(lock, [this, target]() { return written >= target; });
+    }
+
+    auto setFile(const std::string &path) -> bool {
+        std::lock_guard lock(mutex);
+        file.close();
+
+        if(path.empty()) {
+            return true;
+        }
+
+        file.open(path);
+        return file.is_open();
+    }
+
+private:
+
+    void drain() {
+        std::unique_lock lock(mutex);
+        Message message;
+
+        while(true) {
+            while(queue.pop(message)) {
+                print(message);
+
+                if(file.is_open()) {
+                    file << levelTag(message.level) << ' ' << message.text << '\n';
+                }
+
+                written++;
+            }
+
+            std::fflush(stdout);
+            file.flush();
+            flushed.notify_all();
+
+            if(!running) {
+                break;
+            }
+
+            wake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+
+    MPSCRingBuffer<Message, 1024> queue;
+    std::atomic<size_t> pushed = 0;
+
+    //Only used by the background thread, and while changing the file
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::ofstream file;
+    size_t written = 0;
+    bool running = true;
+    std::thread thread;
+};
+
+static auto sink() -> Sink& {
+    static Sink instance;
+    return instance;
+}
 
 void set_log_filter(u8 filter) {
     s_log_filter = filter;
 }
 
-void log(const std::string &message, LogLevel level) {
+auto set_log_file(const std::string &path) -> bool {
+    return sink().setFile(path);
+}
+
+void flush() {
+    if(!s_sink_destroyed) {
+        sink().flush();
+    }
+}
+
+void log(std::string message, LogLevel level) {
     if((s_log_filter & level) == 0) {
         return;
     }
 
-    std::string prefix = "\33[";
-
-    switch(level) {
-        case LEVEL_DEBUG :   prefix += "34m[D]"; break;
-        case LEVEL_TRACE :   prefix += "35m[T]"; break;
-        case LEVEL_INFO :    prefix += "32m[I]"; break;
-        case LEVEL_WARNING : prefix += "33m[W]"; break;
-        case LEVEL_ERROR :   prefix += "91m[E]"; break;
-        case LEVEL_FATAL :   prefix += "31m[F]"; break;
+    if(s_sink_destroyed) {
+        print(Message{level, std::move(message)});
+        return;
     }
 
-    fmt::print("{} {}\33[39m\n", prefix, message);
+    sink().push(Message{level, std::move(message)});
+
+    //Nothing after a fatal message gets a chance to run
+    if(level == LEVEL_FATAL) {
+        sink().flush();
+    }
 }
 
 void log_debug(const std::string &message, LogLevel level, const char *file, const char *func, int line) {
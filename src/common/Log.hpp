@@ -9,6 +9,12 @@
 #include "common/Types.hpp"
 #include <fmt/format.h>
 
+//Least severe level that's compiled in at all, from 0 for trace up to 4 for
+//error. Set with the LOG_LEVEL CMake option, everything is kept by default.
+#ifndef LOG_MIN_LEVEL
+    #define LOG_MIN_LEVEL 0
+#endif
+
 
 namespace common {
 
@@ -23,14 +29,53 @@ enum LogLevel : u8 {
     LEVEL_FATAL   = 0x20
 };
 
+extern u8 s_log_filter;
+
 void set_log_filter(u8 filter);
-void log(const std::string &message, LogLevel level);
+auto set_log_file(const std::string &path) -> bool;
+void flush();
+void log(std::string message, LogLevel level);
 void log_debug(const std::string &message, LogLevel level, const char *file, const char *func, int line);
 
+constexpr auto severity(LogLevel level) -> int {
+    switch(level) {
+        case LEVEL_TRACE :   return 0;
+        case LEVEL_DEBUG :   return 1;
+        case LEVEL_INFO :    return 2;
+        case LEVEL_WARNING : return 3;
+        case LEVEL_ERROR :   return 4;
+        case LEVEL_FATAL :   return 5;
+    }
+
+    return 5;
+}
+
+//Fatal messages are always kept, since the program exits after them
+constexpr auto compiled_in(LogLevel level) -> bool {
+    return level == LEVEL_FATAL || severity(level) >= LOG_MIN_LEVEL;
+}
+
+inline auto enabled(LogLevel level) -> bool {
+    return (s_log_filter & level) != 0;
+}
+
 } //namespace log
 
-#define LOG_MESSAGE(level, message, ...) common::log::log(fmt::format(message, ##__VA_ARGS__), level)
-#define DEBUG_LOG(level, message, ...) common::log::log_debug(fmt::format(message, ##__VA_ARGS__), level, __FILE__, __func__, __LINE__)
+//Messages are only formatted when they'll actually be logged, and not compiled at all below LOG_MIN_LEVEL
+#define LOG_MESSAGE(level, message, ...) do { \
+    if constexpr(common::log::compiled_in(level)) { \
+        if(common::log::enabled(level)) { \
+            common::log::log(fmt::format(message, ##__VA_ARGS__), level); \
+        } \
+    } \
+} while(0)
+#define DEBUG_LOG(level, message, ...) do { \
+    if constexpr(common::log::compiled_in(level)) { \
+        if(common::log::enabled(level)) { \
+            common::log::log_debug(fmt::format(message, ##__VA_ARGS__), level, __FILE__, __func__, __LINE__); \
+        } \
+    } \
+} while(0)
 
 #define LOG_DEBUG(message, ...)     LOG_MESSAGE(common::log::LEVEL_DEBUG, message, ##__VA_ARGS__)
 #define LOGD_DEBUG(message, ...)    DEBUG_LOG(common::log::LEVEL_DEBUG, message, ##__VA_ARGS__)
@@ -42,8 +87,8 @@ void log_debug(const std::string &message, LogLevel level, const char *file, con
 #define LOGD_WARNING(message, ...)  DEBUG_LOG(common::log::LEVEL_WARNING, message, ##__VA_ARGS__)
 #define LOG_ERROR(message, ...)     LOG_MESSAGE(common::log::LEVEL_ERROR, message, ##__VA_ARGS__)
 #define LOGD_ERROR(message, ...)    DEBUG_LOG(common::log::LEVEL_ERROR, message, ##__VA_ARGS__)
-#define LOG_FATAL(message, ...)     LOG_MESSAGE(common::log::LEVEL_FATAL, message, ##__VA_ARGS__); std::exit(-1)
-#define LOGD_FATAL(message, ...)    DEBUG_LOG(common::log::LEVEL_FATAL, message, ##__VA_ARGS__); std::exit(-1)
+#define LOG_FATAL(message, ...)     do { LOG_MESSAGE(common::log::LEVEL_FATAL, message, ##__VA_ARGS__); std::exit(-1); } while(0)
+#define LOGD_FATAL(message, ...)    do { DEBUG_LOG(common::log::LEVEL_FATAL, message, ##__VA_ARGS__); std::exit(-1); } while(0)
 
 } //namespace common
 
@@ -0,0 +1,109 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace common {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+auto MappedFile::open(const std::string &path) -> bool {
+    close();
+
+    #ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(file_mapping == nullptr) {
+        close();
+        return false;
+    }
+
+    mapping = reinterpret_cast<const u8*>(MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0));
+    if(mapping == nullptr) {
+        close();
+        return false;
+    }
+
+    length = static_cast<size_t>(file_size.QuadPart);
+    #else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    //Empty files can't be mapped
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if(view == MAP_FAILED) {
+        return false;
+    }
+
+    mapping = reinterpret_cast<const u8*>(view);
+    length = static_cast<size_t>(info.st_size);
+    #endif
+
+    return true;
+}
+
+void MappedFile::close() {
+    #ifdef _WIN32
+    if(mapping != nullptr) {
+        UnmapViewOfFile(mapping);
+    }
+    if(file_mapping != nullptr) {
+        CloseHandle(file_mapping);
+    }
+    if(file != nullptr) {
+        CloseHandle(file);
+    }
+
+    file_mapping = nullptr;
+    file = nullptr;
+    #else
+    if(mapping != nullptr) {
+        munmap(const_cast<u8*>(mapping), length);
+    }
+    #endif
+
+    mapping = nullptr;
+    length = 0;
+}
+
+auto MappedFile::data() const -> const u8* {
+    return mapping;
+}
+
+auto MappedFile::size() const -> size_t {
+    return length;
+}
+
+} //namespace common
\ No newline at end of file
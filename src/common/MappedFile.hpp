@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Types.hpp"
+#include <string>
+#include <cstddef>
+
+
+namespace common {
+
+/*
+ * A read-only view of a whole file mapped into memory, so large files like
+ * save states can be read in place without being copied into a buffer first.
+ */
+class MappedFile final {
+public:
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    auto open(const std::string &path) -> bool;
+    void close();
+
+    auto data() const -> const u8*;
+    auto size() const -> size_t;
+
+private:
+
+    const u8 *mapping = nullptr;
+    size_t length = 0;
+
+    #ifdef _WIN32
+    void *file = nullptr;
+    void *file_mapping = nullptr;
+    #endif
+};
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Types.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace common {
+
+/*
+ * Windowed-sinc resampler for interleaved stereo samples. The filter is
+ * precomputed for a fixed number of sub-sample phases whenever the rates
+ * change, so resampling itself only does the convolution and never allocates.
+ * The position between input samples is kept as 32.32 fixed point, so the
+ * number of input samples needed for a block of output is always exact.
+ */
+class Resampler {
+public:
+
+    static constexpr size_t TAPS = 32;
+    static constexpr size_t PHASE_BITS = 8;
+    static constexpr size_t PHASES = 1 << PHASE_BITS;
+
+    Resampler() {
+        setRates(1.0, 1.0);
+        reset();
+    }
+
+    void reset() {
+        std::memset(history, 0, sizeof(history));
+        history_index = 0;
+        position = 0;
+    }
+
+    void setRates(double input_rate, double output_rate) {
+        base_ratio = input_rate / output_rate;
+
+        //Lower the cutoff when downsampling so frequencies above the new
+        //Nyquist limit are removed instead of aliased, with some headroom
+        //for the window's transition band
+        const double cutoff = std::min(1.0, output_rate / input_rate) * 0.9;
+        const double pi = 3.14159265358979323846;
+
+        for(size_t phase = 0; phase < PHASES; phase++) {
+            const double fraction = phase / static_cast<double>(PHASES);
+            float *kernel = &table[phase * TAPS];
+            double sum = 0;
+
+            for(size_t i = 0; i < TAPS; i++) {
+                //Distance from the point between the two middle taps being sampled
+                const double x = static_cast<double>(i) - (TAPS / 2 - 1) - fraction;
+                const double sinc = x == 0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+
+                //Blackman window across all of the taps
+                const double w = (i + 1 - fraction) / TAPS;
+                const double window = 0.42 - 0.5 * std::cos(2 * pi * w) + 0.08 * std::cos(4 * pi * w);
+
+                kernel[i] = static_cast<float>(sinc * window);
+                sum += kernel[i];
+            }
+
+            //Normalize so every phase has the same gain
+            for(size_t i = 0; i < TAPS; i++) {
+                kernel[i] = static_cast<float>(kernel[i] / sum);
+            }
+        }
+
+        setRatioAdjust(1.0);
+    }
+
+    //Scales the ratio slightly without rebuilding the filter, used for rate control
+    void setRatioAdjust(double adjust) {
+        step = static_cast<u64>(base_ratio * adjust * ONE);
+    }
+
+    //Number of input frames process() consumes for this many output frames
+    auto inputNeeded(size_t output_count) const -> size_t {
+        return (position + step * output_count) >> 32;
+    }
+
+    //input has to hold at least inputNeeded(output_count) frames
+    void process(const float *input, float *output, size_t output_count) {
+        for(size_t i = 0; i < output_count; i++) {
+            const float *kernel = &table[(position >> (32 - PHASE_BITS)) * TAPS];
+            const float *frames = &history[history_index * 2];
+            float left = 0, right = 0;
+
+            for(size_t j = 0; j < TAPS; j++) {
+                left += frames[j * 2 + 0] * kernel[j];
+                right += frames[j * 2 + 1] * kernel[j];
+            }
+
+            output[i * 2 + 0] = left;
+            output[i * 2 + 1] = right;
+
+            position += step;
+            while(position >= ONE) {
+                pushFrame(input[0], input[1]);
+                input += 2;
+                position -= ONE;
+            }
+        }
+    }
+
+private:
+
+    static constexpr u64 ONE = static_cast<u64>(1) << 32;
+
+    //Every frame is stored twice so the last TAPS frames are always contiguous
+    inline void pushFrame(float left, float right) {
+        history[history_index * 2 + 0] = left;
+        history[history_index * 2 + 1] = right;
+        history[(history_index + TAPS) * 2 + 0] = left;
+        history[(history_index + TAPS) * 2 + 1] = right;
+        history_index = (history_index + 1) % TAPS;
+    }
+
+    float table[PHASES * TAPS];
+    float history[TAPS * 2 * 2];
+    size_t history_index;
+    double base_ratio;
+    u64 step;
+    u64 position;
+};
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "RewindBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+namespace common {
+
+static inline auto isZeroWord(const u8 *data) -> bool {
+    u64 word;
+    std::memcpy(&word, data, sizeof(word));
+    return word == 0;
+}
+
+static inline void writeVarint(std::vector<u8> &output, size_t value) {
+    while(value >= 0x80) {
+        output.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    output.push_back(value);
+}
+
+static inline auto readVarint(const u8 *&data, const u8 *end) -> size_t {
+    size_t value = 0;
+
+    for(int shift = 0; data < end; shift += 7) {
+        u8 byte = *data++;
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0) {
+            break;
+        }
+    }
+
+    return value;
+}
+
+RewindBuffer::RewindBuffer(size_t capacity) {
+    setCapacity(capacity);
+}
+
+void RewindBuffer::setCapacity(size_t capacity) {
+    ring.assign(capacity, 0);
+    ring.shrink_to_fit();
+    clear();
+}
+
+void RewindBuffer::clear() {
+    deltas.clear();
+    current.clear();
+    head = 0;
+    current_is_capture = false;
+}
+
+void RewindBuffer::push(const std::vector<u8> &state) {
+    whole.assign(1, IncrementalSerializer::Range{0, std::max(state.size(), current.size())});
+    push(state, whole);
+    current_is_capture = false;
+}
+
+//Every capture has to be pushed for the changes to line up with the last one
+void RewindBuffer::push(const IncrementalSerializer &capture) {
+    const std::vector<u8> &state = capture.getBuffer();
+
+    if(current_is_capture) {
+        push(state, capture.getChanged());
+    } else {
+        whole.assign(1, IncrementalSerializer::Range{0, std::max(state.size(), current.size())});
+        push(state, whole);
+    }
+
+    current_is_capture = true;
+}
+
+void RewindBuffer::push(const std::vector<u8> &state, const std::vector<IncrementalSerializer::Range> &changed) {
+    if(!current.empty() && !ring.empty()) {
+        encode(state, changed);
+
+        //Older deltas are useless without this one
+        if(!allocate(std::max<size_t>(encoded.size(), 1))) {
+            deltas.clear();
+            head = 0;
+        } else {
+            std::copy(encoded.begin(), encoded.end(), ring.begin() + head);
+            deltas.push_back(Delta{head, encoded.size(), current.size()});
+            head += std::max<size_t>(encoded.size(), 1);
+        }
+
+        //Nothing outside of what was compared can be different
+        if(state.size() == current.size()) {
+            for(const auto &range : compare) {
+                std::copy(state.begin() + range.offset, state.begin() + range.offset + range.size, current.begin() + range.offset);
+            }
+
+            return;
+        }
+    }
+
+    current = state;
+}
+
+//Steps back to the state before the newest one, which becomes the newest
+auto RewindBuffer::pop(std::vector<u8> &state) -> bool {
+    if(deltas.empty()) {
+        return false;
+    }
+
+    const Delta &delta = deltas.back();
+    decode(delta);
+    head = delta.offset;
+    deltas.pop_back();
+    current_is_capture = false;
+
+    state = current;
+    return true;
+}
+
+//Number of steps that can be taken back
+auto RewindBuffer::size() const -> size_t {
+    return deltas.size();
+}
+
+auto RewindBuffer::memoryUsed() const -> size_t {
+    size_t used = current.size();
+
+    for(const auto &delta : deltas) {
+        used += delta.size;
+    }
+
+    return used;
+}
+
+//Stores the difference between the new state and the current one as alternating
+//runs of unchanged and changed bytes. Only the given ranges are compared, and
+//trailing unchanged bytes are left out.
+void RewindBuffer::encode(const std::vector<u8> &state, const std::vector<IncrementalSerializer::Range> &changed) {
+    const size_t length = std::max(state.size(), current.size());
+    const size_t common_length = std::min(state.size(), current.size());
+    const std::vector<u8> &longer = state.size() > current.size() ? state : current;
+    scratch.resize(length);
+
+    //Anything past the end of the shorter state counts as changed
+    compare.clear();
+    for(const auto &range : changed) {
+        if(range.offset < common_length) {
+            compare.push_back(IncrementalSerializer::Range{range.offset, std::min(range.size, common_length - range.offset)});
+        }
+    }
+    if(length > common_length) {
+        compare.push_back(IncrementalSerializer::Range{common_length, length - common_length});
+    }
+
+    encoded.clear();
+    const u8 *data = scratch.data();
+    size_t last_end = 0;
+
+    for(const auto &range : compare) {
+        const size_t end = range.offset + range.size;
+
+        if(range.offset < common_length) {
+            for(size_t i = range.offset; i < end; i++) {
+                scratch[i] = state[i] ^ current[i];
+            }
+        } else {
+            std::copy(longer.begin() + range.offset, longer.begin() + end, scratch.begin() + range.offset);
+        }
+
+        size_t i = std::max(range.offset, last_end);
+
+        while(i < end) {
+            while(i + sizeof(u64) <= end && isZeroWord(&data[i])) {
+                i += sizeof(u64);
+            }
+            while(i < end && data[i] == 0) {
+                i++;
+            }
+
+            if(i == end) {
+                break;
+            }
+
+            //Changed runs only end at 8 unchanged bytes, shorter gaps cost less to store than to skip
+            size_t start = i;
+
+            while(i < end && !(i + sizeof(u64) <= end && isZeroWord(&data[i]))) {
+                i++;
+            }
+
+            writeVarint(encoded, start - last_end);
+            writeVarint(encoded, i - start);
+            encoded.insert(encoded.end(), &data[start], &data[i]);
+            last_end = i;
+        }
+    }
+}
+
+void RewindBuffer::decode(const Delta &delta) {
+    const u8 *data = &ring[delta.offset];
+    const u8 *end = data + delta.size;
+    const size_t length = std::max(current.size(), delta.length);
+    current.resize(length, 0);
+
+    size_t position = 0;
+
+    while(data < end) {
+        position += readVarint(data, end);
+        size_t changed = std::min(readVarint(data, end), static_cast<size_t>(end - data));
+        changed = std::min(changed, length - std::min(position, length));
+
+        for(size_t i = 0; i < changed; i++) {
+            current[position + i] ^= data[i];
+        }
+
+        data += changed;
+        position += changed;
+    }
+
+    current.resize(delta.length);
+}
+
+//Finds space for a delta at head, dropping the oldest ones until there's room
+auto RewindBuffer::allocate(size_t size) -> bool {
+    if(size > ring.size()) {
+        return false;
+    }
+
+    while(!deltas.empty()) {
+        const size_t tail = deltas.front().offset;
+
+        if(tail < head) {
+            if(ring.size() - head >= size) {
+                return true;
+            }
+
+            if(tail >= size) {
+                head = 0;
+                return true;
+            }
+        } else if(tail - head >= size) {
+            return true;
+        }
+
+        deltas.pop_front();
+    }
+
+    if(ring.size() - head < size) {
+        head = 0;
+    }
+
+    return true;
+}
+
+} //namespace common
\ No newline at end of file
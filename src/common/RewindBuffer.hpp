@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Types.hpp"
+#include "Serializer.hpp"
+#include <vector>
+#include <deque>
+#include <cstddef>
+
+
+namespace common {
+
+/*
+ * Keeps a history of save states within a fixed amount of memory. Only the
+ * newest state is kept whole; every older one is stored as the XOR of it and
+ * the state after it, with runs of zero bytes (anything that didn't change)
+ * left out. Stepping back undoes one delta at a time, and the oldest deltas
+ * are dropped once the ring is full. States from an incremental capture only
+ * have the parts that might have changed compared.
+ */
+class RewindBuffer final {
+public:
+
+    explicit RewindBuffer(size_t capacity = 0);
+
+    void setCapacity(size_t capacity);
+    void clear();
+    void push(const std::vector<u8> &state);
+    void push(const IncrementalSerializer &capture);
+    auto pop(std::vector<u8> &state) -> bool;
+
+    auto size() const -> size_t;
+    auto memoryUsed() const -> size_t;
+
+private:
+
+    struct Delta {
+        size_t offset;
+        size_t size;
+        size_t length; //Size of the state this delta gives back
+    };
+
+    void push(const std::vector<u8> &state, const std::vector<IncrementalSerializer::Range> &changed);
+    void encode(const std::vector<u8> &state, const std::vector<IncrementalSerializer::Range> &changed);
+    void decode(const Delta &delta);
+    auto allocate(size_t size) -> bool;
+
+    std::vector<u8> ring;
+    std::deque<Delta> deltas;
+    size_t head;
+
+    std::vector<u8> current;
+    std::vector<u8> scratch;
+    std::vector<u8> encoded;
+    std::vector<IncrementalSerializer::Range> whole;
+    std::vector<IncrementalSerializer::Range> compare;
+
+    //Set when current is the last capture pushed, so only its changes need comparing
+    bool current_is_capture;
+};
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,510 @@
+#pragma once
+
+#include "Types.hpp"
+#include "Bits.hpp"
+#include "DirtyTracker.hpp"
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+
+namespace common {
+
+/*
+ * Destination for save state data. Components only write raw bytes, so the
+ * same serialize functions can fill a file or a buffer in memory. Numbers are
+ * always stored little-endian and bools as a single byte, so states don't
+ * depend on the host or on how structs are laid out.
+ */
+class Serializer {
+public:
+
+    virtual ~Serializer() = default;
+
+    virtual void write(const void *data, size_t size) = 0;
+
+    template<typename T>
+    void write(const T &value) {
+        if constexpr(std::is_array_v<T>) {
+            using Element = std::remove_all_extents_t<T>;
+
+            if constexpr(std::is_same_v<Element, u8> || std::is_same_v<Element, s8>) {
+                write(&value, sizeof(T));
+            } else {
+                for(const auto &element : value) {
+                    write(element);
+                }
+            }
+        } else if constexpr(std::is_enum_v<T>) {
+            write(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr(std::is_same_v<T, bool>) {
+            write(static_cast<u8>(value));
+        } else {
+            static_assert(std::is_integral_v<T>, "Only fixed-width numbers go in save states");
+            const T stored = bits::to_le(value);
+            write(&stored, sizeof(T));
+        }
+    }
+
+    //A chunk is an ID and the length of everything written until it ends, so readers can skip it
+    void beginChunk(u32 id) {
+        write(id);
+        chunks.push_back(tell());
+        write(static_cast<u32>(0));
+    }
+
+    void endChunk() {
+        const size_t start = chunks.back();
+        chunks.pop_back();
+
+        const u32 length = bits::to_le(static_cast<u32>(tell() - start - sizeof(u32)));
+        overwrite(start, &length, sizeof(length));
+    }
+
+    //Same as writing the whole block, but lets incremental captures skip pages that weren't written
+    virtual void writePages(const u8 *data, size_t size, size_t, const u64*) {
+        write(data, size);
+    }
+
+    template<size_t size, size_t page_size>
+    void writePages(const u8 (&data)[size], const DirtyTracker<size, page_size> &pages) {
+        writePages(data, size, page_size, pages.data());
+    }
+
+protected:
+
+    //Bytes written so far, and a way to go back and fill in a chunk's length
+    //once it's known. Only bytes written in the same state are overwritten.
+    virtual auto tell() const -> size_t = 0;
+    virtual void overwrite(size_t offset, const void *data, size_t size) = 0;
+
+private:
+
+    std::vector<size_t> chunks;
+};
+
+/*
+ * Source for save state data. Reading past the end, or past the end of the
+ * current chunk, fills the rest with zeroes and marks the deserializer as
+ * failed instead of reading out of bounds.
+ */
+class Deserializer {
+public:
+
+    virtual ~Deserializer() = default;
+
+    void read(void *data, size_t size) {
+        if(!claim(size)) {
+            std::memset(data, 0, size);
+            return;
+        }
+
+        readBytes(data, size);
+    }
+
+    template<typename T>
+    void read(T &value) {
+        if constexpr(std::is_array_v<T>) {
+            using Element = std::remove_all_extents_t<T>;
+
+            if constexpr(std::is_same_v<Element, u8> || std::is_same_v<Element, s8>) {
+                read(&value, sizeof(T));
+            } else {
+                for(auto &element : value) {
+                    read(element);
+                }
+            }
+        } else if constexpr(std::is_enum_v<T>) {
+            std::underlying_type_t<T> stored = 0;
+            read(stored);
+            value = static_cast<T>(stored);
+        } else if constexpr(std::is_same_v<T, bool>) {
+            u8 stored = 0;
+            read(stored);
+            value = stored != 0;
+        } else {
+            static_assert(std::is_integral_v<T>, "Only fixed-width numbers go in save states");
+            T stored = 0;
+            read(&stored, sizeof(T));
+            value = bits::to_le(stored);
+        }
+    }
+
+    void skip(size_t size) {
+        if(claim(size)) {
+            skipBytes(size);
+        }
+    }
+
+    //Moves into the next chunk, returns false when there are none left in the state or the enclosing chunk
+    auto beginChunk(u32 &id) -> bool {
+        if(failed || (chunks.empty() ? atEnd() : position >= chunks.back())) {
+            return false;
+        }
+
+        u32 length = 0;
+        read(id);
+        read(length);
+
+        if(failed) {
+            return false;
+        }
+
+        chunks.push_back(position + length);
+        return true;
+    }
+
+    //Skips whatever wasn't read, like fields added to the chunk by a newer version
+    void endChunk() {
+        const size_t end = chunks.back();
+        chunks.pop_back();
+
+        if(position < end) {
+            skip(end - position);
+        }
+    }
+
+    //Bytes left in the current chunk, so fields added later can be read only when they're there
+    auto remaining() const -> size_t {
+        return chunks.empty() ? 0 : chunks.back() - position;
+    }
+
+    //Same as reading the whole block, but only marks the pages that end up different
+    virtual void readPages(u8 *data, size_t size, size_t page_size, u64 *dirty) {
+        std::vector<u8> page(page_size);
+
+        for(size_t offset = 0; offset < size; offset += page_size) {
+            const size_t length = std::min(page_size, size - offset);
+            read(page.data(), length);
+
+            if(std::memcmp(&data[offset], page.data(), length) != 0) {
+                std::memcpy(&data[offset], page.data(), length);
+                markPage(dirty, offset / page_size);
+            }
+        }
+    }
+
+    template<size_t size, size_t page_size>
+    void readPages(u8 (&data)[size], DirtyTracker<size, page_size> &pages) {
+        readPages(data, size, page_size, pages.data());
+    }
+
+    auto good() const -> bool {
+        return !failed;
+    }
+
+protected:
+
+    virtual void readBytes(void *data, size_t size) = 0;
+    virtual void skipBytes(size_t size) = 0;
+    virtual auto atEnd() -> bool = 0;
+
+    //Counts bytes as read, failing instead if they go past the end of the current chunk
+    auto claim(size_t size) -> bool {
+        if(!chunks.empty() && size > chunks.back() - position) {
+            failed = true;
+            return false;
+        }
+
+        position += size;
+        return true;
+    }
+
+    static void markPage(u64 *dirty, size_t page) {
+        dirty[page >> 6] |= static_cast<u64>(1) << (page & 63);
+    }
+
+    bool failed = false;
+
+private:
+
+    std::vector<size_t> chunks; //Where each chunk that's been entered ends
+    size_t position = 0;
+};
+
+//Appends to a vector, which keeps its capacity between states.
+class MemorySerializer final : public Serializer {
+public:
+
+    explicit MemorySerializer(std::vector<u8> &buffer) : buffer(buffer), start(buffer.size()) { }
+
+    using Serializer::write;
+
+    void write(const void *data, size_t size) override {
+        const u8 *bytes = reinterpret_cast<const u8*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+protected:
+
+    auto tell() const -> size_t override {
+        return buffer.size() - start;
+    }
+
+    void overwrite(size_t offset, const void *data, size_t size) override {
+        std::memcpy(&buffer[start + offset], data, size);
+    }
+
+private:
+
+    std::vector<u8> &buffer;
+    size_t start;
+};
+
+class MemoryDeserializer final : public Deserializer {
+public:
+
+    MemoryDeserializer(const u8 *data, size_t size) : data(data), size(size), offset(0) { }
+
+    using Deserializer::readPages;
+
+    //Compares straight from the source instead of going through a copy, so
+    //states in a mapped file only have the pages that differ touched at all
+    void readPages(u8 *dst, size_t count, size_t page_size, u64 *dirty) override {
+        if(count > size - offset) {
+            Deserializer::readPages(dst, count, page_size, dirty);
+            return;
+        }
+
+        if(!claim(count)) {
+            return;
+        }
+
+        for(size_t i = 0; i < count; i += page_size) {
+            const size_t length = std::min(page_size, count - i);
+
+            if(std::memcmp(&dst[i], &data[offset + i], length) != 0) {
+                std::memcpy(&dst[i], &data[offset + i], length);
+                markPage(dirty, i / page_size);
+            }
+        }
+
+        offset += count;
+    }
+
+    //Gives back where the block is in the source instead of copying it, or nullptr if it isn't all there
+    auto readInPlace(size_t count) -> const u8* {
+        if(count > size - offset) {
+            offset = size;
+            failed = true;
+            return nullptr;
+        }
+
+        if(!claim(count)) {
+            return nullptr;
+        }
+
+        const u8 *block = &data[offset];
+        offset += count;
+        return block;
+    }
+
+protected:
+
+    void readBytes(void *dst, size_t count) override {
+        if(count > size - offset) {
+            std::memset(dst, 0, count);
+            offset = size;
+            failed = true;
+            return;
+        }
+
+        std::memcpy(dst, &data[offset], count);
+        offset += count;
+    }
+
+    void skipBytes(size_t count) override {
+        if(count > size - offset) {
+            offset = size;
+            failed = true;
+            return;
+        }
+
+        offset += count;
+    }
+
+    auto atEnd() -> bool override {
+        return offset >= size;
+    }
+
+private:
+
+    const u8 *data;
+    size_t size;
+    size_t offset;
+};
+
+/*
+ * Captures states into the same buffer over and over. Blocks of pages that are
+ * in the same place as last time only have their written pages copied, and the
+ * parts of the buffer that may have changed are kept as sorted ranges.
+ */
+class IncrementalSerializer final : public Serializer {
+public:
+
+    struct Range {
+        size_t offset;
+        size_t size;
+    };
+
+    using Serializer::write;
+    using Serializer::writePages;
+
+    void begin() {
+        position = 0;
+        block = 0;
+        changed.clear();
+    }
+
+    void end() {
+        buffer.resize(position);
+        blocks.resize(block);
+    }
+
+    //Makes the next capture copy everything
+    void invalidate() {
+        blocks.clear();
+    }
+
+    void write(const void *data, size_t size) override {
+        if(position + size > buffer.size()) {
+            buffer.resize(position + size);
+        }
+
+        std::memcpy(&buffer[position], data, size);
+        markChanged(position, size);
+        position += size;
+    }
+
+    void writePages(const u8 *data, size_t size, size_t page_size, const u64 *dirty) override {
+        const bool in_place = block < blocks.size() && blocks[block].offset == position &&
+            blocks[block].size == size && position + size <= buffer.size();
+
+        if(block < blocks.size()) {
+            blocks[block] = Range{position, size};
+        } else {
+            blocks.push_back(Range{position, size});
+        }
+
+        block++;
+
+        if(!in_place) {
+            write(data, size);
+            return;
+        }
+
+        for(size_t offset = 0; offset < size; offset += page_size) {
+            const size_t page = offset / page_size;
+
+            if((dirty[page >> 6] >> (page & 63)) & 1) {
+                const size_t length = std::min(page_size, size - offset);
+                std::memcpy(&buffer[position + offset], &data[offset], length);
+                markChanged(position + offset, length);
+            }
+        }
+
+        position += size;
+    }
+
+    auto getBuffer() const -> const std::vector<u8>& {
+        return buffer;
+    }
+
+    auto getChanged() const -> const std::vector<Range>& {
+        return changed;
+    }
+
+protected:
+
+    auto tell() const -> size_t override {
+        return position;
+    }
+
+    //Already marked as changed, since the bytes were written earlier in the same capture
+    void overwrite(size_t offset, const void *data, size_t size) override {
+        std::memcpy(&buffer[offset], data, size);
+    }
+
+private:
+
+    void markChanged(size_t offset, size_t size) {
+        if(!changed.empty() && changed.back().offset + changed.back().size == offset) {
+            changed.back().size += size;
+        } else {
+            changed.push_back(Range{offset, size});
+        }
+    }
+
+    std::vector<u8> buffer;
+    std::vector<Range> blocks; //Where each block of pages was put last time
+    std::vector<Range> changed;
+    size_t position = 0;
+    size_t block = 0;
+};
+
+class FileSerializer final : public Serializer {
+public:
+
+    explicit FileSerializer(std::ofstream &file) : file(file), start(file.tellp()) { }
+
+    using Serializer::write;
+
+    void write(const void *data, size_t size) override {
+        file.write(reinterpret_cast<const char*>(data), size);
+    }
+
+protected:
+
+    auto tell() const -> size_t override {
+        return static_cast<size_t>(file.tellp() - start);
+    }
+
+    void overwrite(size_t offset, const void *data, size_t size) override {
+        const std::streampos end = file.tellp();
+        file.seekp(start + static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(data), size);
+        file.seekp(end);
+    }
+
+private:
+
+    std::ofstream &file;
+    std::streampos start;
+};
+
+class FileDeserializer final : public Deserializer {
+public:
+
+    explicit FileDeserializer(std::ifstream &file) : file(file) { }
+
+protected:
+
+    void readBytes(void *dst, size_t count) override {
+        file.read(reinterpret_cast<char*>(dst), count);
+
+        if(static_cast<size_t>(file.gcount()) != count) {
+            std::memset(reinterpret_cast<u8*>(dst) + file.gcount(), 0, count - file.gcount());
+            failed = true;
+        }
+    }
+
+    void skipBytes(size_t count) override {
+        file.ignore(count);
+
+        if(static_cast<size_t>(file.gcount()) != count) {
+            failed = true;
+        }
+    }
+
+    auto atEnd() -> bool override {
+        return file.peek() == std::ifstream::traits_type::eof();
+    }
+
+private:
+
+    std::ifstream &file;
+};
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "StatePack.hpp"
+#include "Serializer.hpp"
+#include "Compression.hpp"
+#include "Log.hpp"
+
+constexpr u32 PACKED_MAGIC = 0x5A414247; //'GBAZ' in little-endian
+constexpr u16 PACKED_VERSION = 0x1;
+constexpr u32 THUMBNAIL_CHUNK = 0x424D4854; //'THMB'
+constexpr u32 STATE_CHUNK = 0x54415453; //'STAT'
+constexpr u32 RAW_STATE_CHUNK = 0x53574152; //'RAWS'
+
+
+namespace common {
+
+void packState(const std::vector<u8> &state, const std::vector<u32> &frame, bool compress, std::vector<u8> &output) {
+    MemorySerializer serializer(output);
+    serializer.write(PACKED_MAGIC);
+    serializer.write(PACKED_VERSION);
+
+    if(frame.size() == FRAME_WIDTH * FRAME_HEIGHT) {
+        const std::vector<u32> thumbnail = makeThumbnail(frame.data());
+
+        serializer.beginChunk(THUMBNAIL_CHUNK);
+        serializer.write(static_cast<u16>(THUMBNAIL_WIDTH));
+        serializer.write(static_cast<u16>(THUMBNAIL_HEIGHT));
+
+        for(u32 pixel : thumbnail) {
+            serializer.write(pixel);
+        }
+
+        serializer.endChunk();
+    }
+
+    if(!compress) {
+        serializer.beginChunk(RAW_STATE_CHUNK);
+        serializer.write(static_cast<u32>(state.size()));
+        serializer.write(state.data(), state.size());
+        serializer.endChunk();
+        return;
+    }
+
+    std::vector<u8> compressed;
+    common::compress(state.data(), state.size(), compressed);
+
+    serializer.beginChunk(STATE_CHUNK);
+    serializer.write(static_cast<u32>(state.size()));
+    serializer.write(compressed.data(), compressed.size());
+    serializer.endChunk();
+}
+
+auto isPackedState(const u8 *data, size_t size) -> bool {
+    MemoryDeserializer deserializer(data, size);
+    u32 magic = 0;
+    deserializer.read(magic);
+
+    return deserializer.good() && magic == PACKED_MAGIC;
+}
+
+auto unpackState(const u8 *data, size_t size, std::vector<u8> &buffer, const u8 *&state, size_t &state_size) -> bool {
+    MemoryDeserializer deserializer(data, size);
+    u32 magic = 0;
+    u16 version = 0;
+    deserializer.read(magic);
+    deserializer.read(version);
+
+    if(magic != PACKED_MAGIC || version != PACKED_VERSION) {
+        LOG_ERROR("Incorrect magic ({:08X}) or version ({:04X}) for packed save state!", magic, version);
+        return false;
+    }
+
+    bool found = false;
+    u32 id = 0;
+
+    while(deserializer.beginChunk(id)) {
+        if(id == STATE_CHUNK || id == RAW_STATE_CHUNK) {
+            u32 stored_size = 0;
+            deserializer.read(stored_size);
+
+            //The size comes from the file, so it's checked before anything is allocated for it
+            if(stored_size > MAX_STATE_SIZE) {
+                LOG_ERROR("Packed save state is too big ({} bytes)!", stored_size);
+                return false;
+            }
+
+            const u8 *stored = nullptr;
+
+            if(id == RAW_STATE_CHUNK) {
+                stored = deserializer.readInPlace(stored_size);
+            } else {
+                const size_t compressed_size = deserializer.remaining();
+                const u8 *compressed = deserializer.readInPlace(compressed_size);
+                buffer.resize(stored_size);
+
+                if(compressed != nullptr && decompress(compressed, compressed_size, buffer.data(), buffer.size())) {
+                    stored = buffer.data();
+                }
+            }
+
+            if(stored == nullptr) {
+                LOG_ERROR("Packed save state is corrupt!");
+                return false;
+            }
+
+            state = stored;
+            state_size = stored_size;
+            found = true;
+        }
+
+        deserializer.endChunk();
+    }
+
+    if(!found) {
+        LOG_ERROR("Packed save state has no state in it!");
+    }
+
+    return found;
+}
+
+auto makeThumbnail(const u32 *frame) -> std::vector<u32> {
+    std::vector<u32> thumbnail;
+    thumbnail.reserve(THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT);
+
+    for(int y = 0; y < THUMBNAIL_HEIGHT; y++) {
+        for(int x = 0; x < THUMBNAIL_WIDTH; x++) {
+            const u32 *pixel = &frame[x * 2 + y * 2 * FRAME_WIDTH];
+            const u32 quad[4] = {pixel[0], pixel[1], pixel[FRAME_WIDTH], pixel[FRAME_WIDTH + 1]};
+            u32 average = 0;
+
+            for(int shift = 0; shift < 32; shift += 8) {
+                u32 sum = 0;
+                for(u32 color : quad) {
+                    sum += (color >> shift) & 0xFF;
+                }
+
+                average |= (sum / 4) << shift;
+            }
+
+            thumbnail.push_back(average);
+        }
+    }
+
+    return thumbnail;
+}
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Types.hpp"
+#include <vector>
+#include <cstddef>
+
+
+namespace common {
+
+/*
+ * Save states as the frontend writes them to disk. The state goes in a chunk,
+ * next to an optional half size thumbnail of the screen. It's compressed to
+ * about a tenth of the size, or left as it is so it can be loaded straight
+ * from a mapped file without unpacking it into memory first.
+ */
+constexpr int FRAME_WIDTH = 240;
+constexpr int FRAME_HEIGHT = 160;
+constexpr int THUMBNAIL_WIDTH = FRAME_WIDTH / 2;
+constexpr int THUMBNAIL_HEIGHT = FRAME_HEIGHT / 2;
+
+//Unpacked states bigger than this are taken to be corrupt, real ones are well under a megabyte
+constexpr size_t MAX_STATE_SIZE = 4_MiB;
+
+//The frame is 240x160 RGBA8888 pixels, or empty to leave out the thumbnail
+void packState(const std::vector<u8> &state, const std::vector<u32> &frame, bool compress, std::vector<u8> &output);
+auto isPackedState(const u8 *data, size_t size) -> bool;
+
+//Points state into data if it was stored as it is, otherwise decompresses it into buffer
+auto unpackState(const u8 *data, size_t size, std::vector<u8> &buffer, const u8 *&state, size_t &state_size) -> bool;
+
+//Each pixel is the average of the four it covers in the frame
+auto makeThumbnail(const u32 *frame) -> std::vector<u32>;
+
+} //namespace common
\ No newline at end of file
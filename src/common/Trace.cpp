@@ -0,0 +1,332 @@
+#include "Trace.hpp"
+#include "Buffer.hpp"
+#include "Bits.hpp"
+#include "Log.hpp"
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+constexpr u32 TRACE_MAGIC = 0x54414247; //'GBAT' in little-endian
+constexpr u16 TRACE_VERSION = 0x1;
+
+
+namespace common {
+
+namespace trace {
+
+std::atomic<bool> s_trace_enabled = false;
+
+static void writeVarint(std::vector<u8> &output, u64 value) {
+    while(value >= 0x80) {
+        output.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    output.push_back(value);
+}
+
+static auto readVarint(const u8 *&data, const u8 *end, u64 &value) -> bool {
+    value = 0;
+
+    for(int shift = 0; shift < 64; shift += 7) {
+        if(data == end) {
+            return false;
+        }
+
+        u8 byte = *data++;
+        value |= static_cast<u64>(byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void writeString(std::vector<u8> &output, const std::string &string) {
+    writeVarint(output, string.size());
+    output.insert(output.end(), string.begin(), string.end());
+}
+
+static auto readString(const u8 *&data, const u8 *end, std::string &string) -> bool {
+    u64 length = 0;
+    if(!readVarint(data, end, length) || length > static_cast<u64>(end - data)) {
+        return false;
+    }
+
+    string.assign(reinterpret_cast<const char*>(data), length);
+    data += length;
+    return true;
+}
+
+//Defined from any thread, usually while static objects are being set up
+static std::mutex s_definitions_mutex;
+
+static auto definitions() -> std::vector<EventInfo>& {
+    static std::vector<EventInfo> instance;
+    return instance;
+}
+
+/*
+ * Packs events into the file in the background. Each one is stored as its ID
+ * plus one, the time since the one before it and its arguments, all as
+ * varints, so most take only a few bytes. An ID of zero comes before each
+ * event's definition, which is written the first time it could be needed.
+ */
+class Writer final {
+public:
+
+    auto start(const std::string &path) -> bool {
+        file.open(path, std::ios_base::binary);
+        if(!file.is_open()) {
+            return false;
+        }
+
+        buffer.clear();
+        u32 magic = bits::to_le(TRACE_MAGIC);
+        u16 version = bits::to_le(TRACE_VERSION);
+        buffer.insert(buffer.end(), reinterpret_cast<u8*>(&magic), reinterpret_cast<u8*>(&magic) + sizeof(magic));
+        buffer.insert(buffer.end(), reinterpret_cast<u8*>(&version), reinterpret_cast<u8*>(&version) + sizeof(version));
+
+        definitions_written = 0;
+        last_timestamp = 0;
+        dropped.store(0);
+        running = true;
+        thread = std::thread([this]() { drain(); });
+
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard lock(mutex);
+            running = false;
+        }
+
+        wake.notify_one();
+        thread.join();
+        file.close();
+    }
+
+    void push(const Event &event) {
+        Event copy = event;
+
+        if(!queue.push(std::move(copy))) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<u64> dropped = 0;
+
+private:
+
+    void drain() {
+        std::unique_lock lock(mutex);
+        Event event;
+
+        while(true) {
+            writeDefinitions();
+
+            while(queue.pop(event)) {
+                const s64 delta = static_cast<s64>(event.timestamp - last_timestamp);
+                last_timestamp = event.timestamp;
+
+                writeVarint(buffer, event.id + 1);
+                writeVarint(buffer, (static_cast<u64>(delta) << 1) ^ static_cast<u64>(delta >> 63));
+                buffer.push_back(event.arg_count);
+
+                for(u8 i = 0; i < event.arg_count; i++) {
+                    writeVarint(buffer, event.args[i]);
+                }
+            }
+
+            file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            buffer.clear();
+
+            if(!running) {
+                break;
+            }
+
+            wake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+
+        //Anything recorded while stopping
+        writeDefinitions();
+        file.flush();
+    }
+
+    //Events can only be recorded once they're defined, so checking before each batch keeps definitions first
+    void writeDefinitions() {
+        std::lock_guard lock(s_definitions_mutex);
+        const std::vector<EventInfo> &events = definitions();
+
+        for(; definitions_written < events.size(); definitions_written++) {
+            writeVarint(buffer, 0);
+            writeVarint(buffer, definitions_written);
+            writeString(buffer, events[definitions_written].name);
+            writeString(buffer, events[definitions_written].format);
+        }
+    }
+
+    MPSCRingBuffer<Event, 32768> queue;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::ofstream file;
+    std::thread thread;
+    std::vector<u8> buffer;
+    size_t definitions_written = 0;
+    u64 last_timestamp = 0;
+    bool running = false;
+};
+
+static auto writer() -> Writer& {
+    static Writer instance;
+    return instance;
+}
+
+auto define_event(const char *name, const char *format) -> EventId {
+    std::lock_guard lock(s_definitions_mutex);
+    definitions().push_back(EventInfo{name, format});
+
+    return definitions().size() - 1;
+}
+
+auto start(const std::string &path) -> bool {
+    if(enabled()) {
+        stop();
+    }
+
+    if(!writer().start(path)) {
+        LOG_ERROR("Failed to open file '{}' for tracing!", path);
+        return false;
+    }
+
+    s_trace_enabled.store(true);
+    return true;
+}
+
+void stop() {
+    if(!enabled()) {
+        return;
+    }
+
+    s_trace_enabled.store(false);
+    writer().stop();
+
+    if(dropped() != 0) {
+        LOG_WARNING("{} trace events were dropped, the trace couldn't be written fast enough", dropped());
+    }
+}
+
+void record(const Event &event) {
+    writer().push(event);
+}
+
+auto dropped() -> u64 {
+    return writer().dropped.load(std::memory_order_relaxed);
+}
+
+auto read_trace(const u8 *data, size_t size, std::vector<EventInfo> &events, std::vector<Event> &records) -> bool {
+    const u8 *end = data + size;
+    u32 magic = 0;
+    u16 version = 0;
+
+    events.clear();
+    records.clear();
+
+    if(size < sizeof(magic) + sizeof(version)) {
+        LOG_ERROR("Trace is too short!");
+        return false;
+    }
+
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&version, data + sizeof(magic), sizeof(version));
+    data += sizeof(magic) + sizeof(version);
+    magic = bits::to_le(magic);
+    version = bits::to_le(version);
+
+    if(magic != TRACE_MAGIC || version != TRACE_VERSION) {
+        LOG_ERROR("Incorrect magic ({:08X}) or version ({:04X}) for trace!", magic, version);
+        return false;
+    }
+
+    u64 timestamp = 0;
+
+    while(data < end) {
+        u64 tag = 0;
+        if(!readVarint(data, end, tag)) {
+            break;
+        }
+
+        if(tag == 0) {
+            u64 id = 0;
+            EventInfo info;
+
+            if(!readVarint(data, end, id) || !readString(data, end, info.name) || !readString(data, end, info.format)) {
+                break;
+            }
+
+            if(id >= events.size()) {
+                events.resize(id + 1);
+            }
+
+            events[id] = std::move(info);
+            continue;
+        }
+
+        Event event{};
+        u64 delta = 0;
+        event.id = tag - 1;
+
+        if(!readVarint(data, end, delta) || data == end) {
+            break;
+        }
+
+        timestamp += static_cast<u64>(static_cast<s64>(delta >> 1) ^ -static_cast<s64>(delta & 1));
+        event.timestamp = timestamp;
+        event.arg_count = *data++;
+
+        if(event.arg_count > 3 || event.id >= events.size()) {
+            break;
+        }
+
+        bool complete = true;
+        for(u8 i = 0; i < event.arg_count && complete; i++) {
+            u64 arg = 0;
+            complete = readVarint(data, end, arg);
+            event.args[i] = arg;
+        }
+
+        if(!complete) {
+            break;
+        }
+
+        records.push_back(event);
+    }
+
+    //A trace cut off while it was being written still has everything before that point
+    if(data < end) {
+        LOG_WARNING("Trace is corrupt after {} events!", records.size());
+    }
+
+    return true;
+}
+
+auto format_event(const EventInfo &info, const Event &event) -> std::string {
+    u32 a = event.args[0], b = event.args[1], c = event.args[2];
+
+    try {
+        return fmt::vformat(info.format, fmt::make_format_args(a, b, c));
+    } catch(const fmt::format_error&) {
+        return fmt::format("{} {} {}", a, b, c);
+    }
+}
+
+} //namespace trace
+
+} //namespace common
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Types.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+namespace common {
+
+namespace trace {
+
+/*
+ * A binary trace of events, for when text logging is too slow to leave on.
+ * Recording an event only copies its ID, a timestamp and up to three numbers
+ * into a lock-free queue; a background thread packs them into the trace file,
+ * and they're only turned into text later by a decoder. Events are defined
+ * once, with a name and a format string for their arguments, and the
+ * definitions are written into the trace so it can be read on its own.
+ */
+
+using EventId = u16;
+
+struct Event {
+    u64 timestamp;
+    EventId id;
+    u8 arg_count;
+    u32 args[3];
+};
+
+struct EventInfo {
+    std::string name;
+    std::string format; //fmt style, given the event's arguments in order
+};
+
+extern std::atomic<bool> s_trace_enabled;
+
+auto define_event(const char *name, const char *format) -> EventId;
+
+//Only call these while nothing is being traced
+auto start(const std::string &path) -> bool;
+void stop();
+
+inline auto enabled() -> bool {
+    return s_trace_enabled.load(std::memory_order_relaxed);
+}
+
+void record(const Event &event);
+auto dropped() -> u64;
+
+template<typename... Args>
+inline void record(EventId id, u64 timestamp, Args... args) {
+    static_assert(sizeof...(Args) <= 3, "Trace events have at most three arguments");
+    record(Event{timestamp, id, sizeof...(Args), {static_cast<u32>(args)...}});
+}
+
+auto read_trace(const u8 *data, size_t size, std::vector<EventInfo> &events, std::vector<Event> &records) -> bool;
+auto format_event(const EventInfo &info, const Event &event) -> std::string;
+
+} //namespace trace
+
+#define TRACE_EVENT(id, timestamp, ...) do { \
+    if(common::trace::enabled()) { \
+        common::trace::record(id, timestamp, ##__VA_ARGS__); \
+    } \
+} while(0)
+
+} //namespace common
\ No newline at end of file
@@ -2,20 +2,25 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Bits.hpp"
 #include "common/Log.hpp"
+#include "common/Trace.hpp"
 
 //Internal Memory (27-bit address) or Any Memory except SRAM (28-bit address)
 static constexpr u32 SOURCE_ADDRESS_MASK[4] = {0x07FFFFFF, 0x0FFFFFFF, 0x0FFFFFFF, 0x0FFFFFFF};
 static constexpr u32 DESTINATION_ADDRESS_MASK[4] = {0x07FFFFFF, 0x07FFFFFF, 0x07FFFFFF, 0x0FFFFFFF};
 static constexpr u16 LENGTH_MASK[4] = {0x3FFF, 0x3FFF, 0x3FFF, 0xFFFF};
 
+static const common::trace::EventId TRACE_DMA_START = common::trace::define_event("dma_start", "channel {}");
+static const common::trace::EventId TRACE_DMA_END = common::trace::define_event("dma_end", "channel {}");
+
 
 namespace emu {
 
 DMA::DMA(GBA &core) : core(core) {
     for(size_t i = 0; i < 4; i++) {
-        channel[i].event = core.scheduler.registerEvent([this, i](u64) {
+        channel[i].event = core.scheduler.registerEvent(fmt::format("dma{}", i), [this, i](u64) {
             channel[i].active = true;
             LOG_TRACE("DMA {} started on cycle: {}", i, this->core.scheduler.getCurrentTimestamp());
+            TRACE_EVENT(TRACE_DMA_START, this->core.scheduler.getCurrentTimestamp(), i);
         });
         LOG_DEBUG("DMA {} has event handle: {}", i, channel[i].event);
     }
@@ -33,31 +38,31 @@ void DMA::reset() {
     }
 }
 
-void DMA::serialize(std::ofstream &file) {
+void DMA::serialize(common::Serializer &serializer) {
     for(int i = 0; i < 4; i++) {
         const DMAChannel &dma = channel[i];
-        file.write(reinterpret_cast<const char*>(&dma.active), sizeof(DMAChannel::active));
-        file.write(reinterpret_cast<const char*>(&dma.source), sizeof(DMAChannel::source));
-        file.write(reinterpret_cast<const char*>(&dma.destination), sizeof(DMAChannel::destination));
-        file.write(reinterpret_cast<const char*>(&dma.length), sizeof(DMAChannel::length));
-        file.write(reinterpret_cast<const char*>(&dma.control), sizeof(DMAChannel::control));
-        file.write(reinterpret_cast<const char*>(&dma._source), sizeof(DMAChannel::_source));
-        file.write(reinterpret_cast<const char*>(&dma._destination), sizeof(DMAChannel::_destination));
-        file.write(reinterpret_cast<const char*>(&dma._length), sizeof(DMAChannel::_length));
+        serializer.write(dma.active);
+        serializer.write(dma.source);
+        serializer.write(dma.destination);
+        serializer.write(dma.length);
+        serializer.write(dma.control);
+        serializer.write(dma._source);
+        serializer.write(dma._destination);
+        serializer.write(dma._length);
     }
 }
 
-void DMA::deserialize(std::ifstream &file) {
+void DMA::deserialize(common::Deserializer &deserializer) {
     for(int i = 0; i < 4; i++) {
         DMAChannel &dma = channel[i];
-        file.read(reinterpret_cast<char*>(&dma.active), sizeof(DMAChannel::active));
-        file.read(reinterpret_cast<char*>(&dma.source), sizeof(DMAChannel::source));
-        file.read(reinterpret_cast<char*>(&dma.destination), sizeof(DMAChannel::destination));
-        file.read(reinterpret_cast<char*>(&dma.length), sizeof(DMAChannel::length));
-        file.read(reinterpret_cast<char*>(&dma.control), sizeof(DMAChannel::control));
-        file.read(reinterpret_cast<char*>(&dma._source), sizeof(DMAChannel::_source));
-        file.read(reinterpret_cast<char*>(&dma._destination), sizeof(DMAChannel::_destination));
-        file.read(reinterpret_cast<char*>(&dma._length), sizeof(DMAChannel::_length));
+        deserializer.read(dma.active);
+        deserializer.read(dma.source);
+        deserializer.read(dma.destination);
+        deserializer.read(dma.length);
+        deserializer.read(dma.control);
+        deserializer.read(dma._source);
+        deserializer.read(dma._destination);
+        deserializer.read(dma._length);
     }
 }
 
@@ -112,6 +117,7 @@ void DMA::step(u32 cycles) {
 
         if(channel[current]._length == 0) {
             LOG_TRACE("DMA {} finished on cycle: {}", current, core.scheduler.getCurrentTimestamp());
+            TRACE_EVENT(TRACE_DMA_END, core.scheduler.getCurrentTimestamp(), current);
 
             channel[current].active = false;
 
@@ -2,7 +2,7 @@
 
 #include "Scheduler.hpp"
 #include "common/Types.hpp"
-#include <fstream>
+#include "common/Serializer.hpp"
 
 
 namespace emu {
@@ -15,8 +15,8 @@ public:
     explicit DMA(GBA &core);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
     auto running() -> bool;
     void step(u32 cycles);
 
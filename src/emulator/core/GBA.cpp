@@ -1,9 +1,53 @@
 #include "GBA.hpp"
 #include "common/Log.hpp"
+#include "common/Hash.hpp"
+#include "common/Bits.hpp"
+#include <algorithm>
+#include <iterator>
+
+
+constexpr u32 CYCLES_PER_FRAME = 280896;
 
 
 namespace emu {
 
+static constexpr auto chunkId(const char (&name)[5]) -> u32 {
+    return name[0] | name[1] << 8 | name[2] << 16 | name[3] << 24;
+}
+
+//Checks the magic, used to verify file type and endianness, and the version
+static auto readStateHeader(common::Deserializer &deserializer) -> bool {
+    u32 magic = 0;
+    deserializer.read(magic);
+    if(magic != 0x53414247) {
+        LOG_ERROR("Incorrect magic ({:08X}) for save state!", magic);
+        return false;
+    }
+
+    u16 version = 0;
+    deserializer.read(version);
+    if(version != SAVE_STATE_VERSION) {
+        LOG_ERROR("Incorrect version ({:04X}) for save state!", version);
+        return false;
+    }
+
+    return true;
+}
+
+//Each component's state goes in its own chunk, in this order
+template<typename F>
+static void forEachComponent(GBA &core, F &&visit) {
+    visit(chunkId("SCHD"), core.scheduler);
+    visit(chunkId("KEYP"), core.keypad);
+    visit(chunkId("TIMR"), core.timer);
+    visit(chunkId("DMA "), core.dma);
+    visit(chunkId("SIO "), core.sio);
+    visit(chunkId("PPU "), core.ppu);
+    visit(chunkId("APU "), core.apu);
+    visit(chunkId("BUS "), core.bus);
+    visit(chunkId("CPU "), core.cpu);
+}
+
 GBA::GBA(VideoDevice &video_device, InputDevice &input_device, AudioDevice &audio_device) 
         : video_device(video_device), input_device(input_device), audio_device(audio_device),
         debug(*this), keypad(*this), timer(*this), dma(*this), sio(*this), ppu(*this), apu(*this), bus(*this), cpu(*this) { }
@@ -43,10 +87,13 @@ void GBA::step() {
     }
 }
 
-auto GBA::run(u32 cycles) -> u32 {
+//Can also return as soon as V-Blank starts, so things that happen once a
+//frame are done at the same point in every frame
+auto GBA::run(u32 cycles, bool stop_at_vblank) -> u32 {
     u64 target = scheduler.getCurrentTimestamp() + cycles;
+    frame_ended = false;
 
-    while(scheduler.getCurrentTimestamp() < target) {
+    while(scheduler.getCurrentTimestamp() < target && !stop_requested.load(std::memory_order_relaxed) && !(stop_at_vblank && frame_ended)) {
         u64 start = scheduler.getCurrentTimestamp();
 
         if(dma.running()) {
@@ -73,57 +120,191 @@ auto GBA::run(u32 cycles) -> u32 {
     return scheduler.getCurrentTimestamp() - (target - cycles);
 }
 
+//Runs until the next V-Blank starts, unless a stop is requested first
+auto GBA::runFrame() -> u32 {
+    u32 cycles = 0;
+
+    do {
+        cycles += run(CYCLES_PER_FRAME, true);
+    } while(!frame_ended && !stop_requested.load(std::memory_order_relaxed));
+
+    return cycles;
+}
+
+//Makes any current or future call to run() return as soon as possible,
+//instead of at the end of its cycles, until the request is cleared
+void GBA::requestStop() {
+    stop_requested.store(true, std::memory_order_relaxed);
+}
+
+void GBA::clearStopRequest() {
+    stop_requested.store(false, std::memory_order_relaxed);
+}
+
 void GBA::loadBIOS(const std::vector<u8> &bios) {
     bus.loadBIOS(bios);
 }
 
+void GBA::loadBIOS(std::shared_ptr<const std::vector<u8>> bios) {
+    bus.loadBIOS(std::move(bios));
+}
+
 void GBA::saveState(std::ofstream &file) {
+    common::FileSerializer serializer(file);
+    serializeState(serializer);
+}
+
+//Replaces the contents of buffer, reusing its capacity
+void GBA::saveState(std::vector<u8> &buffer) {
+    buffer.clear();
+    common::MemorySerializer serializer(buffer);
+    serializeState(serializer);
+}
+
+//Only copies the RAM pages written since the last time, so only one of these
+//should be kept up to date at a time. Loading a state marks the pages it changes.
+void GBA::saveState(common::IncrementalSerializer &serializer) {
+    serializer.begin();
+    serializeState(serializer);
+    serializer.end();
+
+    bus.clearDirtyPages();
+    ppu.clearDirtyPages();
+}
+
+//Read in whole first, since the state is checked before any of it is loaded
+auto GBA::loadState(std::ifstream &file) -> bool {
+    const std::vector<u8> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadState(buffer.data(), buffer.size());
+}
+
+//Leaves the core as it was when the state can't be loaded
+auto GBA::loadState(const u8 *data, size_t size) -> bool {
+    return deserializeState(data, size);
+}
+
+//Each part on its own, to find where two runs went different ways
+auto GBA::stateHashes() -> StateHashes {
+    StateHashes hashes;
+    const u64 timestamp = bits::to_le(scheduler.getCurrentTimestamp());
+    hashes.values[StateHashes::HASH_TIMESTAMP] = common::hash64(&timestamp, sizeof(timestamp));
+    cpu.hashState(hashes);
+    bus.hashState(hashes);
+    ppu.hashState(hashes);
+
+    return hashes;
+}
+
+//Only depends on what was emulated, so it can be compared between builds and hosts
+auto GBA::stateHash() -> u64 {
+    const StateHashes hashes = stateHashes();
+    u64 values[StateHashes::COMPONENT_COUNT];
+
+    for(size_t i = 0; i < StateHashes::COMPONENT_COUNT; i++) {
+        values[i] = bits::to_le(hashes.values[i]);
+    }
+
+    return common::hash64(values, sizeof(values));
+}
+
+void GBA::serializeState(common::Serializer &serializer) {
     //Write a header magic used to verify file type and endianness
     u32 magic = 0x53414247; //'GBAS' in little-endian
-    file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    serializer.write(magic);
 
     //Write a version number
-    file.write(reinterpret_cast<const char*>(&SAVE_STATE_VERSION), sizeof(SAVE_STATE_VERSION));
+    serializer.write(SAVE_STATE_VERSION);
 
     //Serialize each component state
-    scheduler.serialize(file);
-    keypad.serialize(file);
-    timer.serialize(file);
-    dma.serialize(file);
-    sio.serialize(file);
-    ppu.serialize(file);
-    apu.serialize(file);
-    bus.serialize(file);
-    cpu.serialize(file);
-}
-
-void GBA::loadState(std::ifstream &file) {
-    //Load and verify magic
-    u32 magic = 0;
-    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-    if(magic != 0x53414247) {
-        LOG_ERROR("Incorrect magic ({:08X}) for save state!", magic);
-        return;
+    forEachComponent(*this, [&](u32 id, auto &component) {
+        serializer.beginChunk(id);
+        component.serialize(serializer);
+        serializer.endChunk();
+    });
+}
+
+//Whether loadState would take the state. Walks the chunks without loading
+//any of them, so a state that can't be loaded is turned down before the core
+//is touched.
+auto GBA::checkState(const u8 *data, size_t size) -> bool {
+    common::MemoryDeserializer deserializer(data, size);
+
+    if(!readStateHeader(deserializer)) {
+        return false;
     }
 
-    //Load and verify version
-    u16 version = 0;
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if(version != SAVE_STATE_VERSION) {
-        LOG_ERROR("Incorrect version ({:04X}) for save state!", version);
-        return;
+    //Chunks from newer versions are skipped
+    std::vector<u32> found;
+    size_t components = 0;
+    u32 id = 0;
+
+    forEachComponent(*this, [&](u32, auto&) { components++; });
+
+    while(deserializer.beginChunk(id)) {
+        bool known = false;
+
+        forEachComponent(*this, [&](u32 chunk, auto&) {
+            known = known || chunk == id;
+        });
+
+        if(!known) {
+            LOG_WARNING("Skipping unknown chunk {:08X} in save state", id);
+        } else if(std::find(found.begin(), found.end(), id) == found.end()) {
+            found.push_back(id);
+        }
+
+        deserializer.endChunk();
+    }
+
+    if(!deserializer.good()) {
+        LOG_ERROR("Save state is truncated!");
+        return false;
+    }
+
+    if(found.size() < components) {
+        LOG_ERROR("Save state is missing {} components!", components - found.size());
+        return false;
+    }
+
+    return true;
+}
+
+//A chunk can pass checkState and still be shorter than what its component
+//reads, which only shows once the components before it are loaded
+auto GBA::deserializeState(const u8 *data, size_t size) -> bool {
+    if(!checkState(data, size)) {
+        return false;
+    }
+
+    saveState(rollback_state);
+
+    if(!applyState(data, size)) {
+        LOG_ERROR("Save state has a component that's cut short!");
+        applyState(rollback_state.data(), rollback_state.size());
+        return false;
     }
 
+    return true;
+}
+
+auto GBA::applyState(const u8 *data, size_t size) -> bool {
+    common::MemoryDeserializer deserializer(data, size);
+    readStateHeader(deserializer);
+
     //Deserialize each component state
-    scheduler.deserialize(file);
-    keypad.deserialize(file);
-    timer.deserialize(file);
-    dma.deserialize(file);
-    sio.deserialize(file);
-    ppu.deserialize(file);
-    apu.deserialize(file);
-    bus.deserialize(file);
-    cpu.deserialize(file);
+    u32 id = 0;
+
+    while(deserializer.beginChunk(id)) {
+        forEachComponent(*this, [&](u32 chunk, auto &component) {
+            if(chunk == id) {
+                component.deserialize(deserializer);
+            }
+        });
+
+        deserializer.endChunk();
+    }
+
+    return deserializer.good();
 }
 
 } //namespace emu
\ No newline at end of file
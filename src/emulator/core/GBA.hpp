@@ -1,6 +1,7 @@
 #pragma once
 
 #include "emulator/core/Scheduler.hpp"
+#include "emulator/core/StateHash.hpp"
 #include "emulator/core/debug/DebugInterface.hpp"
 #include "emulator/core/Keypad.hpp"
 #include "emulator/core/Timer.hpp"
@@ -14,12 +15,15 @@
 #include "emulator/device/InputDevice.hpp"
 #include "emulator/device/AudioDevice.hpp"
 #include <fstream>
+#include <atomic>
+#include <memory>
 
 
 namespace emu {
 
-//Increment whenever some component is changed in a way that causes the save state format to change.
-constexpr u16 SAVE_STATE_VERSION = 0x1;
+//Increment whenever the save state format changes in a way older states can't be loaded from.
+//Fields added to the end of a component's chunk, or whole new chunks, don't need a new version.
+constexpr u16 SAVE_STATE_VERSION = 0x5;
 
 class GBA final {
 public:
@@ -28,10 +32,20 @@ public:
 
     void reset(bool skip_bios = true, bool enable_debugger = false);
     void step();
-    auto run(u32 cycles) -> u32;
+    auto run(u32 cycles, bool stop_at_vblank = false) -> u32;
+    auto runFrame() -> u32;
+    void requestStop();
+    void clearStopRequest();
     void loadBIOS(const std::vector<u8> &bios);
+    void loadBIOS(std::shared_ptr<const std::vector<u8>> bios);
     void saveState(std::ofstream &file);
-    void loadState(std::ifstream &file);
+    void saveState(std::vector<u8> &buffer);
+    void saveState(common::IncrementalSerializer &serializer);
+    auto loadState(std::ifstream &file) -> bool;
+    auto loadState(const u8 *data, size_t size) -> bool;
+    auto checkState(const u8 *data, size_t size) -> bool;
+    auto stateHashes() -> StateHashes;
+    auto stateHash() -> u64;
 
     VideoDevice &video_device;
     InputDevice &input_device;
@@ -49,6 +63,19 @@ public:
 
     u32 cycles_active = 0;
     bool enable_debugger = false;
+    bool frame_ended = false; //Set by the PPU at the start of V-Blank, cleared by run()
+
+private:
+
+    void serializeState(common::Serializer &serializer);
+    auto deserializeState(const u8 *data, size_t size) -> bool;
+    auto applyState(const u8 *data, size_t size) -> bool;
+
+    //What the core was before the last state was loaded, to go back to if it's cut short
+    std::vector<u8> rollback_state;
+
+    //Set from other threads to make run() return early
+    std::atomic<bool> stop_requested = false;
 };
 
 } //namespace emu
\ No newline at end of file
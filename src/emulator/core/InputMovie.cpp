@@ -0,0 +1,253 @@
+#include "InputMovie.hpp"
+#include "emulator/core/GBA.hpp"
+#include "common/Compression.hpp"
+#include "common/MappedFile.hpp"
+#include "common/Log.hpp"
+#include <algorithm>
+#include <fstream>
+
+constexpr u32 MOVIE_MAGIC = 0x4D414247; //'GBAM' in little-endian
+constexpr u16 MOVIE_VERSION = 0x1;
+constexpr u32 INFO_CHUNK = 0x4F464E49; //'INFO'
+constexpr u32 STATE_CHUNK = 0x54415453; //'STAT'
+constexpr u32 KEYS_CHUNK = 0x5359454B; //'KEYS'
+
+
+namespace emu {
+
+void InputMovie::clear() {
+    state.clear();
+    entries.clear();
+    start_timestamp = 0;
+    end_timestamp = 0;
+    title.clear();
+    cursor = 0;
+}
+
+//Keys are stored as the time since the last change, which is usually small
+void InputMovie::serialize(common::Serializer &serializer) const {
+    serializer.write(MOVIE_MAGIC);
+    serializer.write(MOVIE_VERSION);
+
+    serializer.beginChunk(INFO_CHUNK);
+    serializer.write(static_cast<u8>(title.size()));
+    serializer.write(title.data(), title.size());
+    serializer.write(start_timestamp);
+    serializer.write(end_timestamp);
+    serializer.endChunk();
+
+    std::vector<u8> compressed;
+    common::compress(state.data(), state.size(), compressed);
+
+    serializer.beginChunk(STATE_CHUNK);
+    serializer.write(static_cast<u32>(state.size()));
+    serializer.write(compressed.data(), compressed.size());
+    serializer.endChunk();
+
+    serializer.beginChunk(KEYS_CHUNK);
+    serializer.write(static_cast<u32>(entries.size()));
+
+    u64 last_timestamp = start_timestamp;
+    for(const auto &entry : entries) {
+        u64 delta = entry.timestamp - last_timestamp;
+        last_timestamp = entry.timestamp;
+
+        while(delta >= 0x80) {
+            serializer.write(static_cast<u8>((delta & 0x7F) | 0x80));
+            delta >>= 7;
+        }
+
+        serializer.write(static_cast<u8>(delta));
+        serializer.write(entry.keys);
+    }
+
+    serializer.endChunk();
+}
+
+auto InputMovie::deserialize(common::Deserializer &deserializer) -> bool {
+    clear();
+
+    u32 magic = 0;
+    u16 version = 0;
+    deserializer.read(magic);
+    deserializer.read(version);
+
+    if(magic != MOVIE_MAGIC || version != MOVIE_VERSION) {
+        LOG_ERROR("Incorrect magic ({:08X}) or version ({:04X}) for input movie!", magic, version);
+        return false;
+    }
+
+    bool found_state = false;
+    u32 id = 0;
+
+    while(deserializer.beginChunk(id)) {
+        switch(id) {
+            case INFO_CHUNK : {
+                u8 length = 0;
+                deserializer.read(length);
+                title.resize(length);
+                deserializer.read(title.data(), length);
+                deserializer.read(start_timestamp);
+                deserializer.read(end_timestamp);
+            } break;
+
+            case STATE_CHUNK : {
+                u32 size = 0;
+                deserializer.read(size);
+
+                std::vector<u8> compressed(deserializer.remaining());
+                deserializer.read(compressed.data(), compressed.size());
+                state.resize(size);
+
+                found_state = deserializer.good() && common::decompress(compressed.data(), compressed.size(), state.data(), state.size());
+            } break;
+
+            case KEYS_CHUNK : {
+                u32 count = 0;
+                deserializer.read(count);
+
+                u64 timestamp = start_timestamp;
+                for(u32 i = 0; i < count && deserializer.good(); i++) {
+                    u64 delta = 0;
+                    u8 byte = 0;
+
+                    for(int shift = 0; shift < 64; shift += 7) {
+                        deserializer.read(byte);
+                        delta |= static_cast<u64>(byte & 0x7F) << shift;
+
+                        if((byte & 0x80) == 0) {
+                            break;
+                        }
+                    }
+
+                    timestamp += delta;
+                    Entry entry{timestamp, 0};
+                    deserializer.read(entry.keys);
+                    entries.push_back(entry);
+                }
+            } break;
+        }
+
+        deserializer.endChunk();
+    }
+
+    if(!deserializer.good() || !found_state) {
+        LOG_ERROR("Input movie is corrupt!");
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+auto InputMovie::save(const std::string &path) const -> bool {
+    std::ofstream file(path, std::ios_base::binary);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for saving input movie!", path);
+        return false;
+    }
+
+    common::FileSerializer serializer(file);
+    serialize(serializer);
+
+    return file.good();
+}
+
+auto InputMovie::load(const std::string &path) -> bool {
+    common::MappedFile file;
+    if(!file.open(path)) {
+        LOG_ERROR("Failed to open input movie '{}'!", path);
+        return false;
+    }
+
+    common::MemoryDeserializer deserializer(file.data(), file.size());
+    return deserialize(deserializer);
+}
+
+auto InputMovie::isMovie(const u8 *data, size_t size) -> bool {
+    common::MemoryDeserializer deserializer(data, size);
+    u32 magic = 0;
+    deserializer.read(magic);
+
+    return deserializer.good() && magic == MOVIE_MAGIC;
+}
+
+//Polls that come before the last change, like after run-ahead or rewinding,
+//replace everything from that point on
+void InputMovie::addKeys(u64 timestamp, u16 keys) {
+    while(!entries.empty() && entries.back().timestamp >= timestamp) {
+        entries.pop_back();
+    }
+
+    cursor = std::min(cursor, entries.size());
+
+    if(entries.empty() || entries.back().keys != keys) {
+        entries.push_back(Entry{timestamp, keys});
+    }
+
+    end_timestamp = timestamp;
+}
+
+//Usually moves forward a little at a time, so it only searches when going backwards
+auto InputMovie::getKeys(u64 timestamp) -> u16 {
+    if(cursor > 0 && entries[cursor - 1].timestamp > timestamp) {
+        cursor = std::upper_bound(entries.begin(), entries.end(), timestamp, [](u64 timestamp, const Entry &entry) {
+            return timestamp < entry.timestamp;
+        }) - entries.begin();
+    }
+
+    while(cursor < entries.size() && entries[cursor].timestamp <= timestamp) {
+        cursor++;
+    }
+
+    return cursor > 0 ? entries[cursor - 1].keys : 0x3FF;
+}
+
+//In cycles
+auto InputMovie::getLength() const -> u64 {
+    return end_timestamp - start_timestamp;
+}
+
+MovieRecorder::MovieRecorder(InputDevice &source) : source(source) { }
+
+//Starts from the core's current state, it shouldn't be running
+void MovieRecorder::start(GBA &core) {
+    movie.clear();
+    core.saveState(movie.state);
+    movie.start_timestamp = core.scheduler.getCurrentTimestamp();
+    movie.end_timestamp = movie.start_timestamp;
+    movie.title = core.bus.pak.getTitle();
+    this->core = &core;
+}
+
+//Anything polled past the end was from frames run ahead, and never really happened
+void MovieRecorder::stop() {
+    if(core != nullptr) {
+        movie.end_timestamp = core->scheduler.getCurrentTimestamp();
+        core = nullptr;
+
+        while(!movie.entries.empty() && movie.entries.back().timestamp > movie.end_timestamp) {
+            movie.entries.pop_back();
+        }
+    }
+}
+
+auto MovieRecorder::isRecording() const -> bool {
+    return core != nullptr;
+}
+
+auto MovieRecorder::getMovie() const -> const InputMovie& {
+    return movie;
+}
+
+auto MovieRecorder::getKeys() -> u16 {
+    const u16 keys = source.getKeys();
+
+    if(core != nullptr) {
+        movie.addKeys(core->scheduler.getCurrentTimestamp(), keys & 0x3FF);
+    }
+
+    return keys;
+}
+
+} //namespace emu
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "emulator/device/InputDevice.hpp"
+#include "common/Serializer.hpp"
+#include "common/Types.hpp"
+#include <string>
+#include <vector>
+
+
+namespace emu {
+
+class GBA;
+
+/*
+ * Everything a game saw from the keypad, starting from a save state. Input is
+ * only sampled when the keypad polls it, so each change is kept with the
+ * scheduler timestamp it was polled at, and playing it back from the same
+ * state gives a bit-exact copy of the run it was recorded from.
+ */
+class InputMovie final {
+public:
+
+    struct Entry {
+        u64 timestamp;
+        u16 keys; //Same format as KEYINPUT
+    };
+
+    void clear();
+    void serialize(common::Serializer &serializer) const;
+    auto deserialize(common::Deserializer &deserializer) -> bool;
+    auto save(const std::string &path) const -> bool;
+    auto load(const std::string &path) -> bool;
+    static auto isMovie(const u8 *data, size_t size) -> bool;
+
+    void addKeys(u64 timestamp, u16 keys);
+    auto getKeys(u64 timestamp) -> u16;
+    auto getLength() const -> u64;
+
+    std::vector<u8> state; //The save state the movie starts from
+    std::vector<Entry> entries;
+    u64 start_timestamp = 0;
+    u64 end_timestamp = 0;
+    std::string title; //Of the game it was recorded with
+
+private:
+
+    size_t cursor = 0;
+};
+
+/*
+ * Passes input through from another device, and while recording keeps every
+ * change the keypad polls into a movie.
+ */
+class MovieRecorder final : public InputDevice {
+public:
+
+    explicit MovieRecorder(InputDevice &source);
+
+    void start(GBA &core);
+    void stop();
+    auto isRecording() const -> bool;
+    auto getMovie() const -> const InputMovie&;
+
+    auto getKeys() -> u16 override;
+
+private:
+
+    InputDevice &source;
+    GBA *core = nullptr;
+    InputMovie movie;
+};
+
+} //namespace emu
\ No newline at end of file
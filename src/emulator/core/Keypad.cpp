@@ -2,30 +2,38 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Bits.hpp"
 
+//Once a scanline. Input is only sampled on the emulator's own schedule, so a
+//game sees the same changes at the same points when they're played back.
+constexpr u32 POLL_INTERVAL = 1232;
+
 
 namespace emu {
 
 Keypad::Keypad(GBA &core) : core(core) {
-    core.input_device.onInput([this]() { checkForInterrupt(); });
+    poll_event = core.scheduler.registerEvent("keypad_poll", [this](u64 late) { poll(late); });
     reset();
 }
 
 void Keypad::reset() {
     keycnt = 0;
+    keyinput = 0x3FF;
+    core.scheduler.addEvent(poll_event, 0);
 }
 
-void Keypad::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&keycnt), sizeof(keycnt));
+void Keypad::serialize(common::Serializer &serializer) {
+    serializer.write(keycnt);
+    serializer.write(keyinput);
 }
 
-void Keypad::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&keycnt), sizeof(keycnt));
+void Keypad::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(keycnt);
+    deserializer.read(keyinput);
 }
 
 auto Keypad::read8(u32 address) -> u8 {
     switch(address) {
-        case 0x130 : return bits::get<0, 8>(core.input_device.getKeys());
-        case 0x131 : return bits::get<8, 8>(core.input_device.getKeys());
+        case 0x130 : return bits::get<0, 8>(keyinput);
+        case 0x131 : return bits::get<8, 8>(keyinput);
         case 0x132 : return bits::get<0, 8>(keycnt);
         case 0x133 : return bits::get<8, 8>(keycnt);
     }
@@ -34,22 +42,30 @@ auto Keypad::read8(u32 address) -> u8 {
 }
 
 void Keypad::write8(u32 address, u8 value) {
-    keycnt_mutex.lock();
     switch(address) {
         case 0x132 : keycnt = (keycnt & 0xFF00) | value;
         case 0x133 : keycnt = (keycnt & 0x00FF) | ((value & 0xC3) << 8);
     }
-    keycnt_mutex.unlock();
 
     checkForInterrupt();
 }
 
+void Keypad::poll(u64 late) {
+    const u16 keys = core.input_device.getKeys() & 0x3FF;
+
+    if(keys != keyinput) {
+        keyinput = keys;
+        checkForInterrupt();
+    }
+
+    //Stays on the same grid even when the event ran more than a whole interval late
+    core.scheduler.addEvent(poll_event, POLL_INTERVAL - late % POLL_INTERVAL);
+}
+
 //TODO: Actually end Stop mode when it is implemented
 void Keypad::checkForInterrupt() {
-    keycnt_mutex.lock();
-
     //Mask the currently pressed buttons with the selected buttons
-    u16 pressed = ~core.input_device.getKeys() & (keycnt & 0x3FF);
+    u16 pressed = ~keyinput & (keycnt & 0x3FF);
     bool condition_met = false;
 
     if(bits::get_bit<15>(keycnt)) {
@@ -68,8 +84,6 @@ void Keypad::checkForInterrupt() {
             core.cpu.requestInterrupt(INT_KEYPAD);
         }
     }
-
-    keycnt_mutex.unlock();
 }
 
 } //namespace emu
\ No newline at end of file
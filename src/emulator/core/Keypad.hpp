@@ -1,8 +1,8 @@
 #pragma once
 
 #include "common/Types.hpp"
-#include <mutex>
-#include <fstream>
+#include "emulator/core/Scheduler.hpp"
+#include "common/Serializer.hpp"
 
 
 namespace emu {
@@ -28,19 +28,21 @@ public:
     explicit Keypad(GBA &core);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
 
     auto read8(u32 address) -> u8;
     void write8(u32 address, u8 value);
 
 private:
 
+    void poll(u64 late);
     void checkForInterrupt();
     
     GBA &core;
+    EventHandle poll_event;
     u16 keycnt;
-    std::mutex keycnt_mutex;
+    u16 keyinput; //Latched from the input device at each poll
 };
 
 } //namespace emu
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "RunAhead.hpp"
+#include "emulator/core/GBA.hpp"
+#include <algorithm>
+
+
+namespace emu {
+
+RunAhead::RunAhead(GBA &core) : core(core) {
+    frames = 0;
+}
+
+void RunAhead::setFrames(u32 frames) {
+    this->frames = std::min(frames, MAX_FRAMES);
+
+    //Only the frame leading up to the last V-Blank run ahead gets drawn, when
+    //running one frame ahead that frame starts in the real one. Whether it's
+    //drawn at all is still up to the render policy.
+    core.ppu.setOutputEnabled(this->frames <= 1);
+}
+
+auto RunAhead::getFrames() const -> u32 {
+    return frames;
+}
+
+//Should be called at the start of every real V-Blank, see GBA::run()
+void RunAhead::run() {
+    if(frames == 0) {
+        return;
+    }
+
+    core.apu.setOutputEnabled(false);
+    core.saveState(state);
+
+    //Whether a frame is shown is latched at V-Blank, so it has to be set a frame early
+    for(u32 i = 1; i <= frames; i++) {
+        core.ppu.setOutputEnabled(i == frames - 1);
+        core.runFrame();
+    }
+
+    core.loadState(state.data(), state.size());
+    core.apu.setOutputEnabled(true);
+    core.ppu.setOutputEnabled(frames == 1);
+}
+
+} //namespace emu
\ No newline at end of file
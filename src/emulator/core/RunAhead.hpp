@@ -0,0 +1,36 @@
+#pragma once
+
+#include "common/Types.hpp"
+#include <vector>
+
+
+namespace emu {
+
+class GBA;
+
+/*
+ * Hides the input lag a game has of its own. After every real frame, the
+ * state is saved, the next few frames are run with the same input, and only
+ * the last of them is shown before going back to the saved state. Audio only
+ * comes from the real frames, and those are never shown.
+ */
+class RunAhead final {
+public:
+
+    //Each frame run ahead is run again on every real frame, so there has to be a limit
+    static constexpr u32 MAX_FRAMES = 8;
+
+    explicit RunAhead(GBA &core);
+
+    void setFrames(u32 frames);
+    auto getFrames() const -> u32;
+    void run();
+
+private:
+
+    GBA &core;
+    u32 frames;
+    std::vector<u8> state;
+};
+
+} //namespace emu
\ No newline at end of file
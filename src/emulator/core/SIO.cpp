@@ -6,7 +6,7 @@
 namespace emu {
 
 SIO::SIO(GBA &core) : core(core) {
-    event = core.scheduler.registerEvent([this](u64) {
+    event = core.scheduler.registerEvent("sio_transfer", [this](u64) {
         //Disable start bit
         siocnt &= ~0x80;
 
@@ -24,14 +24,14 @@ void SIO::reset() {
     rcnt = 0;
 }
 
-void SIO::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char *>(&siocnt), sizeof(siocnt));
-    file.write(reinterpret_cast<const char *>(&rcnt), sizeof(rcnt));
+void SIO::serialize(common::Serializer &serializer) {
+    serializer.write(siocnt);
+    serializer.write(rcnt);
 }
 
-void SIO::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char *>(&siocnt), sizeof(siocnt));
-    file.read(reinterpret_cast<char *>(&rcnt), sizeof(rcnt));
+void SIO::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(siocnt);
+    deserializer.read(rcnt);
 }
 
 auto SIO::read8(u32 address) -> u8 {
@@ -1,4 +1,6 @@
 #include "Scheduler.hpp"
+#include "common/Log.hpp"
+#include <algorithm>
 
 
 namespace emu {
@@ -12,36 +14,49 @@ void Scheduler::reset() {
     events.clear();
 }
 
-void Scheduler::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char *>(&current_timestamp), sizeof(current_timestamp));
+void Scheduler::serialize(common::Serializer &serializer) {
+    serializer.write(current_timestamp);
 
-    //Handles are dependent on the initialization order of components, 
-    //any changes to that order should increment the save state version.
+    //Events are saved by name, so the order components register them in can change
     const std::vector<Event> &container = events.getContainer();
-    size_t size = container.size();
-    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    serializer.write(static_cast<u32>(container.size()));
     for(const auto &event : container) {
-        file.write(reinterpret_cast<const char *>(&event.handle), sizeof(Event::handle));
-        file.write(reinterpret_cast<const char *>(&event.scheduled_timestamp), sizeof(Event::scheduled_timestamp));
+        const std::string &name = names[event.handle];
+        serializer.write(static_cast<u8>(name.size()));
+        serializer.write(name.data(), name.size());
+        serializer.write(event.scheduled_timestamp);
     }
 }
 
-void Scheduler::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&current_timestamp), sizeof(current_timestamp));
+void Scheduler::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(current_timestamp);
     
-    size_t size = 0;
-    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    u32 size = 0;
+    deserializer.read(size);
     events.clear();
-    for(size_t i = 0; i < size; i++) {
-        Event event;
-        file.read(reinterpret_cast<char *>(&event.handle), sizeof(Event::handle));
-        file.read(reinterpret_cast<char *>(&event.scheduled_timestamp), sizeof(Event::scheduled_timestamp));
-        events.insert(event);
+    for(u32 i = 0; i < size && deserializer.good(); i++) {
+        u8 length = 0;
+        deserializer.read(length);
+        std::string name(length, '\0');
+        deserializer.read(name.data(), length);
+
+        u64 timestamp = 0;
+        deserializer.read(timestamp);
+
+        auto found = std::find(names.begin(), names.end(), name);
+        if(found == names.end()) {
+            LOG_WARNING("Skipping unknown event '{}' in save state", name);
+            continue;
+        }
+
+        events.insert(Event{static_cast<EventHandle>(found - names.begin()), timestamp});
     }
 }
 
-auto Scheduler::registerEvent(EventFunc callback) -> EventHandle {
+//Names have to be unique and stay the same between versions for save states to load
+auto Scheduler::registerEvent(const std::string &name, EventFunc callback) -> EventHandle {
     registered.push_back(callback);
+    names.push_back(name);
     return registered.size() - 1;
 }
 
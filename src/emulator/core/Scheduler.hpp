@@ -2,9 +2,10 @@
 
 #include "common/Types.hpp"
 #include "common/Heap.hpp"
+#include "common/Serializer.hpp"
 #include <functional>
 #include <vector>
-#include <fstream>
+#include <string>
 
 
 namespace emu {
@@ -31,10 +32,10 @@ public:
     Scheduler();
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
 
-    auto registerEvent(EventFunc callback) -> EventHandle;
+    auto registerEvent(const std::string &name, EventFunc callback) -> EventHandle;
     void addEvent(EventHandle handle, u64 cycles_from_now);
     void removeEvent(EventHandle handle);
 
@@ -50,6 +51,7 @@ private:
     //which is good enough for me.
     common::MinHeap<Event> events;
     std::vector<EventFunc> registered;
+    std::vector<std::string> names; //Saved in place of handles, which depend on registration order
     u64 current_timestamp;
 };
 
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/Types.hpp"
+
+
+namespace emu {
+
+/*
+ * Hashes of the parts of a core's state that show whether emulation has
+ * changed, kept apart so a mismatch can be narrowed down to one of them.
+ */
+struct StateHashes {
+    enum Component {
+        HASH_CPU, HASH_TIMESTAMP, HASH_EWRAM, HASH_IWRAM, HASH_VRAM, HASH_PALETTE, HASH_OAM, COMPONENT_COUNT
+    };
+
+    static constexpr const char *NAMES[COMPONENT_COUNT] = {
+        "cpu", "timestamp", "ewram", "iwram", "vram", "palette", "oam"
+    };
+
+    u64 values[COMPONENT_COUNT];
+};
+
+} //namespace emu
\ No newline at end of file
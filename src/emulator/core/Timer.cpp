@@ -2,18 +2,22 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Bits.hpp"
 #include "common/Log.hpp"
+#include "common/Trace.hpp"
 
 constexpr u32 PRESCALER_SELECTIONS[4] = {1, 64, 256, 1024};
 
+static const common::trace::EventId TRACE_TIMER_START = common::trace::define_event("timer_start", "timer {} control {:04X}");
+static const common::trace::EventId TRACE_TIMER_STOP = common::trace::define_event("timer_stop", "timer {}");
+
 
 namespace emu {
 
 Timer::Timer(GBA &core) : core(core) {
     for(size_t i = 0; i < 4; i++) {
-        timer_events[i] = core.scheduler.registerEvent([this, i](u64 late) {
+        timer_events[i] = core.scheduler.registerEvent(fmt::format("timer{}_overflow", i), [this, i](u64 late) {
             timerOverflowEvent(i, late);
         });
-        timer_start_events[i] = core.scheduler.registerEvent([this, i](u64 late) {
+        timer_start_events[i] = core.scheduler.registerEvent(fmt::format("timer{}_start", i), [this, i](u64 late) {
             u64 cycles_till_overflow = (0x10000 - timer_counter[i]) * PRESCALER_SELECTIONS[bits::get<0, 2>(tmcnt[i])];
             timer_start[i] = this->core.scheduler.getCurrentTimestamp();
             this->core.scheduler.addEvent(timer_events[i], cycles_till_overflow - late);
@@ -31,21 +35,21 @@ void Timer::reset() {
     std::memset(tmcnt, 0, sizeof(tmcnt));
 }
 
-void Timer::serialize(std::ofstream &file) {
+void Timer::serialize(common::Serializer &serializer) {
     for(int i = 0; i < 4; i++) {
-        file.write(reinterpret_cast<const char*>(&timer_start[i]), sizeof(timer_start[i]));
-        file.write(reinterpret_cast<const char*>(&timer_counter[i]), sizeof(timer_counter[i]));
-        file.write(reinterpret_cast<const char*>(&timer_reload[i]), sizeof(timer_reload[i]));
-        file.write(reinterpret_cast<const char*>(&tmcnt[i]), sizeof(tmcnt[i]));
+        serializer.write(timer_start[i]);
+        serializer.write(timer_counter[i]);
+        serializer.write(timer_reload[i]);
+        serializer.write(tmcnt[i]);
     }
 }
 
-void Timer::deserialize(std::ifstream &file) {
+void Timer::deserialize(common::Deserializer &deserializer) {
     for(int i = 0; i < 4; i++) {
-        file.read(reinterpret_cast<char*>(&timer_start[i]), sizeof(timer_start[i]));
-        file.read(reinterpret_cast<char*>(&timer_counter[i]), sizeof(timer_counter[i]));
-        file.read(reinterpret_cast<char*>(&timer_reload[i]), sizeof(timer_reload[i]));
-        file.read(reinterpret_cast<char*>(&tmcnt[i]), sizeof(tmcnt[i]));
+        deserializer.read(timer_start[i]);
+        deserializer.read(timer_counter[i]);
+        deserializer.read(timer_reload[i]);
+        deserializer.read(tmcnt[i]);
     }
 }
 
@@ -146,6 +150,7 @@ void Timer::updateTimer(u8 timer, u8 old_tmcnt) {
 
 void Timer::startTimer(u8 timer) {
     LOG_TRACE("Timer {} started", timer);
+    TRACE_EVENT(TRACE_TIMER_START, core.scheduler.getCurrentTimestamp(), timer, tmcnt[timer]);
 
     //Cascade, timer is incremented when the preceding one overflows (so it doesn't actually run)
     if(bits::get_bit<2>(tmcnt[timer]) && timer != 0) {
@@ -158,6 +163,7 @@ void Timer::startTimer(u8 timer) {
 
 void Timer::stopTimer(u8 timer) {
     LOG_TRACE("Timer {} stopped", timer);
+    TRACE_EVENT(TRACE_TIMER_STOP, core.scheduler.getCurrentTimestamp(), timer);
 
     core.scheduler.step(2);
     timer_counter[timer] = getTimerIntermediateValue(timer, true);
@@ -2,13 +2,16 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Log.hpp"
 
+//PSG volume from SOUNDCNT_H, 3 is prohibited and treated as 100%
+static constexpr float PSG_VOLUME[4] = {0.25f, 0.5f, 1.0f, 1.0f};
+
 
 namespace emu {
 
 APU::APU(GBA &core) : core(core), pulse1(core.scheduler), pulse2(core.scheduler), wave(core.scheduler), noise(core.scheduler) {
-    step_event = core.scheduler.registerEvent([this](u64 late) { step(late); });
-    sample_event = core.scheduler.registerEvent([this](u64 late) { sample(late); });
-    LOG_DEBUG("APU has event handle: {} and {}", step_event, sample_event);
+    sample_event = core.scheduler.registerEvent("apu_sample", [this](u64 late) { sample(late); });
+    LOG_DEBUG("APU has event handle: {}", sample_event);
+    output_enabled = true;
 
     reset();
 }
@@ -23,67 +26,83 @@ void APU::reset() {
     sndcnt_h = 0xE;
     sndcnt_x = 0;
     sndbias = 0x200;
-    core.audio_device.setSampleRate(bits::get<14, 2>(sndbias));
+    block_fill = 0;
+    updateSampleRate();
 
-    core.scheduler.addEvent(step_event, 32768);
+    next_step = core.scheduler.getCurrentTimestamp() + FRAME_SEQUENCER_PERIOD;
     core.scheduler.addEvent(sample_event, 512);
 }
 
-void APU::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&sndcnt_l), sizeof(sndcnt_l));
-    file.write(reinterpret_cast<const char*>(&sndcnt_h), sizeof(sndcnt_h));
-    file.write(reinterpret_cast<const char*>(&sndcnt_x), sizeof(sndcnt_x));
-    file.write(reinterpret_cast<const char*>(&sndbias), sizeof(sndbias));
-
-    size_t fifo_a_size = fifo_a.size();
-    file.write(reinterpret_cast<const char*>(&fifo_a_size), sizeof(fifo_a_size));
-    file.write(reinterpret_cast<const char*>(&fifo_a.front()), fifo_a.size());
-    size_t fifo_b_size = fifo_b.size();
-    file.write(reinterpret_cast<const char*>(&fifo_b_size), sizeof(fifo_b_size));
-    file.write(reinterpret_cast<const char*>(&fifo_b.front()), fifo_b.size());
-    file.write(reinterpret_cast<const char*>(&fifo_sample_a), sizeof(fifo_sample_a));
-    file.write(reinterpret_cast<const char*>(&fifo_sample_b), sizeof(fifo_sample_b));
-
-    pulse1.serialize(file);
-    pulse2.serialize(file);
-    wave.serialize(file);
-    noise.serialize(file);
+void APU::serialize(common::Serializer &serializer) {
+    serializer.write(sndcnt_l);
+    serializer.write(sndcnt_h);
+    serializer.write(sndcnt_x);
+    serializer.write(sndbias);
+    serializer.write(next_step);
+
+    serializer.write(static_cast<u32>(fifo_a.size()));
+    for(s8 sample : fifo_a) {
+        serializer.write(sample);
+    }
+    serializer.write(static_cast<u32>(fifo_b.size()));
+    for(s8 sample : fifo_b) {
+        serializer.write(sample);
+    }
+    serializer.write(fifo_sample_a);
+    serializer.write(fifo_sample_b);
+
+    pulse1.serialize(serializer);
+    pulse2.serialize(serializer);
+    wave.serialize(serializer);
+    noise.serialize(serializer);
 }
 
-void APU::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&sndcnt_l), sizeof(sndcnt_l));
-    file.read(reinterpret_cast<char*>(&sndcnt_h), sizeof(sndcnt_h));
-    file.read(reinterpret_cast<char*>(&sndcnt_x), sizeof(sndcnt_x));
-    file.read(reinterpret_cast<char*>(&sndbias), sizeof(sndbias));
+void APU::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(sndcnt_l);
+    deserializer.read(sndcnt_h);
+    deserializer.read(sndcnt_x);
+    deserializer.read(sndbias);
+    deserializer.read(next_step);
+    block_fill = 0;
     
-    size_t fifo_a_size = 0;
-    file.read(reinterpret_cast<char*>(&fifo_a_size), sizeof(fifo_a_size));
+    u32 fifo_a_size = 0;
+    deserializer.read(fifo_a_size);
     fifo_a.clear();
-    for(size_t i = 0; i < fifo_a_size; i++) {
+    for(u32 i = 0; i < fifo_a_size && deserializer.good(); i++) {
         u8 val = 0;
-        file.read(reinterpret_cast<char*>(&val), sizeof(val));
+        deserializer.read(val);
         fifo_a.push_back(val);
     }
 
-    size_t fifo_b_size = 0;
-    file.read(reinterpret_cast<char*>(&fifo_b_size), sizeof(fifo_b_size));
+    u32 fifo_b_size = 0;
+    deserializer.read(fifo_b_size);
     fifo_b.clear();
-    for(size_t i = 0; i < fifo_b_size; i++) {
+    for(u32 i = 0; i < fifo_b_size && deserializer.good(); i++) {
         u8 val = 0;
-        file.read(reinterpret_cast<char*>(&val), sizeof(val));
+        deserializer.read(val);
         fifo_b.push_back(val);
     }
 
-    file.read(reinterpret_cast<char*>(&fifo_sample_a), sizeof(fifo_sample_a));
-    file.read(reinterpret_cast<char*>(&fifo_sample_b), sizeof(fifo_sample_b));
+    deserializer.read(fifo_sample_a);
+    deserializer.read(fifo_sample_b);
 
-    pulse1.deserialize(file);
-    pulse2.deserialize(file);
-    wave.deserialize(file);
-    noise.deserialize(file);
+    pulse1.deserialize(deserializer);
+    pulse2.deserialize(deserializer);
+    wave.deserialize(deserializer);
+    noise.deserialize(deserializer);
+
+    updateSampleRate();
+}
+
+//Samples are still made while disabled, but thrown away. Anything already made goes out first.
+void APU::setOutputEnabled(bool enabled) {
+    flushSamples();
+    output_enabled = enabled;
 }
 
 auto APU::read(u32 address) -> u8 {
+    catchUp(core.scheduler.getCurrentTimestamp());
+
     if(address >= 0x60 && address <= 0x65) {
         return pulse1.read(address);
     }
@@ -102,7 +121,7 @@ auto APU::read(u32 address) -> u8 {
         case 0x81 : return sndcnt_l >> 8;
         case 0x82 : return sndcnt_h & 0xFF;
         case 0x83 : return (sndcnt_h >> 8) & 0x77;
-        case 0x84 : return sndcnt_x;
+        case 0x84 : return sndcnt_x | pulse1.isEnabled() | pulse2.isEnabled() << 1 | wave.isEnabled() << 2 | noise.isEnabled() << 3;
         case 0x88 : return sndbias & 0xFF;
         case 0x89 : return sndbias >> 8;
     }
@@ -111,6 +130,8 @@ auto APU::read(u32 address) -> u8 {
 }
 
 void APU::write(u32 address, u8 value) {
+    catchUp(core.scheduler.getCurrentTimestamp());
+
     if(address >= 0x60 && address <= 0x65) {
         pulse1.write(address, value);
     }
@@ -139,8 +160,9 @@ void APU::write(u32 address, u8 value) {
         case 0x84 : sndcnt_x = value & 0x80; break;
         case 0x88 : sndbias = (sndbias & 0xFF00) | (value & ~1); break;
         case 0x89 : 
+            flushSamples();
             sndbias = (sndbias & 0x00FF) | (value & 0xC3) << 8;
-            core.audio_device.setSampleRate(bits::get<14, 2>(sndbias));
+            updateSampleRate();
             LOG_DEBUG("Sampling rate {}KHz selected", 32 << bits::get<14, 2>(sndbias));
             break;
 
@@ -184,34 +206,42 @@ auto APU::isTimerSelected(int timer) -> bool {
     return bits::get_bit<10>(sndcnt_h) == timer || bits::get_bit<14>(sndcnt_h) == timer;
 }
 
-void APU::step(u64 late) {
-    pulse1.step();
-    pulse2.step();
-    wave.step();
-    noise.step();
+//Runs every frame sequencer step up to timestamp, the channels themselves
+//catch up to each step's time before applying it
+void APU::catchUp(u64 timestamp) {
+    while(next_step <= timestamp) {
+        pulse1.step(next_step);
+        pulse2.step(next_step);
+        wave.step(next_step);
+        noise.step(next_step);
 
-    core.scheduler.addEvent(step_event, 32768 - late);
+        next_step += FRAME_SEQUENCER_PERIOD;
+    }
 }
 
 void APU::sample(u64 late) {
-    s16 sample_l = 0;
-    s16 sample_r = 0;
-    if(bits::get_bit<8>(sndcnt_l)) sample_r += pulse1.amplitude();
-    if(bits::get_bit<9>(sndcnt_l)) sample_r += pulse2.amplitude();
-    if(bits::get_bit<10>(sndcnt_l)) sample_r += wave.amplitude();
-    if(bits::get_bit<11>(sndcnt_l)) sample_r += noise.amplitude();
-    if(bits::get_bit<12>(sndcnt_l)) sample_l += pulse1.amplitude();
-    if(bits::get_bit<13>(sndcnt_l)) sample_l += pulse2.amplitude();
-    if(bits::get_bit<14>(sndcnt_l)) sample_l += wave.amplitude();
-    if(bits::get_bit<15>(sndcnt_l)) sample_l += noise.amplitude();
+    //Every channel has to be read each period to keep its buffer in step, even if it's muted
+    const u64 timestamp = core.scheduler.getCurrentTimestamp() - late;
+    catchUp(timestamp);
+
+    const float pulse1_sample = pulse1.sample(timestamp);
+    const float pulse2_sample = pulse2.sample(timestamp);
+    const float wave_sample = wave.sample(timestamp);
+    const float noise_sample = noise.sample(timestamp);
+
+    float sample_l = 0;
+    float sample_r = 0;
+    if(bits::get_bit<8>(sndcnt_l)) sample_r += pulse1_sample;
+    if(bits::get_bit<9>(sndcnt_l)) sample_r += pulse2_sample;
+    if(bits::get_bit<10>(sndcnt_l)) sample_r += wave_sample;
+    if(bits::get_bit<11>(sndcnt_l)) sample_r += noise_sample;
+    if(bits::get_bit<12>(sndcnt_l)) sample_l += pulse1_sample;
+    if(bits::get_bit<13>(sndcnt_l)) sample_l += pulse2_sample;
+    if(bits::get_bit<14>(sndcnt_l)) sample_l += wave_sample;
+    if(bits::get_bit<15>(sndcnt_l)) sample_l += noise_sample;
     
-    sample_r *= 1 + (sndcnt_l & 7);
-    sample_l *= 1 + ((sndcnt_l >> 4) & 7);
-    int volume_shift = 2 - bits::get<0, 2>(sndcnt_h);
-    if(volume_shift != 3) {
-        sample_r >>= volume_shift;
-        sample_l >>= volume_shift;
-    }
+    sample_r *= (1 + (sndcnt_l & 7)) * PSG_VOLUME[bits::get<0, 2>(sndcnt_h)];
+    sample_l *= (1 + ((sndcnt_l >> 4) & 7)) * PSG_VOLUME[bits::get<0, 2>(sndcnt_h)];
 
     if(bits::get_bit<8>(sndcnt_h)) sample_r += fifo_sample_a << bits::get_bit<2>(sndcnt_h);
     if(bits::get_bit<9>(sndcnt_h)) sample_l += fifo_sample_a << bits::get_bit<2>(sndcnt_h);
@@ -220,9 +250,35 @@ void APU::sample(u64 late) {
     sample_r += bits::get<0, 9>(sndbias);
     sample_l += bits::get<0, 9>(sndbias);
 
-    core.audio_device.pushSample(sample_l / (float)0x800, sample_r / (float)0x800);
+    sample_block[block_fill * 2 + 0] = sample_l / 0x800;
+    sample_block[block_fill * 2 + 1] = sample_r / 0x800;
+
+    if(++block_fill >= block_size) {
+        flushSamples();
+    }
 
     core.scheduler.addEvent(sample_event, (512 >> bits::get<14, 2>(sndbias)) - late);
 }
 
+void APU::updateSampleRate() {
+    const u32 period = 512 >> bits::get<14, 2>(sndbias);
+    pulse1.setSamplePeriod(period);
+    pulse2.setSamplePeriod(period);
+    wave.setSamplePeriod(period);
+    noise.setSamplePeriod(period);
+
+    block_size = (1232 << bits::get<14, 2>(sndbias)) / 512;
+    core.audio_device.setSampleRate(bits::get<14, 2>(sndbias));
+}
+
+void APU::flushSamples() {
+    if(block_fill != 0) {
+        if(output_enabled) {
+            core.audio_device.pushSamples(sample_block, block_fill);
+        }
+
+        block_fill = 0;
+    }
+}
+
 } //namespace emu
\ No newline at end of file
@@ -4,8 +4,8 @@
 #include "channels/WaveChannel.hpp"
 #include "channels/NoiseChannel.hpp"
 #include "common/Types.hpp"
+#include "common/Serializer.hpp"
 #include <deque>
-#include <fstream>
 
 
 namespace emu {
@@ -18,8 +18,9 @@ public:
     explicit APU(GBA &core);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
+    void setOutputEnabled(bool enabled);
 
     auto read(u32 address) -> u8;
     void write(u32 address, u8 value);
@@ -29,11 +30,17 @@ public:
 
 private:
 
-    void step(u64 late);
+    void catchUp(u64 timestamp);
     void sample(u64 late);
+    void flushSamples();
+    void updateSampleRate();
     
     GBA &core;
-    EventHandle step_event, sample_event;
+    EventHandle sample_event;
+
+    //The frame sequencer isn't scheduled, it's caught up to whenever the APU is accessed
+    static constexpr u32 FRAME_SEQUENCER_PERIOD = 32768;
+    u64 next_step;
 
     PulseChannel pulse1;
     PulseChannel pulse2;
@@ -49,6 +56,12 @@ private:
     std::deque<s8> fifo_a;
     std::deque<s8> fifo_b;
     s8 fifo_sample_a, fifo_sample_b;
+
+    //Samples are handed to the audio device about once per scanline instead of one at a time
+    static constexpr size_t MAX_BLOCK_SIZE = 32;
+    float sample_block[MAX_BLOCK_SIZE * 2];
+    size_t block_size, block_fill;
+    bool output_enabled;
 };
 
 } //namespace emu
\ No newline at end of file
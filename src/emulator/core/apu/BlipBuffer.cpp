@@ -0,0 +1,103 @@
+#include "BlipBuffer.hpp"
+#include <cmath>
+#include <cstring>
+
+
+namespace emu {
+
+BlipBuffer::StepKernel::StepKernel() {
+    const double pi = 3.14159265358979323846;
+
+    for(size_t phase = 0; phase < PHASES; phase++) {
+        const double fraction = phase / static_cast<double>(PHASES);
+        double impulse[WIDTH];
+        double sum = 0;
+
+        for(size_t i = 0; i < WIDTH; i++) {
+            //Slightly below the output's Nyquist limit to leave room for the window's transition band
+            const double x = (static_cast<double>(i) - (WIDTH / 2 - 1) - fraction) * 0.9;
+            const double sinc = x == 0 ? 1.0 : std::sin(pi * x) / (pi * x);
+
+            //Blackman window across all of the taps
+            const double w = (i + 1 - fraction) / WIDTH;
+            const double window = 0.42 - 0.5 * std::cos(2 * pi * w) + 0.08 * std::cos(4 * pi * w);
+
+            impulse[i] = sinc * window;
+            sum += impulse[i];
+        }
+
+        //Every phase has to add up to exactly UNIT, otherwise the integrated
+        //output would slowly drift, so the rounding error goes in the middle tap
+        s32 total = 0;
+        for(size_t i = 0; i < WIDTH; i++) {
+            taps[phase][i] = static_cast<s32>(std::lround(impulse[i] / sum * UNIT));
+            total += taps[phase][i];
+        }
+
+        taps[phase][WIDTH / 2] += UNIT - total;
+    }
+}
+
+auto BlipBuffer::getKernel() -> const StepKernel& {
+    static const StepKernel kernel;
+    return kernel;
+}
+
+BlipBuffer::BlipBuffer() {
+    period = 512;
+    reset(0);
+}
+
+void BlipBuffer::reset(u64 timestamp) {
+    std::memset(buffer, 0, sizeof(buffer));
+    read_index = 0;
+    accumulator = 0;
+    last_read = timestamp;
+}
+
+void BlipBuffer::serialize(common::Serializer &serializer) {
+    serializer.write(buffer);
+    serializer.write(read_index);
+    serializer.write(accumulator);
+    serializer.write(last_read);
+}
+
+void BlipBuffer::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(buffer);
+    deserializer.read(read_index);
+    deserializer.read(accumulator);
+    deserializer.read(last_read);
+}
+
+//Number of cycles between output samples
+void BlipBuffer::setPeriod(u32 cycles) {
+    period = cycles;
+}
+
+void BlipBuffer::addDelta(u64 timestamp, s32 delta) {
+    const u64 offset = timestamp > last_read ? timestamp - last_read : 0;
+    const u32 phase = (offset % period) * PHASES / period;
+    u32 index = read_index + static_cast<u32>(offset / period);
+
+    //Samples are normally read once per period, this only matters if that falls far behind
+    if(offset / period > SIZE - WIDTH) {
+        index = read_index + SIZE - WIDTH;
+    }
+
+    const s32 *taps = getKernel().taps[phase];
+    for(size_t i = 0; i < WIDTH; i++) {
+        buffer[(index + i) % SIZE] += taps[i] * delta;
+    }
+}
+
+//Reads the next sample, which should include every delta up to timestamp
+auto BlipBuffer::readSample(u64 timestamp) -> float {
+    accumulator += buffer[read_index];
+    buffer[read_index] = 0;
+    read_index = (read_index + 1) % SIZE;
+    last_read = timestamp;
+
+    return accumulator / static_cast<float>(UNIT);
+}
+
+} //namespace emu
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common/Types.hpp"
+#include "common/Serializer.hpp"
+
+
+namespace emu {
+
+/*
+ * Band-limited step synthesis for the PSG channels. Instead of point sampling
+ * a channel's output, every change in its amplitude is recorded as a delta at
+ * the exact cycle it happened on, and spread across the surrounding output
+ * samples using a windowed-sinc step. Reading a sample then just integrates the
+ * deltas, so square waves come out without aliasing at any sample rate.
+ */
+class BlipBuffer final {
+public:
+
+    BlipBuffer();
+
+    void reset(u64 timestamp);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
+
+    void setPeriod(u32 cycles);
+    void addDelta(u64 timestamp, s32 delta);
+    auto readSample(u64 timestamp) -> float;
+
+private:
+
+    static constexpr size_t WIDTH = 16;
+    static constexpr size_t PHASES = 32;
+    static constexpr size_t SIZE = 64;
+    static constexpr s32 UNIT = 1 << 15;
+
+    //Shared by all buffers, only depends on the constants above
+    struct StepKernel {
+        StepKernel();
+        s32 taps[PHASES][WIDTH];
+    };
+
+    static auto getKernel() -> const StepKernel&;
+
+    s32 buffer[SIZE];
+    u32 read_index;
+    s32 accumulator;
+    u64 last_read;
+    u32 period;
+};
+
+} //namespace emu
\ No newline at end of file
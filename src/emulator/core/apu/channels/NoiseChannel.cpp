@@ -1,41 +1,107 @@
 #include "NoiseChannel.hpp"
 #include "common/Bits.hpp"
-#include "common/Log.hpp"
+#include <algorithm>
 
 
 namespace emu {
 
-NoiseChannel::NoiseChannel(Scheduler &scheduler) : scheduler(scheduler) {
-    frequency_event = scheduler.registerEvent([this](u64 late) { tick(late); });
-    LOG_DEBUG("Noise channel has event handle: {}", frequency_event);
+//The LFSR is linear, so it can be moved ahead any number of steps at once by
+//combining precomputed jumps of 2^k steps, one for each bit of the count
+struct LfsrJumps {
+    LfsrJumps() {
+        for(int width = 0; width < 2; width++) {
+            const u16 taps = width == 0 ? 0x6000 : 0x60;
+
+            for(int bit = 0; bit < 15; bit++) {
+                const u16 lfsr = 1 << bit;
+                columns[width][0][bit] = (lfsr >> 1) ^ (lfsr & 1 ? taps : 0);
+            }
+
+            for(int k = 1; k < 64; k++) {
+                for(int bit = 0; bit < 15; bit++) {
+                    columns[width][k][bit] = apply(columns[width][k - 1], columns[width][k - 1][bit]);
+                }
+            }
+        }
+    }
+
+    //Each column is where one bit of the LFSR ends up after the jump
+    static auto apply(const u16 *jump, u16 lfsr) -> u16 {
+        u16 result = 0;
+
+        for(int bit = 0; bit < 15; bit++) {
+            if((lfsr >> bit) & 1) {
+                result ^= jump[bit];
+            }
+        }
+
+        return result;
+    }
+
+    auto advance(bool short_width, u16 lfsr, u64 steps) const -> u16 {
+        for(int k = 0; steps != 0; k++, steps >>= 1) {
+            if(steps & 1) {
+                lfsr = apply(columns[short_width][k], lfsr);
+            }
+        }
+
+        return lfsr;
+    }
+
+    u16 columns[2][64][15];
+};
+
+static auto getLfsrJumps() -> const LfsrJumps& {
+    static const LfsrJumps jumps;
+    return jumps;
 }
 
+NoiseChannel::NoiseChannel(Scheduler &scheduler) : scheduler(scheduler) { }
+
 void NoiseChannel::reset() {
     snd4cnt_l = 0;
     snd4cnt_h = 0;
     enabled = false;
+    current_vol = 0;
+    envelope_timer = 0;
+    length_timer = 0;
+    lfsr = 0;
+    high = false;
+
+    last_update = scheduler.getCurrentTimestamp();
+    next_tick = 0;
+    last_output = 0;
+    blip.reset(last_update);
 }
 
-void NoiseChannel::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&snd4cnt_l), sizeof(snd4cnt_l));
-    file.write(reinterpret_cast<const char*>(&snd4cnt_h), sizeof(snd4cnt_h));
-    file.write(reinterpret_cast<const char*>(&enabled), sizeof(enabled));
-    file.write(reinterpret_cast<const char*>(&current_vol), sizeof(current_vol));
-    file.write(reinterpret_cast<const char*>(&envelope_timer), sizeof(envelope_timer));
-    file.write(reinterpret_cast<const char*>(&length_timer), sizeof(length_timer));
-    file.write(reinterpret_cast<const char*>(&lfsr), sizeof(lfsr));
-    file.write(reinterpret_cast<const char*>(&high), sizeof(high));
+void NoiseChannel::serialize(common::Serializer &serializer) {
+    serializer.write(snd4cnt_l);
+    serializer.write(snd4cnt_h);
+    serializer.write(enabled);
+    serializer.write(current_vol);
+    serializer.write(envelope_timer);
+    serializer.write(length_timer);
+    serializer.write(lfsr);
+    serializer.write(high);
+    serializer.write(last_update);
+    serializer.write(next_tick);
+    serializer.write(last_output);
+    blip.serialize(serializer);
 }
 
-void NoiseChannel::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&snd4cnt_l), sizeof(snd4cnt_l));
-    file.read(reinterpret_cast<char*>(&snd4cnt_h), sizeof(snd4cnt_h));
-    file.read(reinterpret_cast<char*>(&enabled), sizeof(enabled));
-    file.read(reinterpret_cast<char*>(&current_vol), sizeof(current_vol));
-    file.read(reinterpret_cast<char*>(&envelope_timer), sizeof(envelope_timer));
-    file.read(reinterpret_cast<char*>(&length_timer), sizeof(length_timer));
-    file.read(reinterpret_cast<char*>(&lfsr), sizeof(lfsr));
-    file.read(reinterpret_cast<char*>(&high), sizeof(high));
+void NoiseChannel::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(snd4cnt_l);
+    deserializer.read(snd4cnt_h);
+    deserializer.read(enabled);
+    deserializer.read(current_vol);
+    deserializer.read(envelope_timer);
+    deserializer.read(length_timer);
+    deserializer.read(lfsr);
+    deserializer.read(high);
+    deserializer.read(last_update);
+    deserializer.read(next_tick);
+    deserializer.read(last_output);
+    blip.deserialize(deserializer);
 }
 
 auto NoiseChannel::read(u32 address) -> u8 {
@@ -50,6 +116,8 @@ auto NoiseChannel::read(u32 address) -> u8 {
 }
 
 void NoiseChannel::write(u32 address, u8 value) {
+    update(scheduler.getCurrentTimestamp());
+
     switch(address) {
         case 0x78 : snd4cnt_l = (snd4cnt_l & 0xFF00) | value; break;
         case 0x79 : snd4cnt_l = (snd4cnt_l & 0x00FF) | (value << 8); break;
@@ -61,9 +129,26 @@ void NoiseChannel::write(u32 address, u8 value) {
             }
             break;
     }
+
+    output(last_update);
+}
+
+void NoiseChannel::setSamplePeriod(u32 cycles) {
+    blip.setPeriod(cycles);
+}
+
+auto NoiseChannel::sample(u64 timestamp) -> float {
+    update(timestamp);
+    return blip.readSample(timestamp);
+}
+
+auto NoiseChannel::isEnabled() -> bool {
+    return enabled;
 }
 
-void NoiseChannel::step() {
+void NoiseChannel::step(u64 timestamp) {
+    update(timestamp);
+
     if(bits::get_bit<14>(snd4cnt_h) && length_timer > 0 && --length_timer == 0) {
         enabled = false;
     }
@@ -84,6 +169,8 @@ void NoiseChannel::step() {
             }
         }
     }
+
+    output(last_update);
 }
 
 auto NoiseChannel::amplitude() -> s8 {
@@ -94,19 +181,45 @@ auto NoiseChannel::amplitude() -> s8 {
     return 0;
 }
 
-void NoiseChannel::tick(u64 late) {
-    bool carry = lfsr & 1;
-    high = carry;
-    lfsr >>= 1;
+//Runs the LFSR up to timestamp, nothing changes while the channel is disabled.
+//Any step can flip the output, so they're only skipped over all at once
+//while the channel is silent, leaving the LFSR one step short to know the last bit out
+void NoiseChannel::update(u64 timestamp) {
+    if(enabled && next_tick <= timestamp) {
+        const u8 r = bits::get<0, 4>(snd4cnt_h);
+        const u64 period = (r == 0 ? 16 : r * 32) << (bits::get<4, 4>(snd4cnt_h) + 1);
+
+        if(amplitude() == 0) {
+            const u64 ticks = (timestamp - next_tick) / period;
+            lfsr = getLfsrJumps().advance(bits::get_bit<3>(snd4cnt_h), lfsr, ticks);
+            next_tick += ticks * period;
+        }
+
+        while(next_tick <= timestamp) {
+            bool carry = lfsr & 1;
+            high = carry;
+            lfsr >>= 1;
 
-    if(carry) {
-        lfsr ^= bits::get_bit<3>(snd4cnt_h) ? 0x60 : 0x6000;
+            if(carry) {
+                lfsr ^= bits::get_bit<3>(snd4cnt_h) ? 0x60 : 0x6000;
+            }
+
+            output(next_tick);
+            next_tick += period;
+        }
     }
 
-    u8 r = bits::get<0, 4>(snd4cnt_h);
-    const u32 frequency = (r == 0 ? 16 : r * 32) << (bits::get<4, 4>(snd4cnt_h) + 1);
+    last_update = std::max(last_update, timestamp);
+}
 
-    scheduler.addEvent(frequency_event, frequency - late);
+//Records a change in amplitude since the last call
+void NoiseChannel::output(u64 timestamp) {
+    const s8 value = amplitude();
+
+    if(value != last_output) {
+        blip.addDelta(timestamp, value - last_output);
+        last_output = value;
+    }
 }
 
 void NoiseChannel::restart() {
@@ -120,8 +233,7 @@ void NoiseChannel::restart() {
     u32 frequency = 32 << (bits::get<4, 4>(snd4cnt_h) + 1);
     frequency = r == 0 ? frequency / 2 : frequency * r;
 
-    scheduler.removeEvent(frequency_event);
-    scheduler.addEvent(frequency_event, frequency);
+    next_tick = last_update + frequency;
 }
 
 } //namespace emu
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "PulseChannel.hpp"
 #include "common/Bits.hpp"
-#include "common/Log.hpp"
+#include <algorithm>
 
 //12.5% |-_______-_______|
 //25.0% |--______--______|
@@ -18,42 +18,52 @@ static constexpr s8 WAVE_DUTY[4][8] = {
 
 namespace emu {
 
-PulseChannel::PulseChannel(Scheduler &scheduler) : scheduler(scheduler) {
-    frequency_event = scheduler.registerEvent([this](u64 late) { tick(late); });
-    LOG_DEBUG("Pulse channel has event handle: {}", frequency_event);
-}
+PulseChannel::PulseChannel(Scheduler &scheduler) : scheduler(scheduler) { }
 
 void PulseChannel::reset() {
     sndcnt_h = 0;
     sndcnt_l = 0;
     sndcnt_x = 0;
     enabled = false;
+
+    last_update = scheduler.getCurrentTimestamp();
+    next_tick = 0;
+    last_output = 0;
+    blip.reset(last_update);
 }
 
-void PulseChannel::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&sndcnt_l), sizeof(sndcnt_l));
-    file.write(reinterpret_cast<const char*>(&sndcnt_h), sizeof(sndcnt_h));
-    file.write(reinterpret_cast<const char*>(&sndcnt_x), sizeof(sndcnt_x));
-    file.write(reinterpret_cast<const char*>(&enabled), sizeof(enabled));
-    file.write(reinterpret_cast<const char*>(&wave_duty_pos), sizeof(wave_duty_pos));
-    file.write(reinterpret_cast<const char*>(&current_vol), sizeof(current_vol));
-    file.write(reinterpret_cast<const char*>(&envelope_timer), sizeof(envelope_timer));
-    file.write(reinterpret_cast<const char*>(&length_timer), sizeof(length_timer));
-    file.write(reinterpret_cast<const char*>(&shadow_freq), sizeof(shadow_freq));
-    file.write(reinterpret_cast<const char*>(&sweep_timer), sizeof(sweep_timer));
+void PulseChannel::serialize(common::Serializer &serializer) {
+    serializer.write(sndcnt_l);
+    serializer.write(sndcnt_h);
+    serializer.write(sndcnt_x);
+    serializer.write(enabled);
+    serializer.write(wave_duty_pos);
+    serializer.write(current_vol);
+    serializer.write(envelope_timer);
+    serializer.write(length_timer);
+    serializer.write(shadow_freq);
+    serializer.write(sweep_timer);
+    serializer.write(last_update);
+    serializer.write(next_tick);
+    serializer.write(last_output);
+    blip.serialize(serializer);
 }
 
-void PulseChannel::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&sndcnt_l), sizeof(sndcnt_l));
-    file.read(reinterpret_cast<char*>(&sndcnt_h), sizeof(sndcnt_h));
-    file.read(reinterpret_cast<char*>(&sndcnt_x), sizeof(sndcnt_x));
-    file.read(reinterpret_cast<char*>(&enabled), sizeof(enabled));
-    file.read(reinterpret_cast<char*>(&wave_duty_pos), sizeof(wave_duty_pos));
-    file.read(reinterpret_cast<char*>(&current_vol), sizeof(current_vol));
-    file.read(reinterpret_cast<char*>(&envelope_timer), sizeof(envelope_timer));
-    file.read(reinterpret_cast<char*>(&length_timer), sizeof(length_timer));
-    file.read(reinterpret_cast<char*>(&shadow_freq), sizeof(shadow_freq));
-    file.read(reinterpret_cast<char*>(&sweep_timer), sizeof(sweep_timer));
+void PulseChannel::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(sndcnt_l);
+    deserializer.read(sndcnt_h);
+    deserializer.read(sndcnt_x);
+    deserializer.read(enabled);
+    deserializer.read(wave_duty_pos);
+    deserializer.read(current_vol);
+    deserializer.read(envelope_timer);
+    deserializer.read(length_timer);
+    deserializer.read(shadow_freq);
+    deserializer.read(sweep_timer);
+    deserializer.read(last_update);
+    deserializer.read(next_tick);
+    deserializer.read(last_output);
+    blip.deserialize(deserializer);
 }
 
 auto PulseChannel::read(u32 address) -> u8 {
@@ -73,7 +83,9 @@ auto PulseChannel::read(u32 address) -> u8 {
 }
 
 void PulseChannel::write(u32 address, u8 value) {
-        switch(address) {
+    update(scheduler.getCurrentTimestamp());
+
+    switch(address) {
         case 0x60 : sndcnt_l = value & 0x7F; break;
 
         case 0x62 :
@@ -90,8 +102,20 @@ void PulseChannel::write(u32 address, u8 value) {
             }
             break;
     }
+
+    output(last_update);
 }
 
+void PulseChannel::setSamplePeriod(u32 cycles) {
+    blip.setPeriod(cycles);
+}
+
+auto PulseChannel::sample(u64 timestamp) -> float {
+    update(timestamp);
+    return blip.readSample(timestamp);
+}
+
+
 auto PulseChannel::amplitude() -> s8 {
     if(enabled && bits::get<11, 5>(sndcnt_h) != 0) {
         return WAVE_DUTY[bits::get<6, 2>(sndcnt_h)][wave_duty_pos] * current_vol;
@@ -100,7 +124,13 @@ auto PulseChannel::amplitude() -> s8 {
     return 0;
 }
 
-void PulseChannel::step() {
+auto PulseChannel::isEnabled() -> bool {
+    return enabled;
+}
+
+void PulseChannel::step(u64 timestamp) {
+    update(timestamp);
+
     if(bits::get_bit<14>(sndcnt_x) && length_timer > 0 && --length_timer == 0) {
         enabled = false;
     }
@@ -158,14 +188,44 @@ void PulseChannel::step() {
             }
         }
     }
+
+    output(last_update);
 }
 
-void PulseChannel::tick(u64 late) {
-    wave_duty_pos = (wave_duty_pos + 1) % 8;
-    const u16 frequency = (2048 - shadow_freq) * 16;
+//Runs the duty cycle up to timestamp, nothing changes while the channel is disabled.
+//Only two of the eight duty steps change the output, so this jumps straight from
+//one of those to the next, or over all of them while the channel is silent
+void PulseChannel::update(u64 timestamp) {
+    if(enabled && next_tick <= timestamp) {
+        const u64 period = (2048 - shadow_freq) * 16;
+        const s8 *duty = WAVE_DUTY[bits::get<6, 2>(sndcnt_h)];
+        const bool silent = amplitude() == 0;
+        u64 remaining = (timestamp - next_tick) / period + 1;
+
+        while(remaining > 0) {
+            u64 ticks = 1;
+            while(!silent && duty[(wave_duty_pos + ticks) % 8] == duty[wave_duty_pos]) {
+                ticks++;
+            }
 
-    if(enabled) {
-        scheduler.addEvent(frequency_event, frequency - late);
+            ticks = silent ? remaining : std::min(ticks, remaining);
+            wave_duty_pos = (wave_duty_pos + ticks) % 8;
+            next_tick += ticks * period;
+            remaining -= ticks;
+            output(next_tick - period);
+        }
+    }
+
+    last_update = std::max(last_update, timestamp);
+}
+
+//Records a change in amplitude since the last call
+void PulseChannel::output(u64 timestamp) {
+    const s8 value = amplitude();
+
+    if(value != last_output) {
+        blip.addDelta(timestamp, value - last_output);
+        last_output = value;
     }
 }
 
@@ -178,12 +238,9 @@ void PulseChannel::restart() {
     envelope_timer = bits::get<8, 3>(sndcnt_h) * 8;
     shadow_freq = bits::get<0, 11>(sndcnt_x);
     sweep_timer = bits::get<4, 3>(sndcnt_l) * 4;
-    const u16 frequency = (2048 - shadow_freq) * 16;
+    next_tick = last_update + (2048 - shadow_freq) * 16;
 
     //TODO: Sweep overflow check if sweep time is not zero (i.e. is enabled)
-
-    scheduler.removeEvent(frequency_event);
-    scheduler.addEvent(frequency_event, frequency);
 }
 
 } //namespace emu
\ No newline at end of file
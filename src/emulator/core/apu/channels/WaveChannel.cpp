@@ -1,6 +1,6 @@
 #include "WaveChannel.hpp"
 #include "common/Bits.hpp"
-#include "common/Log.hpp"
+#include <algorithm>
 #include <cstring>
 
 static constexpr u8 VOLUMES[4] = {0, 4, 2, 1};
@@ -8,10 +8,7 @@ static constexpr u8 VOLUMES[4] = {0, 4, 2, 1};
 
 namespace emu {
 
-WaveChannel::WaveChannel(Scheduler &scheduler) : scheduler(scheduler) {
-    sample_event = scheduler.registerEvent([this](u64 late) { sample(late); });
-    LOG_DEBUG("Wave channel has event handle: {}", sample_event);
-}
+WaveChannel::WaveChannel(Scheduler &scheduler) : scheduler(scheduler) { }
 
 void WaveChannel::reset() {
     snd3cnt_l = 0;
@@ -19,26 +16,39 @@ void WaveChannel::reset() {
     snd3cnt_x = 0;
     std::memset(wave_ram, 0, sizeof(wave_ram));
     enabled = false;
+
+    last_update = scheduler.getCurrentTimestamp();
+    next_tick = 0;
+    last_output = 0;
+    blip.reset(last_update);
 }
 
-void WaveChannel::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&snd3cnt_l), sizeof(snd3cnt_l));
-    file.write(reinterpret_cast<const char*>(&snd3cnt_h), sizeof(snd3cnt_h));
-    file.write(reinterpret_cast<const char*>(&snd3cnt_x), sizeof(snd3cnt_x));
-    file.write(reinterpret_cast<const char*>(&enabled), sizeof(enabled));
-    file.write(reinterpret_cast<const char*>(&length_timer), sizeof(length_timer));
-    file.write(reinterpret_cast<const char*>(&wave_pos), sizeof(wave_pos));
-    file.write(reinterpret_cast<const char*>(wave_ram), sizeof(wave_ram));
+void WaveChannel::serialize(common::Serializer &serializer) {
+    serializer.write(snd3cnt_l);
+    serializer.write(snd3cnt_h);
+    serializer.write(snd3cnt_x);
+    serializer.write(enabled);
+    serializer.write(length_timer);
+    serializer.write(wave_pos);
+    serializer.write(wave_ram);
+    serializer.write(last_update);
+    serializer.write(next_tick);
+    serializer.write(last_output);
+    blip.serialize(serializer);
 }
 
-void WaveChannel::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&snd3cnt_l), sizeof(snd3cnt_l));
-    file.read(reinterpret_cast<char*>(&snd3cnt_h), sizeof(snd3cnt_h));
-    file.read(reinterpret_cast<char*>(&snd3cnt_x), sizeof(snd3cnt_x));
-    file.read(reinterpret_cast<char*>(&enabled), sizeof(enabled));
-    file.read(reinterpret_cast<char*>(&length_timer), sizeof(length_timer));
-    file.read(reinterpret_cast<char*>(&wave_pos), sizeof(wave_pos));
-    file.read(reinterpret_cast<char*>(wave_ram), sizeof(wave_ram));
+void WaveChannel::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(snd3cnt_l);
+    deserializer.read(snd3cnt_h);
+    deserializer.read(snd3cnt_x);
+    deserializer.read(enabled);
+    deserializer.read(length_timer);
+    deserializer.read(wave_pos);
+    deserializer.read(wave_ram);
+    deserializer.read(last_update);
+    deserializer.read(next_tick);
+    deserializer.read(last_output);
+    blip.deserialize(deserializer);
 }
 
 auto WaveChannel::read(u32 address) -> u8 {
@@ -56,6 +66,8 @@ auto WaveChannel::read(u32 address) -> u8 {
 }
 
 void WaveChannel::write(u32 address, u8 value) {
+    update(scheduler.getCurrentTimestamp());
+
     switch(address) {
         case 0x70 : snd3cnt_l = value & 0xE0; break;
 
@@ -72,8 +84,20 @@ void WaveChannel::write(u32 address, u8 value) {
     if(address >= 0x90 && address <= 0x9F) {
         wave_ram[(address - 0x90) + bits::get_bit<6>(~snd3cnt_l) * 16] = value;
     }
+
+    output(last_update);
+}
+
+void WaveChannel::setSamplePeriod(u32 cycles) {
+    blip.setPeriod(cycles);
 }
 
+auto WaveChannel::sample(u64 timestamp) -> float {
+    update(timestamp);
+    return blip.readSample(timestamp);
+}
+
+
 auto WaveChannel::amplitude() -> u8 {
     if(enabled && !bits::get_bit<7>(snd3cnt_l)) {
         u8 wave_index = wave_pos;
@@ -97,17 +121,53 @@ auto WaveChannel::amplitude() -> u8 {
     }
 }
 
-void WaveChannel::step() {
+auto WaveChannel::isEnabled() -> bool {
+    return enabled;
+}
+
+void WaveChannel::step(u64 timestamp) {
+    update(timestamp);
+
     if(bits::get_bit<14>(snd3cnt_x) && length_timer > 0 && --length_timer == 0) {
         enabled = false;
     }
+
+    output(last_update);
 }
 
-void WaveChannel::sample(u64 late) {
-    const u32 sample_rate = (2048 - bits::get<0, 11>(snd3cnt_x)) * 8;
-    wave_pos = (wave_pos + 1) % (bits::get_bit<5>(snd3cnt_l) ? 64 : 32);
+//Runs the wave position up to timestamp, nothing changes while the channel is disabled.
+//Any tick can read a different sample, so they're only skipped over all at once
+//while the channel is muted or at zero volume
+void WaveChannel::update(u64 timestamp) {
+    if(enabled && next_tick <= timestamp) {
+        const u64 period = (2048 - bits::get<0, 11>(snd3cnt_x)) * 8;
+        const u8 length = bits::get_bit<5>(snd3cnt_l) ? 64 : 32;
+        const bool silent = bits::get_bit<7>(snd3cnt_l) || (VOLUMES[bits::get<13, 2>(snd3cnt_h)] == 0 && !bits::get_bit<15>(snd3cnt_h));
+
+        if(silent) {
+            const u64 ticks = (timestamp - next_tick) / period + 1;
+            wave_pos = (wave_pos + ticks) % length;
+            next_tick += ticks * period;
+        }
+
+        while(next_tick <= timestamp) {
+            wave_pos = (wave_pos + 1) % length;
+            output(next_tick);
+            next_tick += period;
+        }
+    }
 
-    scheduler.addEvent(sample_event, sample_rate - late);
+    last_update = std::max(last_update, timestamp);
+}
+
+//Records a change in amplitude since the last call
+void WaveChannel::output(u64 timestamp) {
+    const s8 value = amplitude();
+
+    if(value != last_output) {
+        blip.addDelta(timestamp, value - last_output);
+        last_output = value;
+    }
 }
 
 void WaveChannel::restart() {
@@ -115,10 +175,7 @@ void WaveChannel::restart() {
 
     length_timer = (256 - (snd3cnt_l & 0xFF)) * 2;
     wave_pos = 0;
-    const u32 sample_rate = (2048 - bits::get<0, 11>(snd3cnt_x)) * 8;
-
-    scheduler.removeEvent(sample_event);
-    scheduler.addEvent(sample_event, sample_rate);
+    next_tick = last_update + (2048 - bits::get<0, 11>(snd3cnt_x)) * 8;
 }
 
 } //namespace emu
\ No newline at end of file
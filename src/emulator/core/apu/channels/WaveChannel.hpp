@@ -1,8 +1,9 @@
 #pragma once
 
+#include "emulator/core/apu/BlipBuffer.hpp"
 #include "emulator/core/Scheduler.hpp"
 #include "common/Types.hpp"
-#include <fstream>
+#include "common/Serializer.hpp"
 
 
 namespace emu {
@@ -13,18 +14,22 @@ public:
     explicit WaveChannel(Scheduler &scheduler);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
 
     auto read(u32 address) -> u8;
     void write(u32 address, u8 value);
 
-    auto amplitude() -> u8;
-    void step();
+    void setSamplePeriod(u32 cycles);
+    auto sample(u64 timestamp) -> float;
+    void step(u64 timestamp);
+    auto isEnabled() -> bool;
 
 private:
 
-    void sample(u64 late);
+    void update(u64 timestamp);
+    void output(u64 timestamp);
+    auto amplitude() -> u8;
     void restart();
     
     u8 snd3cnt_l;  //NR30
@@ -36,8 +41,13 @@ private:
     u16 length_timer;
     u8 wave_pos;
 
+    //The channel is only run when its output is needed or its registers change
+    u64 last_update;
+    u64 next_tick;
+    s8 last_output;
+    BlipBuffer blip;
+
     Scheduler &scheduler;
-    EventHandle sample_event;
 };
 
 } //namespace emu
\ No newline at end of file
@@ -5,10 +5,22 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Log.hpp"
 #include "common/Bits.hpp"
+#include "common/Hash.hpp"
+#include "common/Trace.hpp"
+
+static const common::trace::EventId TRACE_INTERRUPT = common::trace::define_event("interrupt", "pc {:08X} sources {:04X}");
 
 
 namespace emu {
 
+//Restores the exact bits, an SPSR that was never written keeps a mode of 0
+static void readStatusRegister(common::Deserializer &deserializer, StatusRegister &reg) {
+    u32 value = 0;
+    deserializer.read(value);
+    reg.fromInt(value);
+    reg.mode = bits::get<0, 5>(value);
+}
+
 CPU::CPU(GBA &core) : core(core) {
     setupRegisterBanks();
     reset();
@@ -30,37 +42,50 @@ void CPU::reset(bool skip_bios) {
     state.pc = skip_bios ? 0x08000000 : 0;
 }
 
-void CPU::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(state.pipeline), sizeof(state.pipeline));
-    file.write(reinterpret_cast<const char*>(state.regs), sizeof(state.regs));
-    file.write(reinterpret_cast<const char*>(state.banked_regs), sizeof(state.banked_regs));
-    file.write(reinterpret_cast<const char*>(state.fiq_regs), sizeof(state.fiq_regs));
-    file.write(reinterpret_cast<const char*>(&state.pc), sizeof(state.pc));
-    file.write(reinterpret_cast<const char*>(&state.cpsr), sizeof(state.cpsr));
-    file.write(reinterpret_cast<const char*>(state.spsr), sizeof(state.spsr));
-    file.write(reinterpret_cast<const char*>(&state.halted), sizeof(state.halted));
+void CPU::serialize(common::Serializer &serializer) {
+    serializer.write(state.pipeline);
+    serializer.write(state.regs);
+    serializer.write(state.banked_regs);
+    serializer.write(state.fiq_regs);
+    serializer.write(state.pc);
+    serializer.write(state.cpsr.asInt());
+    for(const auto &spsr : state.spsr) {
+        serializer.write(spsr.asInt());
+    }
+    serializer.write(state.halted);
     
-    file.write(reinterpret_cast<const char*>(&int_enable), sizeof(int_enable));
+    serializer.write(int_enable);
     u16 int_flag_val = int_flag.load();
-    file.write(reinterpret_cast<const char*>(&int_flag_val), sizeof(int_flag_val));
-    file.write(reinterpret_cast<const char*>(&master_enable), sizeof(master_enable));
+    serializer.write(int_flag_val);
+    serializer.write(master_enable);
 }
 
-void CPU::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(state.pipeline), sizeof(state.pipeline));
-    file.read(reinterpret_cast<char*>(state.regs), sizeof(state.regs));
-    file.read(reinterpret_cast<char*>(state.banked_regs), sizeof(state.banked_regs));
-    file.read(reinterpret_cast<char*>(state.fiq_regs), sizeof(state.fiq_regs));
-    file.read(reinterpret_cast<char*>(&state.pc), sizeof(state.pc));
-    file.read(reinterpret_cast<char*>(&state.cpsr), sizeof(state.cpsr));
-    file.read(reinterpret_cast<char*>(state.spsr), sizeof(state.spsr));
-    file.read(reinterpret_cast<char*>(&state.halted), sizeof(state.halted));
+void CPU::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(state.pipeline);
+    deserializer.read(state.regs);
+    deserializer.read(state.banked_regs);
+    deserializer.read(state.fiq_regs);
+    deserializer.read(state.pc);
+    readStatusRegister(deserializer, state.cpsr);
+    for(auto &spsr : state.spsr) {
+        readStatusRegister(deserializer, spsr);
+    }
+    deserializer.read(state.halted);
     
-    file.read(reinterpret_cast<char*>(&int_enable), sizeof(int_enable));
+    deserializer.read(int_enable);
     u16 int_flag_val = 0;
-    file.read(reinterpret_cast<char*>(&int_flag_val), sizeof(int_flag_val));
+    deserializer.read(int_flag_val);
     int_flag.store(int_flag_val);
-    file.read(reinterpret_cast<char*>(&master_enable), sizeof(master_enable));
+    deserializer.read(master_enable);
+}
+
+//Hashed in the save state's layout, which is the same on any host
+void CPU::hashState(StateHashes &hashes) {
+    std::vector<u8> registers;
+    common::MemorySerializer serializer(registers);
+    serialize(serializer);
+
+    hashes.values[StateHashes::HASH_CPU] = common::hash64(registers.data(), registers.size());
 }
 
 void CPU::halt() {
@@ -248,6 +273,7 @@ auto CPU::service_interrupt() -> bool {
     if(interrupts != 0) {
         //Sources
         LOG_TRACE("Interrupt serviced at PC: 0x{:08X}, Cycle: {}", state.pc, core.scheduler.getCurrentTimestamp());
+        TRACE_EVENT(TRACE_INTERRUPT, core.scheduler.getCurrentTimestamp(), state.pc, interrupts);
         LOG_TRACE("Sources enabled and requested:");
         for(size_t i = 0; i < 14; i++) {
             if(bits::get_bit(interrupts, i)) {
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "Types.hpp"
+#include "emulator/core/StateHash.hpp"
 #include "common/Types.hpp"
+#include "common/Serializer.hpp"
 #include <atomic>
-#include <fstream>
 
 
 namespace emu {
@@ -20,8 +21,9 @@ public:
     explicit CPU(GBA &core);
 
     void reset(bool skip_bios = true);
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
+    void hashState(StateHashes &hashes);
     void halt();
     auto halted() -> bool;
     void checkForInterrupt();
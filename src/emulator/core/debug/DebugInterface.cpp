@@ -77,6 +77,10 @@ void DebugInterface::setCallback(std::function<void ()> &&callback) {
     on_break = callback;
 }
 
+void DebugInterface::setFrameHashCallback(FrameHashFunc &&callback) {
+    on_frame_hash = callback;
+}
+
 auto DebugInterface::onStep() -> bool {
     u32 pc = core.cpu.state.pc - (core.cpu.state.cpsr.t ? 2 : 4);
 
@@ -115,6 +119,10 @@ void DebugInterface::onVblank() {
     auto now = std::chrono::steady_clock::now();
     frame_times.push((float)(now - frame_start_time).count() / 1'000'000.0f);
     frame_start_time = now;
+
+    if(on_frame_hash) {
+        on_frame_hash(core.ppu.getFrameCount(), core.stateHashes());
+    }
 }
 
 } //namespace emu
\ No newline at end of file
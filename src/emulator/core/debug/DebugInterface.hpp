@@ -1,5 +1,6 @@
 #pragma once
 
+#include "emulator/core/StateHash.hpp"
 #include "common/Buffer.hpp"
 #include "common/Types.hpp"
 #include <unordered_map>
@@ -12,6 +13,7 @@ namespace emu {
 class GBA;
 
 using ConditionFunc = std::function<bool (const GBA &core)>;
+using FrameHashFunc = std::function<void (u64 frame, const StateHashes &hashes)>;
 
 struct Breakpoint {
     u32 address;
@@ -35,6 +37,7 @@ public:
     auto isBreakpointEnabled(u32 address) -> bool;
     auto getBreakpoints() -> std::vector<Breakpoint>;
     void setCallback(std::function<void ()> &&callback);
+    void setFrameHashCallback(FrameHashFunc &&callback);
     auto onStep() -> bool;
 
     auto getCPUUsage() const -> const common::ThreadSafeRingBuffer<float, 100>&;
@@ -51,6 +54,7 @@ private:
     GBA &core;
     std::unordered_map<u32, Breakpoint> breakpoints;
     std::function<void ()> on_break;
+    FrameHashFunc on_frame_hash; //Given the state's hashes at every V-Blank, when set
     bool force_break;
     common::ThreadSafeRingBuffer<float, 100> cpu_usage;
     u64 frame_start_cycle;
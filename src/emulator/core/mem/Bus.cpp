@@ -1,12 +1,15 @@
 #include "Bus.hpp"
 #include "emulator/core/GBA.hpp"
 #include "common/Log.hpp"
+#include "common/Hash.hpp"
+
+constexpr size_t BIOS_SIZE = 16_KiB;
 
 
 namespace emu {
 
 Bus::Bus(GBA &core) : pak(core.scheduler), core(core) {
-    std::memset(bios, 0, sizeof(bios));
+    loadBIOS(std::make_shared<const std::vector<u8>>(BIOS_SIZE, 0));
     reset();
 }
 
@@ -16,20 +19,32 @@ void Bus::reset() {
     bios_open_bus = 0xE129F000;
     std::memset(ewram, 0, sizeof(ewram));
     std::memset(iwram, 0, sizeof(iwram));
+    ewram_pages.markAll();
+    iwram_pages.markAll();
+}
+
+void Bus::serialize(common::Serializer &serializer) {
+    serializer.write(bios_open_bus);
+    serializer.write(waitcnt);
+    serializer.writePages(ewram, ewram_pages);
+    serializer.writePages(iwram, iwram_pages);
+}
+
+void Bus::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(bios_open_bus);
+    deserializer.read(waitcnt);
+    deserializer.readPages(ewram, ewram_pages);
+    deserializer.readPages(iwram, iwram_pages);
 }
 
-void Bus::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&bios_open_bus), sizeof(bios_open_bus));
-    file.write(reinterpret_cast<const char*>(&waitcnt), sizeof(waitcnt));
-    file.write(reinterpret_cast<const char*>(ewram), sizeof(ewram));
-    file.write(reinterpret_cast<const char*>(iwram), sizeof(iwram));
+void Bus::hashState(StateHashes &hashes) {
+    hashes.values[StateHashes::HASH_EWRAM] = common::hash64(ewram, sizeof(ewram));
+    hashes.values[StateHashes::HASH_IWRAM] = common::hash64(iwram, sizeof(iwram));
 }
 
-void Bus::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&bios_open_bus), sizeof(bios_open_bus));
-    file.read(reinterpret_cast<char*>(&waitcnt), sizeof(waitcnt));
-    file.read(reinterpret_cast<char*>(ewram), sizeof(ewram));
-    file.read(reinterpret_cast<char*>(iwram), sizeof(iwram));
+void Bus::clearDirtyPages() {
+    ewram_pages.clear();
+    iwram_pages.clear();
 }
 
 auto Bus::read8(u32 address, AccessType access) -> u8 {
@@ -73,11 +88,16 @@ void Bus::write32(u32 address, u32 value, AccessType access) {
 }
 
 void Bus::loadBIOS(const std::vector<u8> &data) {
-    if(data.size() != sizeof(bios)) {
-        LOG_FATAL("Failed to load BIOS: Invalid Size ({} bytes)!", data.size());
+    loadBIOS(std::make_shared<const std::vector<u8>>(data));
+}
+
+void Bus::loadBIOS(std::shared_ptr<const std::vector<u8>> image) {
+    if(image->size() != BIOS_SIZE) {
+        LOG_FATAL("Failed to load BIOS: Invalid Size ({} bytes)!", image->size());
     }
 
-    std::memcpy(bios, data.data(), sizeof(bios));
+    bios_image = std::move(image);
+    bios = bios_image->data();
 
     //After startup, BIOS reads return the ARM instruction at 0xF4 (open bus).
     bios_open_bus = 0xE129F000;
@@ -113,7 +133,7 @@ auto Bus::read(u32 address, AccessType access) -> T {
     static_assert(sizeof(T) <= 4);
     
     u32 sub_address = bits::align<T>(address) & 0xFFFFFF;
-    u8 *memory_region = nullptr;
+    const u8 *memory_region = nullptr;
     u32 region_size = 0;
     T value = 0;
 
@@ -122,7 +142,7 @@ auto Bus::read(u32 address, AccessType access) -> T {
             if(address < 0x4000) {
                 if(core.cpu.state.pc < 0x4000) {
                     memory_region = bios;
-                    region_size = sizeof(bios);
+                    region_size = BIOS_SIZE;
                     bios_open_bus = bios[sub_address] | (bios[sub_address + 1] << 8) |
                         (bios[sub_address + 2] << 16) | (bios[sub_address + 3] << 24);
                 } else {
@@ -191,10 +211,12 @@ void Bus::write(u32 address, T value, AccessType access) {
             core.scheduler.step(sizeof(T) == 4 ? 5 : 2);
             memory_region = ewram;
             region_size = sizeof(ewram);
+            ewram_pages.mark(sub_address % sizeof(ewram));
         break;
         case 0x3 : //On-Chip WRAM
             memory_region = iwram;
             region_size = sizeof(iwram);
+            iwram_pages.mark(sub_address % sizeof(iwram));
         break;
         case 0x4 : 
             for(size_t i = 0; i < sizeof(T); i++) {
@@ -2,7 +2,11 @@
 
 #include "Types.hpp"
 #include "GamePak.hpp"
+#include "emulator/core/StateHash.hpp"
 #include "common/Types.hpp"
+#include "common/Serializer.hpp"
+#include "common/DirtyTracker.hpp"
+#include <memory>
 
 
 namespace emu {
@@ -15,8 +19,10 @@ public:
     explicit Bus(GBA &core);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
+    void hashState(StateHashes &hashes);
+    void clearDirtyPages();
 
     auto read8(u32 address, AccessType access) -> u8;
     auto read16(u32 address, AccessType access) -> u16; 
@@ -28,6 +34,7 @@ public:
     void write32(u32 address, u32 value, AccessType access);
 
     void loadBIOS(const std::vector<u8> &data);
+    void loadBIOS(std::shared_ptr<const std::vector<u8>> image);
 
     //Same as other read/writes but doesn't tick the scheduler
     // auto debugRead8(u32 address) -> u8;
@@ -48,10 +55,16 @@ private:
     auto readIO(u32 address) -> u8;
     void writeIO(u32 address, u8 value);
 
-    u8 bios[16_KiB];   //00000000 - 00003FFF
+    //The BIOS is never written, so it can be shared between cores
+    std::shared_ptr<const std::vector<u8>> bios_image;
+    const u8 *bios;    //00000000 - 00003FFF
     u8 ewram[256_KiB]; //02000000 - 0203FFFF
     u8 iwram[32_KiB];  //03000000 - 03007FFF
 
+    //Pages written since the last incremental save state
+    common::DirtyTracker<256_KiB, 4_KiB> ewram_pages;
+    common::DirtyTracker<32_KiB, 4_KiB> iwram_pages;
+
     u32 bios_open_bus;
     // u32 cpu_open_bus;
     u16 waitcnt;
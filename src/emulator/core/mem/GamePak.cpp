@@ -22,7 +22,10 @@ template void GamePak::write<u8>(u32 address, u8 value, AccessType access);
 template void GamePak::write<u16>(u32 address, u16 value, AccessType access);
 template void GamePak::write<u32>(u32 address, u32 value, AccessType access);
 
-GamePak::GamePak(Scheduler &scheduler) : scheduler(scheduler) { }
+GamePak::GamePak(Scheduler &scheduler) : scheduler(scheduler) {
+    rom = nullptr;
+    rom_size = 0;
+}
 
 template<typename T>
 auto GamePak::read(u32 address, AccessType access) -> T {
@@ -43,7 +46,7 @@ auto GamePak::read(u32 address, AccessType access) -> T {
             return 0xFF;
     }
 
-    if(aligned >= rom.size()) {
+    if(aligned >= rom_size) {
        return 0;
     }
 
@@ -136,7 +139,7 @@ auto GamePak::getTitle() -> const std::string& {
 }
 
 auto GamePak::size() -> u32 {
-    return rom.size();
+    return rom_size;
 }
 
 auto GamePak::loadFile(const std::string &path) -> bool {
@@ -146,11 +149,22 @@ auto GamePak::loadFile(const std::string &path) -> bool {
         return false;
     }
 
-    rom = std::move(file_data);
+    return loadImage(std::make_shared<const std::vector<u8>>(std::move(file_data)), path.substr(0, path.find_last_of(".")) + ".sav");
+}
+
+//An empty save path keeps the save in memory only
+auto GamePak::loadImage(std::shared_ptr<const std::vector<u8>> image, const std::string &save_path) -> bool {
+    if(!image || image->size() < sizeof(GamePakHeader)) {
+        return false;
+    }
+
+    this->image = std::move(image);
+    rom = this->image->data();
+    rom_size = this->image->size();
     parseHeader();
 
     //Get save type, only a string match so far
-    if(!findSaveType(path.substr(0, path.find_last_of(".")) + ".sav")) {
+    if(!findSaveType(save_path)) {
         save = std::make_unique<None>();
         LOG_DEBUG("No save type detected!");
     }
@@ -158,9 +172,15 @@ auto GamePak::loadFile(const std::string &path) -> bool {
     return true;
 }
 
+auto GamePak::getImage() -> std::shared_ptr<const std::vector<u8>> {
+    return image;
+}
+
 void GamePak::unload() {
     //This is the equivilent of pulling the game cartridge out, essentially
-    rom.clear();
+    image.reset();
+    rom = nullptr;
+    rom_size = 0;
     save.reset();
 }
 
@@ -185,10 +205,10 @@ void GamePak::parseHeader() {
 }
 
 auto GamePak::findSaveType(const std::string &path) -> bool {
-    for(size_t i = 0; i < rom.size(); i++) {
+    for(size_t i = 0; i < rom_size; i++) {
         char byte = static_cast<char>(rom[i]);
 
-        if(byte == 'E' && (i + 5) < rom.size()) {
+        if(byte == 'E' && (i + 5) < rom_size) {
             //TODO: More stuff to detect size, possibly in EEPROM class
             const char next[6] = {static_cast<char>(rom[i + 1]),
                 static_cast<char>(rom[i + 2]), static_cast<char>(rom[i + 3]), 
@@ -199,7 +219,7 @@ auto GamePak::findSaveType(const std::string &path) -> bool {
 
                 return true;
             }
-        } else if(byte == 'S' && (i + 3) < rom.size()) {
+        } else if(byte == 'S' && (i + 3) < rom_size) {
             const char next[4] = {static_cast<char>(rom[i + 1]),
                 static_cast<char>(rom[i + 2]), static_cast<char>(rom[i + 3]), '\0'};
             if(strcmp(next, "RAM") == 0) {
@@ -208,12 +228,12 @@ auto GamePak::findSaveType(const std::string &path) -> bool {
 
                 return true;
             }
-        } else if(byte == 'F' && (i + 4) < rom.size()) {
+        } else if(byte == 'F' && (i + 4) < rom_size) {
             const char next[5] = {static_cast<char>(rom[i + 1]),
                 static_cast<char>(rom[i + 2]), static_cast<char>(rom[i + 3]), 
                 static_cast<char>(rom[i + 4]), '\0'};
             if(strcmp(next, "LASH") == 0) {
-                if((i + 5) < rom.size()) {
+                if((i + 5) < rom_size) {
                     char size = static_cast<char>(rom[i + 5]);
 
                     if(size == '5') {
@@ -42,6 +42,8 @@ public:
     auto getTitle() -> const std::string&;
     auto size() -> u32;
     auto loadFile(const std::string &path) -> bool;
+    auto loadImage(std::shared_ptr<const std::vector<u8>> image, const std::string &save_path) -> bool;
+    auto getImage() -> std::shared_ptr<const std::vector<u8>>;
     void unload();
 
 private:
@@ -52,7 +54,11 @@ private:
     Scheduler &scheduler;
     u8 sram_waitstate;
     u32 ws0_n, ws0_s, ws1_n, ws1_s, ws2_n, ws2_s;
-    std::vector<u8> rom;
+
+    //The ROM is never written, so one image can be shared between cores
+    std::shared_ptr<const std::vector<u8>> image;
+    const u8 *rom;
+    u32 rom_size;
     GamePakHeader header;
     std::string title;
     std::unique_ptr<Save> save;
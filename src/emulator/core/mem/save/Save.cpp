@@ -12,7 +12,10 @@ auto Save::getType() -> SaveType {
 }
 
 void Save::openFile(const std::string &path, size_t size) {
-    if(std::filesystem::exists(path) && std::filesystem::is_regular_file(path)) {
+    if(path.empty()) {
+        data.assign(size, 0);
+        LOG_DEBUG("Keeping save data in memory");
+    } else if(std::filesystem::exists(path) && std::filesystem::is_regular_file(path)) {
         size_t file_size = std::filesystem::file_size(path);
         
         if(file_size != size) {
@@ -31,6 +34,10 @@ void Save::openFile(const std::string &path, size_t size) {
 }
 
 auto Save::readFile(u32 index) -> u8 {
+    if(!data.empty()) {
+        return data[index];
+    }
+
     u8 value;
     file.seekg(index);
     file.read(reinterpret_cast<char*>(&value), 1);
@@ -39,6 +46,11 @@ auto Save::readFile(u32 index) -> u8 {
 }
 
 void Save::writeFile(u32 index, u8 value) {
+    if(!data.empty()) {
+        data[index] = value;
+        return;
+    }
+
     file.seekp(index);
     file.write(reinterpret_cast<char*>(&value), 1);
 }
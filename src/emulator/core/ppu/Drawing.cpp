@@ -1,6 +1,8 @@
 #include "Drawing.hpp"
 #include "Types.hpp"
 #include "common/Bits.hpp"
+#include <algorithm>
+#include <cstring>
 
 
 namespace emu {
@@ -25,46 +27,46 @@ void Background::reset() {
     param_d = 0x100;
 }
 
-void Background::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&priority), sizeof(priority));
-    file.write(reinterpret_cast<const char*>(&char_base_block), sizeof(char_base_block));
-    file.write(reinterpret_cast<const char*>(&mosaic), sizeof(mosaic));
-    file.write(reinterpret_cast<const char*>(&color_mode), sizeof(color_mode));
-    file.write(reinterpret_cast<const char*>(&scr_base_block), sizeof(scr_base_block));
-    file.write(reinterpret_cast<const char*>(&disp_overflow), sizeof(disp_overflow));
-    file.write(reinterpret_cast<const char*>(&screen_size), sizeof(screen_size));
-    file.write(reinterpret_cast<const char*>(&unused), sizeof(unused));
-    file.write(reinterpret_cast<const char*>(&h_offset), sizeof(h_offset));
-    file.write(reinterpret_cast<const char*>(&v_offset), sizeof(v_offset));
-    file.write(reinterpret_cast<const char*>(&reference_x), sizeof(reference_x));
-    file.write(reinterpret_cast<const char*>(&reference_y), sizeof(reference_y));
-    file.write(reinterpret_cast<const char*>(&param_a), sizeof(param_a));
-    file.write(reinterpret_cast<const char*>(&param_b), sizeof(param_b));
-    file.write(reinterpret_cast<const char*>(&param_c), sizeof(param_c));
-    file.write(reinterpret_cast<const char*>(&param_d), sizeof(param_d));
-    file.write(reinterpret_cast<const char*>(&internal_x), sizeof(internal_x));
-    file.write(reinterpret_cast<const char*>(&internal_y), sizeof(internal_y));
+void Background::serialize(common::Serializer &serializer) {
+    serializer.write(priority);
+    serializer.write(char_base_block);
+    serializer.write(mosaic);
+    serializer.write(color_mode);
+    serializer.write(scr_base_block);
+    serializer.write(disp_overflow);
+    serializer.write(screen_size);
+    serializer.write(unused);
+    serializer.write(h_offset);
+    serializer.write(v_offset);
+    serializer.write(reference_x);
+    serializer.write(reference_y);
+    serializer.write(param_a);
+    serializer.write(param_b);
+    serializer.write(param_c);
+    serializer.write(param_d);
+    serializer.write(internal_x);
+    serializer.write(internal_y);
 }
 
-void Background::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&priority), sizeof(priority));
-    file.read(reinterpret_cast<char*>(&char_base_block), sizeof(char_base_block));
-    file.read(reinterpret_cast<char*>(&mosaic), sizeof(mosaic));
-    file.read(reinterpret_cast<char*>(&color_mode), sizeof(color_mode));
-    file.read(reinterpret_cast<char*>(&scr_base_block), sizeof(scr_base_block));
-    file.read(reinterpret_cast<char*>(&disp_overflow), sizeof(disp_overflow));
-    file.read(reinterpret_cast<char*>(&screen_size), sizeof(screen_size));
-    file.read(reinterpret_cast<char*>(&unused), sizeof(unused));
-    file.read(reinterpret_cast<char*>(&h_offset), sizeof(h_offset));
-    file.read(reinterpret_cast<char*>(&v_offset), sizeof(v_offset));
-    file.read(reinterpret_cast<char*>(&reference_x), sizeof(reference_x));
-    file.read(reinterpret_cast<char*>(&reference_y), sizeof(reference_y));
-    file.read(reinterpret_cast<char*>(&param_a), sizeof(param_a));
-    file.read(reinterpret_cast<char*>(&param_b), sizeof(param_b));
-    file.read(reinterpret_cast<char*>(&param_c), sizeof(param_c));
-    file.read(reinterpret_cast<char*>(&param_d), sizeof(param_d));
-    file.read(reinterpret_cast<char*>(&internal_x), sizeof(internal_x));
-    file.read(reinterpret_cast<char*>(&internal_y), sizeof(internal_y));
+void Background::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(priority);
+    deserializer.read(char_base_block);
+    deserializer.read(mosaic);
+    deserializer.read(color_mode);
+    deserializer.read(scr_base_block);
+    deserializer.read(disp_overflow);
+    deserializer.read(screen_size);
+    deserializer.read(unused);
+    deserializer.read(h_offset);
+    deserializer.read(v_offset);
+    deserializer.read(reference_x);
+    deserializer.read(reference_y);
+    deserializer.read(param_a);
+    deserializer.read(param_b);
+    deserializer.read(param_c);
+    deserializer.read(param_d);
+    deserializer.read(internal_x);
+    deserializer.read(internal_y);
 }
 
 void Background::write(u32 address, u8 value) {
@@ -89,7 +91,7 @@ auto Background::read(u32 address, bool regular) -> u8 {
     }
 }
 
-auto Background::getTextPixel(int x, int y, const u8 *vram, const PPUState &state) -> u8 {
+auto Background::getTextPixel(int x, int y, const u8 *vram, const PPUState &state) const -> u8 {
     const u16 map_width = 32 << (screen_size & 1);
     const u16 map_height = 32 << (screen_size >> 1);
     const u8 tile_width = 4 << color_mode; //color_mode ? 8 : 4;
@@ -139,7 +141,7 @@ auto Background::getTextPixel(int x, int y, const u8 *vram, const PPUState &stat
     return palette_index;
 }
 
-auto Background::getAffinePixel(int x, int y, const u8 *vram) -> u8 {
+auto Background::getAffinePixel(int x, int y, const u8 *vram) const -> u8 {
     const int map_size = (16 << screen_size) * 8;
     getAffineCoords(x, y);
 
@@ -167,7 +169,7 @@ auto Background::getAffinePixel(int x, int y, const u8 *vram) -> u8 {
     return palette_index;
 }
 
-auto Background::getBitmapPixelMode3(int x, int y, const u8 *vram) -> u16 {
+auto Background::getBitmapPixelMode3(int x, int y, const u8 *vram) const -> u16 {
     getAffineCoords(x, y);
     const u32 index = x + y * 240;
 
@@ -178,29 +180,66 @@ auto Background::getBitmapPixelMode3(int x, int y, const u8 *vram) -> u16 {
     return (vram[index * 2 + 1] << 8) | vram[index * 2];
 }
 
-auto Background::getBitmapPixelMode4(int x, int y, const u8 *vram, const u8 *palette, bool frame_1) -> u16 {
+auto Background::getBitmapPixelMode4(int x, int y, const u8 *vram, const u8 *palette, bool frame_1) const -> u16 {
     getAffineCoords(x, y);
     const u32 index = x + y * 240;
     const u32 data_start = frame_1 ? 0xA000 : 0;
-    const u8 color_index = vram[data_start + index];
 
     if(x < 0 || x >= 240 || y < 0 || y >= 160) {
         return 0;
     }
     
+    const u8 color_index = vram[data_start + index];
     return (palette[color_index * 2 + 1] << 8) | palette[color_index * 2];
 }
 
-auto Background::getBitmapPixelMode5(int x, int y, const u8 *vram, bool frame_1) -> u16 {
+auto Background::getBitmapPixelMode5(int x, int y, const u8 *vram, bool frame_1) const -> u16 {
     getAffineCoords(x, y);
 
     if(x < 0 || x >= 160 || y < 0 || y >= 128) {
         return 0;
     }
 
-    u32 index = x + y * 160;
-    u32 data_start = frame_1 ? 0xA000 : 0;
-    return vram[data_start + index];
+    const u32 index = x + y * 160;
+    const u32 data_start = frame_1 ? 0xA000 : 0;
+    return (vram[data_start + index * 2 + 1] << 8) | vram[data_start + index * 2];
+}
+
+void Background::getBitmapLine(u8 mode, const u8 *vram, const u8 *palette, bool frame_1, u16 *colors) const {
+    const int width = mode == 5 ? 160 : 240;
+    const int height = mode == 5 ? 128 : 160;
+    const int offset_x = internal_x >> 8;
+    const int y = internal_y >> 8;
+    const u32 data_start = mode != 3 && frame_1 ? 0xA000 : 0;
+
+    std::memset(colors, 0, 240 * sizeof(u16));
+
+    if(y < 0 || y >= height) {
+        return;
+    }
+
+    //Only the part of the line that lands inside the bitmap has to be read, so
+    //the index of the first pixel can be negative but every one that's read isn't
+    const int start = std::clamp(-offset_x, 0, 240);
+    const int end = std::clamp(width - offset_x, 0, 240);
+    const int row = y * width + offset_x;
+
+    if(mode == 4) {
+        for(int i = start; i < end; i++) {
+            const u8 entry = vram[data_start + (row + i)];
+            colors[i] = (palette[entry * 2 + 1] << 8) | palette[entry * 2];
+        }
+    } else {
+        for(int i = start; i < end; i++) {
+            const u32 index = data_start + (row + i) * 2;
+            colors[i] = (vram[index + 1] << 8) | vram[index];
+        }
+    }
+}
+
+auto Background::isRotatedOrScaled() const -> bool {
+    //Only the horizontal step matters within a single line
+    return param_a != 0x100 || param_c != 0;
 }
 
 void Background::resetInternalRegs() {
@@ -213,7 +252,7 @@ void Background::incrementInternalRegs() {
     internal_y += param_d;
 }
 
-void Background::getAffineCoords(int &x, int &y) {
+void Background::getAffineCoords(int &x, int &y) const {
     int new_x = (param_a * (x << 8) >> 8) + internal_x;
     int new_y = (param_c * (x << 8) >> 8) + internal_y;
 
@@ -302,43 +341,69 @@ void Window::reset() {
     winout = 0;
 }
 
-void Window::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char*>(&winh[0]), sizeof(winh[0]));
-    file.write(reinterpret_cast<const char*>(&winh[1]), sizeof(winh[1]));
-    file.write(reinterpret_cast<const char*>(&winv[0]), sizeof(winv[0]));
-    file.write(reinterpret_cast<const char*>(&winv[1]), sizeof(winv[1]));
-    file.write(reinterpret_cast<const char*>(&winin), sizeof(winin));
-    file.write(reinterpret_cast<const char*>(&winout), sizeof(winout));
+void Window::serialize(common::Serializer &serializer) {
+    serializer.write(winh[0]);
+    serializer.write(winh[1]);
+    serializer.write(winv[0]);
+    serializer.write(winv[1]);
+    serializer.write(winin);
+    serializer.write(winout);
 }
 
-void Window::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char*>(&winh[0]), sizeof(winh[0]));
-    file.read(reinterpret_cast<char*>(&winh[1]), sizeof(winh[1]));
-    file.read(reinterpret_cast<char*>(&winv[0]), sizeof(winv[0]));
-    file.read(reinterpret_cast<char*>(&winv[1]), sizeof(winv[1]));
-    file.read(reinterpret_cast<char*>(&winin), sizeof(winin));
-    file.read(reinterpret_cast<char*>(&winout), sizeof(winout));
+void Window::deserialize(common::Deserializer &deserializer) {
+    deserializer.read(winh[0]);
+    deserializer.read(winh[1]);
+    deserializer.read(winv[0]);
+    deserializer.read(winv[1]);
+    deserializer.read(winin);
+    deserializer.read(winout);
+}
+
+void LineMask::setRange(int start, int end) {
+    start = std::clamp(start, 0, 240);
+    end = std::clamp(end, 0, 240);
+
+    while(start < end) {
+        //Fill up to the end of the current word at once
+        const int bit = start & 63;
+        const int count = std::min(end - start, 64 - bit);
+        const u64 ones = count == 64 ? ~static_cast<u64>(0) : (static_cast<u64>(1) << count) - 1;
+
+        words[start >> 6] |= ones << bit;
+        start += count;
+    }
 }
 
 //TODO: Window has some weird behavior to implement
-auto Window::insideWindow(int x, int y, int window) -> bool {
+//Windows are always a single span (or two when wrapping around), so the whole
+//line can be built at once instead of checking each pixel
+auto Window::getLineMask(int y, int window) const -> LineMask {
     const u8 left = winh[window] >> 8;
     const u8 right = winh[window] & 0xFF;
     const u8 top = winv[window] >> 8;
     const u8 bottom = winv[window] & 0xFF;
 
-    bool in_horizontal = x >= left && x < right;
-    bool in_vertical = y >= top && y < bottom;
+    LineMask mask;
+    mask.clear();
 
-    if(left > right) {
-        in_horizontal = !(x < left && x >= right);
-    }
+    bool in_vertical = y >= top && y < bottom;
 
     if(top > bottom) {
         in_vertical = !(y < top && y >= bottom);
     }
 
-    return in_horizontal && in_vertical;
+    if(!in_vertical) {
+        return mask;
+    }
+
+    if(left > right) {
+        mask.setRange(0, right);
+        mask.setRange(left, 240);
+    } else {
+        mask.setRange(left, right);
+    }
+
+    return mask;
 }
 
 } //namespace emu
\ No newline at end of file
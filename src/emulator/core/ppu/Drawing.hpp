@@ -1,7 +1,7 @@
 #pragma once
 
 #include "common/Types.hpp"
-#include <fstream>
+#include "common/Serializer.hpp"
 
 
 namespace emu {
@@ -30,24 +30,28 @@ struct Background {
     s16 param_a, param_b, param_c, param_d;
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
 
     void write(u32 address, u8 value);
     auto read(u32 address, bool regular) -> u8;
 
-    auto getTextPixel(int x, int y, const u8 *vram, const PPUState &state) -> u8;
-    auto getAffinePixel(int x, int y, const u8 *vram) -> u8;
-    auto getBitmapPixelMode3(int x, int y, const u8 *vram) -> u16;
-    auto getBitmapPixelMode4(int x, int y, const u8 *vram, const u8 *palette, bool frame_1) -> u16;
-    auto getBitmapPixelMode5(int x, int y, const u8 *vram, bool frame_1) -> u16;
+    auto getTextPixel(int x, int y, const u8 *vram, const PPUState &state) const -> u8;
+    auto getAffinePixel(int x, int y, const u8 *vram) const -> u8;
+    auto getBitmapPixelMode3(int x, int y, const u8 *vram) const -> u16;
+    auto getBitmapPixelMode4(int x, int y, const u8 *vram, const u8 *palette, bool frame_1) const -> u16;
+    auto getBitmapPixelMode5(int x, int y, const u8 *vram, bool frame_1) const -> u16;
+
+    //Only valid when the background isn't rotated or scaled
+    void getBitmapLine(u8 mode, const u8 *vram, const u8 *palette, bool frame_1, u16 *colors) const;
+    auto isRotatedOrScaled() const -> bool;
 
     void resetInternalRegs();
     void incrementInternalRegs();
 
 private:
 
-    void getAffineCoords(int &x, int &y);
+    void getAffineCoords(int &x, int &y) const;
     
     s32 internal_x = 0, internal_y = 0;
 };
@@ -65,16 +69,54 @@ struct Object {
     int param_select;
 };
 
+//One bit for every pixel on a line
+struct LineMask {
+    u64 words[4];
+
+    void clear() {
+        words[0] = words[1] = words[2] = words[3] = 0;
+    }
+
+    void fill() {
+        words[0] = words[1] = words[2] = ~static_cast<u64>(0);
+        words[3] = (static_cast<u64>(1) << (240 - 192)) - 1;
+    }
+
+    //Sets the bits in [start, end)
+    void setRange(int start, int end);
+
+    void set(int x) {
+        words[x >> 6] |= static_cast<u64>(1) << (x & 63);
+    }
+
+    auto get(int x) const -> bool {
+        return (words[x >> 6] >> (x & 63)) & 1;
+    }
+
+    auto operator&(const LineMask &other) const -> LineMask {
+        return {{words[0] & other.words[0], words[1] & other.words[1], words[2] & other.words[2], words[3] & other.words[3]}};
+    }
+
+    auto operator|(const LineMask &other) const -> LineMask {
+        return {{words[0] | other.words[0], words[1] | other.words[1], words[2] | other.words[2], words[3] | other.words[3]}};
+    }
+
+    //Only inverts the 240 bits that are on screen
+    auto operator~() const -> LineMask {
+        return {{~words[0], ~words[1], ~words[2], ~words[3] & ((static_cast<u64>(1) << (240 - 192)) - 1)}};
+    }
+};
+
 struct Window {
     u16 winh[2];
     u16 winv[2];
     u16 winin, winout;
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
 
-    auto insideWindow(int x, int y, int window) -> bool;
+    auto getLineMask(int y, int window) const -> LineMask;
 };
 
 } //namespace emu
\ No newline at end of file
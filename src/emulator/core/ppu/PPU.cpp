@@ -2,6 +2,7 @@
 #include "emulator/core/GBA.hpp"
 #include "common/Log.hpp"
 #include "common/Bits.hpp"
+#include "common/Hash.hpp"
 #include <algorithm>
 
 
@@ -28,14 +29,16 @@ template void PPU::writeOAM<u8>(u32 address, u8 value);
 template void PPU::writeOAM<u16>(u32 address,u16 value);
 template void PPU::writeOAM<u32>(u32 address, u32 value);
 
-constexpr int OBJECT_WIDTH_LUT[16]  = {8, 16, 32, 64, 16, 32, 32, 64, 8, 8, 16, 32, 0, 0, 0, 0};
-constexpr int OBJECT_HEIGHT_LUT[16] = {8, 16, 32, 64, 8, 8, 16, 32, 16, 32, 32, 64, 0, 0, 0, 0};
-
-
 PPU::PPU(GBA &core) : core(core) {
-    hblank_start_event = core.scheduler.registerEvent([this](u64 late) { hblankStart(late); });
-    hblank_flag_event = core.scheduler.registerEvent([this](u64 late) { setHblankFlag(late); });
-    hblank_end_event = core.scheduler.registerEvent([this](u64 late) { hblankEnd(late); });
+    threaded_requested.store(false);
+    batching_enabled.store(true);
+    render_policy.store(RENDER_ALL);
+    render_interval.store(1);
+    output_enabled.store(true);
+
+    hblank_start_event = core.scheduler.registerEvent("ppu_hblank_start", [this](u64 late) { hblankStart(late); });
+    hblank_flag_event = core.scheduler.registerEvent("ppu_hblank_flag", [this](u64 late) { setHblankFlag(late); });
+    hblank_end_event = core.scheduler.registerEvent("ppu_hblank_end", [this](u64 late) { hblankEnd(late); });
     LOG_DEBUG("PPU has event handle: {}, {}, and {}", hblank_start_event, hblank_flag_event, hblank_end_event);
 
     reset();
@@ -45,6 +48,11 @@ void PPU::reset() {
     state.dispcnt = 0x80;
     state.dispstat = 0;
     state.line = 126;
+    frame_count = 0;
+    visible_count = 0;
+    render_frame = render_policy.load() != RENDER_NONE && output_enabled.load();
+    batch_frame = false;
+    deferred_lines = 0;
 
     state.bldcnt = 0;
     state.bldalpha = 0;
@@ -60,46 +68,74 @@ void PPU::reset() {
     std::memset(state.vram, 0, sizeof(state.vram));
     std::memset(state.palette, 0, sizeof(state.palette));
     std::memset(state.oam, 0, sizeof(state.oam));
+    vram_dirty.markAll();
+    palette_dirty.markAll();
+    oam_dirty.markAll();
+    vram_pages.markAll();
+    palette_pages.markAll();
+    oam_pages.markAll();
     
     core.scheduler.addEvent(hblank_start_event, 960);
 }
 
-void PPU::serialize(std::ofstream &file) {
-    file.write(reinterpret_cast<const char *>(&state.dispcnt), sizeof(state.dispcnt));
-    file.write(reinterpret_cast<const char *>(&state.dispstat), sizeof(state.dispstat));
-    file.write(reinterpret_cast<const char *>(&state.line), sizeof(state.line));
-    file.write(reinterpret_cast<const char *>(&state.bldcnt), sizeof(state.bldcnt));
-    file.write(reinterpret_cast<const char *>(&state.bldalpha), sizeof(state.bldalpha));
-    file.write(reinterpret_cast<const char *>(&state.bldy), sizeof(state.bldy));
-    file.write(reinterpret_cast<const char *>(&state.mosaic), sizeof(state.mosaic));
+void PPU::serialize(common::Serializer &serializer) {
+    serializer.write(state.dispcnt);
+    serializer.write(state.dispstat);
+    serializer.write(state.line);
+    serializer.write(state.bldcnt);
+    serializer.write(state.bldalpha);
+    serializer.write(state.bldy);
+    serializer.write(state.mosaic);
 
     for(int i = 0; i < 4; i++) {
-        state.bg[i].serialize(file);
+        state.bg[i].serialize(serializer);
     }
-    state.win.serialize(file);
+    state.win.serialize(serializer);
 
-    file.write(reinterpret_cast<const char*>(state.vram), sizeof(state.vram));
-    file.write(reinterpret_cast<const char*>(state.palette), sizeof(state.palette));
-    file.write(reinterpret_cast<const char*>(state.oam), sizeof(state.oam));
+    serializer.writePages(state.vram, vram_pages);
+    serializer.writePages(state.palette, palette_pages);
+    serializer.writePages(state.oam, oam_pages);
 }
 
-void PPU::deserialize(std::ifstream &file) {
-    file.read(reinterpret_cast<char *>(&state.dispcnt), sizeof(state.dispcnt));
-    file.read(reinterpret_cast<char *>(&state.dispstat), sizeof(state.dispstat));
-    file.read(reinterpret_cast<char *>(&state.line), sizeof(state.line));
-    file.read(reinterpret_cast<char *>(&state.bldcnt), sizeof(state.bldcnt));
-    file.read(reinterpret_cast<char *>(&state.bldalpha), sizeof(state.bldalpha));
-    file.read(reinterpret_cast<char *>(&state.bldy), sizeof(state.bldy));
-    file.read(reinterpret_cast<char *>(&state.mosaic), sizeof(state.mosaic));
+void PPU::deserialize(common::Deserializer &deserializer) {
+    //Lines a batched frame skipped so far would otherwise never be drawn,
+    //leaving whatever was there before in the frame that's presented
+    if(deferred_lines != 0) {
+        flushDeferredLines();
+    }
+
+    deserializer.read(state.dispcnt);
+    deserializer.read(state.dispstat);
+    deserializer.read(state.line);
+    deserializer.read(state.bldcnt);
+    deserializer.read(state.bldalpha);
+    deserializer.read(state.bldy);
+    deserializer.read(state.mosaic);
 
     for(int i = 0; i < 4; i++) {
-        state.bg[i].deserialize(file);
+        state.bg[i].deserialize(deserializer);
     }
-    state.win.deserialize(file);
+    state.win.deserialize(deserializer);
+
+    deserializer.readPages(state.vram, vram_pages);
+    deserializer.readPages(state.palette, palette_pages);
+    deserializer.readPages(state.oam, oam_pages);
+    batch_frame = false;
+    vram_dirty.markAll();
+    palette_dirty.markAll();
+    oam_dirty.markAll();
+}
 
-    file.read(reinterpret_cast<char*>(state.vram), sizeof(state.vram));
-    file.read(reinterpret_cast<char*>(state.palette), sizeof(state.palette));
-    file.read(reinterpret_cast<char*>(state.oam), sizeof(state.oam));
+void PPU::hashState(StateHashes &hashes) {
+    hashes.values[StateHashes::HASH_VRAM] = common::hash64(state.vram, sizeof(state.vram));
+    hashes.values[StateHashes::HASH_PALETTE] = common::hash64(state.palette, sizeof(state.palette));
+    hashes.values[StateHashes::HASH_OAM] = common::hash64(state.oam, sizeof(state.oam));
+}
+
+void PPU::clearDirtyPages() {
+    vram_pages.clear();
+    palette_pages.clear();
+    oam_pages.clear();
 }
 
 auto PPU::readIO(u32 address) -> u8 {
@@ -132,6 +168,11 @@ auto PPU::readIO(u32 address) -> u8 {
 }
 
 void PPU::writeIO(u32 address, u8 value) {
+    //Lines already passed have to be drawn with the old values
+    if(deferred_lines != 0 && address < 0x56 && (address < 0x04 || address > 0x07)) {
+        flushDeferredLines();
+    }
+
     switch(address) {
         case 0x00 : state.dispcnt = (state.dispcnt & 0xFF00) | value; break;
         case 0x01 : state.dispcnt = (state.dispcnt & 0x00FF) | (value << 8); break;
@@ -261,6 +302,10 @@ auto PPU::readOAM(u32 address) -> T {
 
 template<typename T>
 void PPU::writePalette(u32 address, T value) {
+    if(deferred_lines != 0) {
+        flushDeferredLines();
+    }
+
     //Byte writes affect entire addressed halfword
     if constexpr(sizeof(T) == 1) {
         state.palette[(address & ~1) % sizeof(state.palette)] = value;
@@ -270,10 +315,17 @@ void PPU::writePalette(u32 address, T value) {
             state.palette[(address + i) % sizeof(state.palette)] = (value >> i * 8) & 0xFF;
         }
     }
+
+    palette_dirty.mark(address % sizeof(state.palette));
+    palette_pages.mark(address % sizeof(state.palette));
 }
 
 template<typename T>
 void PPU::writeVRAM(u32 address, T value) {
+    if(deferred_lines != 0) {
+        flushDeferredLines();
+    }
+
     address %= 128_KiB;
 
     if constexpr(sizeof(T) == 1) {
@@ -284,11 +336,15 @@ void PPU::writeVRAM(u32 address, T value) {
             if(address < 80_KiB || (address >= 96_KiB && address < 112_KiB)) {
                 state.vram[address % 96_KiB + 0] = value;
                 state.vram[address % 96_KiB + 1] = value;
+                vram_dirty.markRange(address % 96_KiB, 2);
+                vram_pages.markRange(address % 96_KiB, 2);
             }
         } else {
             if(address < 64_KiB) {
                 state.vram[address + 0] = value;
                 state.vram[address + 1] = value;
+                vram_dirty.markRange(address, 2);
+                vram_pages.markRange(address, 2);
             }
         }
     } else {
@@ -296,37 +352,127 @@ void PPU::writeVRAM(u32 address, T value) {
             for(size_t i = 0; i < sizeof(T); i++) {
                 state.vram[address - 32_KiB + i] = (value >> i * 8) & 0xFF;
             }
+            vram_dirty.mark(address - 32_KiB);
+            vram_pages.mark(address - 32_KiB);
         } else {
             for(size_t i = 0; i < sizeof(T); i++) {
                 state.vram[address + i] = (value >> i * 8) & 0xFF;
             }
+            vram_dirty.mark(address);
+            vram_pages.mark(address);
         }
     }
 }
 
 template<typename T>
 void PPU::writeOAM(u32 address, T value) {
+    if(deferred_lines != 0) {
+        flushDeferredLines();
+    }
+
     //Disallow byte writes
     if constexpr(sizeof(T) != 1) {
         for(size_t i = 0; i < sizeof(T); i++) {
             state.oam[(address + i) % sizeof(state.oam)] = (value >> i * 8) & 0xFF;
         }
+
+        oam_dirty.mark(address % sizeof(state.oam));
+        oam_pages.mark(address % sizeof(state.oam));
+    }
+}
+
+void PPU::setThreadedRendering(bool enable) {
+    threaded_requested.store(enable);
+}
+
+void PPU::setBatchedRendering(bool enable) {
+    batching_enabled.store(enable);
+}
+
+void PPU::setRenderPolicy(RenderPolicy policy, u32 interval) {
+    render_interval.store(std::max<u32>(interval, 1));
+    render_policy.store(policy);
+}
+
+void PPU::setOutputEnabled(bool enabled) {
+    output_enabled.store(enabled);
+}
+
+auto PPU::getFrameCount() const -> u64 {
+    return frame_count;
+}
+
+void PPU::updateRenderPolicy() {
+    frame_count++;
+
+    if(!output_enabled.load()) {
+        render_frame = false;
+        return;
+    }
+
+    visible_count++;
+
+    switch(render_policy.load()) {
+        case RENDER_ALL : render_frame = true; break;
+        case RENDER_INTERVAL : render_frame = visible_count % render_interval.load() == 0; break;
+        case RENDER_NONE : render_frame = false; break;
+    }
+}
+
+void PPU::drawLine() {
+    if(render_thread) {
+        render_thread->submitLine(state, vram_dirty, palette_dirty, oam_dirty);
+    } else {
+        u32 output[240];
+        renderer.drawLine(state, output);
+        core.video_device.setLine(state.line, output);
+    }
+}
+
+//Draws all the lines that were skipped so far this frame, and switches to
+//drawing each line at H-Blank for the rest of it.
+void PPU::flushDeferredLines() {
+    const u8 current_line = state.line;
+
+    //Nothing that affects drawing has been written since the frame started,
+    //so only the affine reference points need to be rewound.
+    state.bg[2] = frame_start_bg[0];
+    state.bg[3] = frame_start_bg[1];
+
+    for(u8 line = 0; line < deferred_lines; line++) {
+        state.line = line;
+        drawLine();
+        state.bg[2].incrementInternalRegs();
+        state.bg[3].incrementInternalRegs();
+    }
+
+    state.line = current_line;
+    deferred_lines = 0;
+    batch_frame = false;
+}
+
+void PPU::updateRenderThread() {
+    const bool threaded = threaded_requested.load();
+
+    if(threaded && !render_thread) {
+        render_thread = std::make_unique<RenderThread>(core.video_device);
+
+        //The render thread starts out with an empty copy of memory
+        vram_dirty.markAll();
+        palette_dirty.markAll();
+        oam_dirty.markAll();
+    } else if(!threaded && render_thread) {
+        render_thread.reset();
     }
 }
 
 void PPU::hblankStart(u64 late) {
     //Draw Scanline
-    if(state.line < 160) {
-        if(!bits::get_bit<7>(state.dispcnt)) {
-            clearBuffers();
-            getWindowLine();
-            drawBackground();
-            drawObjects(); 
-            compositeLine();
+    if(state.line < 160 && render_frame) {
+        if(batch_frame) {
+            deferred_lines++;
         } else {
-            //Forced Blank
-            static constexpr u32 blank[240] = {0};
-            core.video_device.setLine(state.line, blank);
+            drawLine();
         }
     }
 
@@ -365,6 +511,11 @@ void PPU::hblankEnd(u64 late) {
         state.line = 0;
         state.bg[2].resetInternalRegs();
         state.bg[3].resetInternalRegs();
+
+        batch_frame = batching_enabled.load();
+        deferred_lines = 0;
+        frame_start_bg[0] = state.bg[2];
+        frame_start_bg[1] = state.bg[3];
     } else {
         state.line++;
         state.dispstat &= ~2;
@@ -383,7 +534,22 @@ void PPU::hblankEnd(u64 late) {
     //VBlank Start
     if(state.line == 160) {
         state.dispstat |= 1;
-        core.video_device.presentFrame();
+
+        if(render_frame) {
+            if(batch_frame) {
+                flushDeferredLines();
+            }
+
+            if(render_thread) {
+                render_thread->submitPresent();
+            } else {
+                core.video_device.presentFrame();
+            }
+        }
+
+        updateRenderPolicy();
+        updateRenderThread();
+        core.frame_ended = true;
         core.debug.onVblank();
         core.dma.onVBlank();
 
@@ -402,344 +568,4 @@ void PPU::hblankEnd(u64 late) {
     core.scheduler.addEvent(hblank_start_event, 960 - late);
 }
 
-void PPU::clearBuffers() {
-    std::memset(bmp_col, 0, sizeof(bmp_col));
-    std::memset(bg_col[0], 0, sizeof(bg_col[0]));
-    std::memset(bg_col[1], 0, sizeof(bg_col[1]));
-    std::memset(bg_col[2], 0, sizeof(bg_col[2]));
-    std::memset(bg_col[3], 0, sizeof(bg_col[3]));
-    std::memset(obj_col, 0, sizeof(obj_col));
-    std::memset(obj_info, 6, sizeof(obj_info));
-}
-
-void PPU::getWindowLine() {
-    //Get objects that are windows and on this line
-    std::vector<Object> win_objs;
-
-    //TODO: Move to Window class
-    if(bits::get_bit<15>(state.dispcnt)) {
-        for(size_t i = 0; i < 128; i++) {
-            u8 mode = bits::get<2, 2>(state.oam[i * 8 + 1]);
-            u8 flags = bits::get<0, 2>(state.oam[i * 8 + 1]);
-            
-            if(mode == 2 && flags != 2) {
-                const int height = OBJECT_HEIGHT_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
-                const int y = state.oam[i * 8];
-                const int bottom = (y + (flags == 3 ? height * 2 : height)) & 0xFF;
-                bool in_vertical = y <= state.line && state.line < bottom;
-
-                if(bottom < y) {
-                    in_vertical = !(y > state.line && state.line >= bottom);
-                }
-
-                //Check if object is on this line
-                if(in_vertical) {
-                    const int width = OBJECT_WIDTH_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
-                    const int x = ((state.oam[i * 8 + 3] & 1) << 8) | state.oam[i * 8 + 2];
-
-                    //Check if object is visible on screen
-                    if(((x + width) & 0x1FF) < x || x < 240) {
-                        Object obj;
-                        obj.x = x;
-                        obj.y = y > bottom ? bits::sign_extend<8, int>(y) : y;
-                        obj.index = i;
-                        obj.width = width;
-                        obj.height = height;
-                        obj.affine = (flags & 1) == 1;
-                        obj.double_size = flags == 3;
-                        obj.param_select = bits::get<1, 5>(state.oam[i * 8 + 3]);
-                        win_objs.push_back(std::move(obj));
-                    }
-                }
-            }
-        }
-    }
-
-    for(size_t i = 0; i < 240; i++) {
-        //Bit 0-3 are bg 0-3 display, and bit 4 is obj display
-        win_line[i] = bits::get<13, 3>(state.dispcnt) != 0 ? bits::get<0, 6>(state.win.winout) : 0x3F;
-
-        //Window 0
-        if(bits::get_bit<13>(state.dispcnt) && state.win.insideWindow(i, state.line, 0)) {
-            win_line[i] = bits::get<0, 6>(state.win.winin);
-            continue;
-        }
-
-        //Window 1
-        if(bits::get_bit<14>(state.dispcnt) && state.win.insideWindow(i, state.line, 1)) {
-            win_line[i] = bits::get<8, 6>(state.win.winin);
-            continue;
-        }
-    }
-
-    //Object window
-    for(const auto &obj : win_objs) {
-        int local_y = state.line - obj.y;
-        u32 obj_width = obj.double_size ? obj.width * 2 : obj.width;
-
-        for(size_t i = 0; i < obj_width; i++) {
-            int screen_x = obj.getScreenX(i);
-
-            if(screen_x >= 240) {
-                continue;
-            }
-
-            u8 palette_index = obj.getObjectPixel(i, local_y, state);
-
-            if(palette_index != 0 && win_line[screen_x] == bits::get<0, 6>(state.win.winout)) {
-                win_line[screen_x] = bits::get<8, 6>(state.win.winout);
-            }
-        }
-    }
-}
-
-auto PPU::getSpriteLines() -> std::vector<Object> {
-    std::vector<Object> lines;
-
-    for(size_t i = 0; i < 128; i++) {
-        u8 mode = bits::get<2, 2>(state.oam[i * 8 + 1]);
-        u8 flags = bits::get<0, 2>(state.oam[i * 8 + 1]);
-
-        if(mode < 2 && flags != 2) {
-            const int height = OBJECT_HEIGHT_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
-            const int y = state.oam[i * 8];
-            const int bottom = (y + (flags == 3 ? height * 2 : height)) & 0xFF;
-            bool in_vertical = y <= state.line && state.line < bottom;
-
-            if(bottom < y) {
-                in_vertical = !(y > state.line && state.line >= bottom);
-            }
-
-            //Check if object is on this line
-            if(in_vertical) {
-                const int width = OBJECT_WIDTH_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
-                const int x = ((state.oam[i * 8 + 3] & 1) << 8) | state.oam[i * 8 + 2];
-
-                //Check if object is visible on screen
-                if(((x + width) & 0x1FF) < x || x < 240) {
-                    Object obj;
-                    obj.x = x;
-                    obj.y = y > bottom ? bits::sign_extend<8, int>(y) : y;
-                    obj.index = i;
-                    obj.width = width;
-                    obj.height = height;
-                    obj.affine = (flags & 1) == 1;
-                    obj.double_size = flags == 3;
-                    obj.param_select = bits::get<1, 5>(state.oam[i * 8 + 3]);
-                    lines.push_back(std::move(obj));
-                }
-            }
-        }
-    }
-
-    return lines;
-}
-
-void PPU::drawObjects() {
-    if(!bits::get_bit<12>(state.dispcnt)) {
-        return;
-    }
-
-    std::vector<Object> active_objs = getSpriteLines();
-
-    for(const auto &obj : active_objs) {
-        int local_y = state.line - obj.y;
-        const int priority = bits::get<2, 2>(state.oam[obj.index * 8 + 5]);
-        const bool mosaic = bits::get_bit<4>(state.oam[obj.index * 8 + 1]);
-        u32 obj_width = obj.double_size ? obj.width * 2 : obj.width;
-
-        if(mosaic) {
-            int mosaic_h = (bits::get<12, 4>(state.mosaic) + 1);
-            local_y = (state.line / mosaic_h * mosaic_h) - obj.y;
-        }
-
-        for(size_t i = 0; i < obj_width; i++) {
-            int screen_x = obj.getScreenX(i);
-
-            if(screen_x >= 240) {
-                continue;
-            }
-
-            u8 palette_index = obj.getObjectPixel(i, local_y, state);
-
-            if(priority < (obj_info[screen_x] & 7) || obj_col[screen_x] == 0){
-                bool is_semi_transparent = false;
-
-                if(palette_index != 0) {
-                    obj_col[screen_x] = palette_index;
-                    is_semi_transparent = bits::get<2, 2>(state.oam[obj.index * 8 + 1]) == 1;
-                }
-
-                obj_info[screen_x] = priority | (is_semi_transparent  << 3) | (mosaic << 4);
-            }
-        }
-    }
-}
-
-void PPU::drawBackground() {
-    switch(bits::get<0, 3>(state.dispcnt)) {
-        case 0 : //BG 0-3 Text
-            for(size_t i = 0; i < 240; i++) {
-                if(bits::get_bit<8>(state.dispcnt))  bg_col[0][i] = state.bg[0].getTextPixel(i, state.line, state.vram, state);
-                if(bits::get_bit<9>(state.dispcnt))  bg_col[1][i] = state.bg[1].getTextPixel(i, state.line, state.vram, state);
-                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getTextPixel(i, state.line, state.vram, state);
-                if(bits::get_bit<11>(state.dispcnt)) bg_col[3][i] = state.bg[3].getTextPixel(i, state.line, state.vram, state);
-            }
-            break;
-        case 1 : //BG 0-1 Text BG 2 Affine
-            for(size_t i = 0; i < 240; i++) {
-                if(bits::get_bit<8>(state.dispcnt))  bg_col[0][i] = state.bg[0].getTextPixel(i, state.line, state.vram, state);
-                if(bits::get_bit<9>(state.dispcnt))  bg_col[1][i] = state.bg[1].getTextPixel(i, state.line, state.vram, state);
-                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getAffinePixel(i, state.line, state.vram);
-            }
-            break;
-        case 2 : //BG 2-3 Affine
-            for(size_t i = 0; i < 240; i++) {
-                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getAffinePixel(i, state.line, state.vram);
-                if(bits::get_bit<11>(state.dispcnt)) bg_col[3][i] = state.bg[3].getAffinePixel(i, state.line, state.vram);
-            }
-            break;
-        case 3 : //BG 2 Bitmap 1x 240x160 Frame 15-bit color
-            if(bits::get_bit<10>(state.dispcnt)) {
-                for(size_t i = 0; i < 240; i++) {
-                    bmp_col[i] = state.bg[2].getBitmapPixelMode3(i, state.line, state.vram);
-                }
-            }
-            break;
-        case 4 : //BG 2 Bitmap 2x 240x160 Frames Paletted
-            if(bits::get_bit<10>(state.dispcnt)) {
-                for(size_t i = 0; i < 240; i++) {
-                    bmp_col[i] = state.bg[2].getBitmapPixelMode4(i, state.line, state.vram, state.palette, bits::get<4, 1>(state.dispcnt));
-                }
-            }
-            break;
-        case 5 : //BG 2 Bitmap 2x 160x128 Frames 15-bit color
-            if(bits::get_bit<10>(state.dispcnt)) {
-                for(size_t i = 0; i < 240; i++) {
-                    bmp_col[i] = state.bg[2].getBitmapPixelMode5(i, state.line, state.vram, bits::get<4, 1>(state.dispcnt));
-                }
-            }
-            break;
-    }
-}
-
-void PPU::compositeLine() {
-    const u16 zero_color = (state.palette[1] << 8) | state.palette[0];
-    const bool bitmap = bits::get<0, 3>(state.dispcnt) >= 3;
-    u8 priorities[6];
-    u32 output[240];
-
-    for(size_t i = 0; i < 240; i++) {
-        for(size_t i = 0; i < 6; i++) {
-            priorities[i] = i << 3;
-        }
-
-        int mosaic = (bits::get<8, 4>(state.mosaic) + 1);
-        int i_mosaic = (obj_info[i] & 0x10) == 0x10 ? i / mosaic * mosaic : i;
-
-        //BG Pixels
-        priorities[0] |= bg_col[0][i] != 0 && bits::get_bit<0>(win_line[i]) ? state.bg[0].priority + 1 : 6;
-        priorities[1] |= bg_col[1][i] != 0 && bits::get_bit<1>(win_line[i]) ? state.bg[1].priority + 1 : 6;
-        priorities[2] |= (bitmap || bg_col[2][i] != 0) && bits::get_bit<2>(win_line[i]) ? state.bg[2].priority + 1 : 6;
-        priorities[3] |= bg_col[3][i] != 0 && bits::get_bit<3>(win_line[i]) ? state.bg[3].priority + 1 : 6;
-
-        //Object pixel
-        priorities[4] |= obj_col[i_mosaic] != 0 && bits::get_bit<4>(win_line[i]) ? obj_info[i_mosaic] & 7 : 6;
-        
-        //Backdrop
-        priorities[5] |= 5;
-
-        std::sort(&priorities[0], &priorities[6], [](const u8 &a, const u8 &b) {
-            return (a & 7) < (b & 7);
-        });
-
-        u16 target_1 = 0;
-
-        //Find first target (Topmost pixel)
-        switch(priorities[0] >> 3) {
-            case 0 : target_1 = (state.palette[bg_col[0][i] * 2 + 1] << 8) | state.palette[bg_col[0][i] * 2]; break;
-            case 1 : target_1 = (state.palette[bg_col[1][i] * 2 + 1] << 8) | state.palette[bg_col[1][i] * 2]; break;
-            case 2 : target_1 = bitmap ? bmp_col[i] : (state.palette[bg_col[2][i] * 2 + 1] << 8) | state.palette[bg_col[2][i] * 2]; break;
-            case 3 : target_1 = (state.palette[bg_col[3][i] * 2 + 1] << 8) | state.palette[bg_col[3][i] * 2]; break;
-            case 4 : target_1 = (state.palette[0x200 + obj_col[i_mosaic] * 2 + 1] << 8) | state.palette[0x200 + obj_col[i_mosaic] * 2]; break;
-            case 5 : target_1 = zero_color; break;
-        }
-
-        u8 red   = bits::get<0, 5>(target_1);
-        u8 green = bits::get<5, 5>(target_1);
-        u8 blue  = bits::get<10, 5>(target_1);
-
-        //TODO: If semi-transparent obj is 2nd highest priority
-        bool semi_transparent = (priorities[0] >> 3) == 4 && (obj_info[i] & 0x8) == 0x8 && bits::get_bit(state.bldcnt, 8 + (priorities[1] >> 3));
-
-        //Color Effects
-        if((priorities[0] & 7) < 6 && (semi_transparent || bits::get_bit(state.bldcnt, priorities[0] >> 3)) && bits::get_bit<5>(win_line[i])) {
-            switch(semi_transparent ? 1 : bits::get<6, 2>(state.bldcnt)) {
-                case 1 : //Alpha Blending
-                    if(bits::get_bit(state.bldcnt, 8 + (priorities[1] >> 3))) {
-                        float blend_a1 = (float)(state.bldalpha & 0x1F) / 16.0f;
-                        if(blend_a1 > 1.0f) {
-                            blend_a1 = 1.0f;
-                        }
-                        float blend_a2 = (float)((state.bldalpha >> 8) & 0x1F) / 16.0f;
-                        if(blend_a2 > 1.0f) {
-                            blend_a2 = 1.0f;
-                        }
-                        u16 target_2 = 0;
-
-                        //Find second target (Next topmost pixel)
-                        switch(priorities[1] >> 3) {
-                            case 0 : target_2 = (state.palette[bg_col[0][i] * 2 + 1] << 8) | state.palette[bg_col[0][i] * 2]; break;
-                            case 1 : target_2 = (state.palette[bg_col[1][i] *  2 + 1] << 8) | state.palette[bg_col[1][i] * 2]; break;
-                            case 2 : target_2 = bitmap ? bmp_col[i] : (state.palette[bg_col[2][i] * 2 + 1] << 8) | state.palette[bg_col[2][i] * 2]; break;
-                            case 3 : target_2 = (state.palette[bg_col[3][i] * 2 + 1] << 8) | state.palette[bg_col[3][i] * 2]; break;
-                            case 4 : target_2 = (state.palette[0x200 + obj_col[i_mosaic] * 2 + 1] << 8) | state.palette[0x200 + obj_col[i_mosaic] * 2]; break;
-                            case 5 : target_2 = zero_color; break;
-                        } 
-
-                        const u8 red_2   = bits::get<0, 5>(target_2);
-                        const u8 green_2 = bits::get<5, 5>(target_2);
-                        const u8 blue_2  = bits::get<10, 5>(target_2);
-
-                        red   = blend_a1 * (float)red + blend_a2 * (float)red_2;
-                        green = blend_a1 * (float)green + blend_a2 * (float)green_2;
-                        blue  = blend_a1 * (float)blue + blend_a2 * (float)blue_2;
-                    }
-                    break;
-                case 2 : { //Brightness Increase
-                    float blend_y = (float)(state.bldy & 0x1F) / 16.0f;
-                    if(blend_y > 1.0f) {
-                        blend_y = 1.0f;
-                    }
-
-                    red   = (float)red + blend_y * (float)(31 - red);
-                    green = (float)green + blend_y * (float)(31 - green);
-                    blue  = (float)blue + blend_y * (float)(31 - blue);
-                    break;
-                }
-                case 3 : { //Brightness Decrease
-                    float blend_y = (float)(state.bldy & 0x1F) / 16.0f;
-                    if(blend_y > 1.0f) {
-                        blend_y = 1.0f;
-                    }
-
-                    red   = (float)red - blend_y * (float)red;
-                    green = (float)green - blend_y * (float)green;
-                    blue  = (float)blue - blend_y * (float)blue;
-                    break;
-                }
-            }
-
-            red   = red > 31 ? 31 : red;
-            green = green > 31 ? 31 : green;
-            blue  = blue > 31 ? 31 : blue;
-        }
-
-    
-        output[i] = (red * 8 << 24) | (green * 8 << 16) | (blue * 8 << 8) | 0xFF;
-    }
-
-    core.video_device.setLine(state.line, output);
-}
-
 } //namespace emu
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Types.hpp"
+#include "Renderer.hpp"
+#include "RenderThread.hpp"
 #include "emulator/core/Scheduler.hpp"
-#include <vector>
+#include "emulator/core/StateHash.hpp"
+#include "common/Serializer.hpp"
+#include <memory>
+#include <atomic>
 
 
 namespace emu {
@@ -15,8 +20,10 @@ public:
     explicit PPU(GBA &core);
 
     void reset();
-    void serialize(std::ofstream &file);
-    void deserialize(std::ifstream &file);
+    void serialize(common::Serializer &serializer);
+    void deserialize(common::Deserializer &deserializer);
+    void hashState(StateHashes &hashes);
+    void clearDirtyPages();
 
     auto readIO(u32 address) -> u8;
     void writeIO(u32 address, u8 value);
@@ -34,25 +41,55 @@ public:
     template<typename T>
     void writeOAM(u32 address, T value);
 
+    //These take effect at the start of the next V-Blank, or the next frame for batching
+    void setThreadedRendering(bool enable);
+    void setBatchedRendering(bool enable);
+    void setRenderPolicy(RenderPolicy policy, u32 interval = 1);
+    void setOutputEnabled(bool enabled);
+    auto getFrameCount() const -> u64;
+
 private:
 
     void hblankStart(u64 late);
     void setHblankFlag(u64 late);
     void hblankEnd(u64 late);
 
-    void clearBuffers();
-    void getWindowLine();
-    auto getSpriteLines() -> std::vector<Object>;
-    void drawObjects();
-    void drawBackground();
-    void compositeLine();
+    void drawLine();
+    void flushDeferredLines();
+    void updateRenderThread();
+    void updateRenderPolicy();
     
     PPUState state;
-    u8 win_line[240];
-    u16 bmp_col[240];
-    u16 bg_col[4][240];
-    u16 obj_col[240];
-    u8 obj_info[240];
+    Renderer renderer;
+
+    //Only used while rendering on a separate thread
+    std::unique_ptr<RenderThread> render_thread;
+    std::atomic<bool> threaded_requested;
+    VRAMTracker vram_dirty;
+    PaletteTracker palette_dirty;
+    OAMTracker oam_dirty;
+
+    //Pages written since the last incremental save state
+    common::DirtyTracker<96_KiB, 4_KiB> vram_pages;
+    common::DirtyTracker<1_KiB, 1_KiB> palette_pages;
+    common::DirtyTracker<1_KiB, 1_KiB> oam_pages;
+
+    std::atomic<RenderPolicy> render_policy;
+    std::atomic<u32> render_interval;
+    u64 frame_count;
+    bool render_frame;
+
+    //Frames that are run but never meant to be seen, like run-ahead's, are
+    //hidden on top of the policy. Only the rest count towards the interval.
+    std::atomic<bool> output_enabled;
+    u64 visible_count;
+
+    //Frames are drawn all at once at V-Blank unless something that affects
+    //drawing is written mid-frame, then it falls back to drawing every line.
+    std::atomic<bool> batching_enabled;
+    bool batch_frame;
+    u8 deferred_lines;
+    Background frame_start_bg[2];
 
     GBA &core;
     EventHandle hblank_start_event, hblank_flag_event, hblank_end_event;
@@ -0,0 +1,224 @@
+#include "RenderThread.hpp"
+#include "emulator/device/VideoDevice.hpp"
+#include "common/Log.hpp"
+
+
+//Times the render thread checks for another line before going to sleep
+constexpr int SPIN_COUNT = 64;
+
+
+namespace emu {
+
+RenderThread::RenderThread(VideoDevice &video_device) : video_device(video_device), state(std::make_unique<PPUState>()) {
+    LOG_DEBUG("Starting render thread...");
+
+    lines_submitted = 0;
+    lines_drawn.store(0);
+    running.store(true);
+    renderer_waiting.store(false);
+    emulator_waiting.store(false);
+    thread = std::thread([this]() {
+        run();
+    });
+}
+
+RenderThread::~RenderThread() {
+    flush();
+    running.store(false);
+
+    {
+        std::lock_guard lock(mutex);
+        line_cv.notify_one();
+    }
+
+    if(thread.joinable()) {
+        thread.join();
+    }
+}
+
+void RenderThread::submitLine(const PPUState &state, VRAMTracker &vram_dirty, PaletteTracker &palette_dirty, OAMTracker &oam_dirty) {
+    LineSnapshot snapshot;
+    snapshot.line = state.line;
+    snapshot.present = false;
+    snapshot.dispcnt = state.dispcnt;
+    snapshot.bldcnt = state.bldcnt;
+    snapshot.bldalpha = state.bldalpha;
+    snapshot.bldy = state.bldy;
+    snapshot.mosaic = state.mosaic;
+    snapshot.bg[0] = state.bg[0];
+    snapshot.bg[1] = state.bg[1];
+    snapshot.bg[2] = state.bg[2];
+    snapshot.bg[3] = state.bg[3];
+    snapshot.win = state.win;
+    snapshot.delta_size = 0;
+
+    //Copy any memory written since the last line
+    vram_dirty.forEach([&](size_t block) {
+        pushDelta(DELTA_VRAM, block * BLOCK_SIZE, &state.vram[block * BLOCK_SIZE], snapshot.delta_size);
+    });
+    palette_dirty.forEach([&](size_t block) {
+        pushDelta(DELTA_PALETTE, block * BLOCK_SIZE, &state.palette[block * BLOCK_SIZE], snapshot.delta_size);
+    });
+    oam_dirty.forEach([&](size_t block) {
+        pushDelta(DELTA_OAM, block * BLOCK_SIZE, &state.oam[block * BLOCK_SIZE], snapshot.delta_size);
+    });
+    vram_dirty.clear();
+    palette_dirty.clear();
+    oam_dirty.clear();
+
+    pushSnapshot(snapshot);
+}
+
+void RenderThread::submitPresent() {
+    LineSnapshot snapshot;
+    snapshot.present = true;
+    snapshot.delta_size = 0;
+
+    pushSnapshot(snapshot);
+}
+
+//Blocks until the render thread has drawn everything submitted so far
+void RenderThread::flush() {
+    waitForRenderer([this]() {
+        return lines_drawn.load(std::memory_order_acquire) == lines_submitted;
+    });
+}
+
+void RenderThread::pushDelta(DeltaRegion region, u32 offset, const u8 *data, u32 &delta_size) {
+    u8 block[DELTA_HEADER_SIZE + BLOCK_SIZE];
+    block[0] = region;
+    block[1] = offset & 0xFF;
+    block[2] = (offset >> 8) & 0xFF;
+    block[3] = (offset >> 16) & 0xFF;
+    std::memcpy(&block[DELTA_HEADER_SIZE], data, BLOCK_SIZE);
+
+    //Wait for the render thread to catch up if the buffer is full
+    waitForRenderer([&]() {
+        return deltas.push_many(block, sizeof(block));
+    });
+
+    delta_size += sizeof(block);
+}
+
+void RenderThread::pushSnapshot(const LineSnapshot &snapshot) {
+    waitForRenderer([&]() {
+        return lines.push(snapshot);
+    });
+
+    lines_submitted++;
+    notifyRenderer();
+}
+
+//Sleeps the emulation thread until the condition holds, which only changes
+//when the render thread finishes a line
+template<typename Condition>
+void RenderThread::waitForRenderer(Condition condition) {
+    if(condition()) {
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+    emulator_waiting.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    drawn_cv.wait(lock, condition);
+    emulator_waiting.store(false);
+}
+
+//The fences pair up with the ones in the waits, so either the sleeping
+//thread sees what was just done, or this one sees that it's sleeping
+void RenderThread::notifyRenderer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(renderer_waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard lock(mutex);
+        line_cv.notify_one();
+    }
+}
+
+void RenderThread::notifyEmulator() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(emulator_waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard lock(mutex);
+        drawn_cv.notify_one();
+    }
+}
+
+void RenderThread::applyDeltas(u32 size) {
+    u8 block[DELTA_HEADER_SIZE + BLOCK_SIZE];
+
+    for(u32 i = 0; i < size; i += sizeof(block)) {
+        //The producer always pushes deltas before the snapshot that references them
+        deltas.pop_many(block, sizeof(block));
+        const u32 offset = block[1] | (block[2] << 8) | (block[3] << 16);
+
+        switch(block[0]) {
+            case DELTA_VRAM : std::memcpy(&state->vram[offset], &block[DELTA_HEADER_SIZE], BLOCK_SIZE); break;
+            case DELTA_PALETTE : std::memcpy(&state->palette[offset], &block[DELTA_HEADER_SIZE], BLOCK_SIZE); break;
+            case DELTA_OAM : std::memcpy(&state->oam[offset], &block[DELTA_HEADER_SIZE], BLOCK_SIZE); break;
+        }
+    }
+}
+
+//Returns false once the thread is stopping. Lines usually come in quick
+//succession while the emulator runs, so it checks a few times before sleeping.
+auto RenderThread::waitForLine(LineSnapshot &snapshot) -> bool {
+    for(int i = 0; i < SPIN_COUNT; i++) {
+        if(lines.pop(snapshot)) {
+            return true;
+        }
+
+        if(!running.load()) {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    bool popped = false;
+    std::unique_lock lock(mutex);
+    renderer_waiting.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    line_cv.wait(lock, [&]() {
+        popped = lines.pop(snapshot);
+        return popped || !running.load();
+    });
+    renderer_waiting.store(false);
+
+    return popped;
+}
+
+void RenderThread::run() {
+    u32 output[240];
+    LineSnapshot snapshot;
+
+    while(waitForLine(snapshot)) {
+        applyDeltas(snapshot.delta_size);
+
+        if(snapshot.present) {
+            video_device.presentFrame();
+            lines_drawn.fetch_add(1, std::memory_order_release);
+            notifyEmulator();
+            continue;
+        }
+
+        state->line = snapshot.line;
+        state->dispcnt = snapshot.dispcnt;
+        state->bldcnt = snapshot.bldcnt;
+        state->bldalpha = snapshot.bldalpha;
+        state->bldy = snapshot.bldy;
+        state->mosaic = snapshot.mosaic;
+        state->bg[0] = snapshot.bg[0];
+        state->bg[1] = snapshot.bg[1];
+        state->bg[2] = snapshot.bg[2];
+        state->bg[3] = snapshot.bg[3];
+        state->win = snapshot.win;
+
+        renderer.drawLine(*state, output);
+        video_device.setLine(snapshot.line, output);
+        lines_drawn.fetch_add(1, std::memory_order_release);
+        notifyEmulator();
+    }
+}
+
+} //namespace emu
\ No newline at end of file
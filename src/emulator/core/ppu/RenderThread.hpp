@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Renderer.hpp"
+#include "common/DirtyTracker.hpp"
+#include "common/Buffer.hpp"
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace emu {
+
+class VideoDevice;
+
+using VRAMTracker = common::DirtyTracker<96_KiB, 256>;
+using PaletteTracker = common::DirtyTracker<1_KiB, 256>;
+using OAMTracker = common::DirtyTracker<1_KiB, 256>;
+
+//The registers needed to draw a single line, captured by the PPU at H-Blank.
+struct LineSnapshot {
+    u8 line;
+    bool present; //Present the frame instead of drawing a line
+    u16 dispcnt;
+    u16 bldcnt;
+    u16 bldalpha;
+    u32 bldy;
+    u32 mosaic;
+    Background bg[4];
+    Window win;
+
+    //Number of bytes in the delta buffer that have to be applied before drawing
+    u32 delta_size;
+};
+
+/*
+ * Draws scanlines on a separate thread. The emulation thread submits a register
+ * snapshot for every line along with copies of any VRAM, palette, or OAM blocks
+ * written since the previous line. The render thread applies those to its own
+ * copy of the PPU state, so the two threads never share memory besides the queues.
+ */
+class RenderThread final {
+public:
+
+    explicit RenderThread(VideoDevice &video_device);
+    ~RenderThread();
+
+    void submitLine(const PPUState &state, VRAMTracker &vram_dirty, PaletteTracker &palette_dirty, OAMTracker &oam_dirty);
+    void submitPresent();
+    void flush();
+
+private:
+
+    enum DeltaRegion : u8 {
+        DELTA_VRAM,
+        DELTA_PALETTE,
+        DELTA_OAM
+    };
+
+    void pushDelta(DeltaRegion region, u32 offset, const u8 *data, u32 &delta_size);
+    void pushSnapshot(const LineSnapshot &snapshot);
+    void applyDeltas(u32 size);
+    auto waitForLine(LineSnapshot &snapshot) -> bool;
+    void notifyRenderer();
+    void notifyEmulator();
+    void run();
+
+    template<typename Condition>
+    void waitForRenderer(Condition condition);
+
+    static constexpr size_t BLOCK_SIZE = VRAMTracker::BLOCK_SIZE;
+    static constexpr size_t DELTA_HEADER_SIZE = 4;
+
+    VideoDevice &video_device;
+    std::unique_ptr<PPUState> state;
+    Renderer renderer;
+
+    //Big enough to hold a copy of all of VRAM, palette, and OAM at once
+    common::SPSCRingBuffer<LineSnapshot, 256> lines;
+    common::SPSCRingBuffer<u8, 256_KiB> deltas;
+
+    u64 lines_submitted;
+    std::atomic<u64> lines_drawn;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    //Either thread only sleeps after saying so, and the other only takes the
+    //lock to wake it when it has, so lines go through without any locking.
+    std::mutex mutex;
+    std::condition_variable line_cv;
+    std::condition_variable drawn_cv;
+    std::atomic<bool> renderer_waiting;
+    std::atomic<bool> emulator_waiting;
+};
+
+} //namespace emu
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include "Renderer.hpp"
+#include "common/Bits.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace emu {
+
+constexpr int OBJECT_WIDTH_LUT[16]  = {8, 16, 32, 64, 16, 32, 32, 64, 8, 8, 16, 32, 0, 0, 0, 0};
+constexpr int OBJECT_HEIGHT_LUT[16] = {8, 16, 32, 64, 8, 8, 16, 32, 16, 32, 32, 64, 0, 0, 0, 0};
+
+
+void Renderer::convertLine(const u16 *colors, u32 *output, [[maybe_unused]] bool vectorized) {
+    size_t i = 0;
+
+    #if defined(__SSE2__)
+    const __m128i alpha = _mm_set1_epi16(0x00FF);
+    const __m128i red_mask = _mm_set1_epi16(0x001F);
+    const __m128i green_mask = _mm_set1_epi16(0x03E0);
+    const __m128i blue_mask = _mm_set1_epi16(0x7C00);
+
+    for(; vectorized && i + 8 <= 240; i += 8) {
+        const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&colors[i]));
+
+        //Low halves are blue and alpha, high halves are red and green
+        const __m128i low = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(color, blue_mask), 1), alpha);
+        const __m128i high = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(color, red_mask), 11), _mm_srli_epi16(_mm_and_si128(color, green_mask), 2));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]), _mm_unpacklo_epi16(low, high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i + 4]), _mm_unpackhi_epi16(low, high));
+    }
+    #endif
+
+    for(; i < 240; i++) {
+        const u8 red   = bits::get<0, 5>(colors[i]);
+        const u8 green = bits::get<5, 5>(colors[i]);
+        const u8 blue  = bits::get<10, 5>(colors[i]);
+        output[i] = (red * 8 << 24) | (green * 8 << 16) | (blue * 8 << 8) | 0xFF;
+    }
+}
+
+void Renderer::drawLine(const PPUState &state, u32 *output) {
+    //Forced Blank
+    if(bits::get_bit<7>(state.dispcnt)) {
+        std::memset(output, 0, 240 * sizeof(u32));
+        return;
+    }
+
+    if(isSimpleBitmapLine(state)) {
+        drawSimpleBitmapLine(state, output);
+        return;
+    }
+
+    clearBuffers();
+    getWindowLine(state);
+    drawBackground(state);
+    drawObjects(state);
+    compositeLine(state, output);
+}
+
+//A bitmap line with no objects, windows, or color effects is just the bitmap itself
+auto Renderer::isSimpleBitmapLine(const PPUState &state) const -> bool {
+    const u8 mode = bits::get<0, 3>(state.dispcnt);
+    const bool effects = bits::get<6, 2>(state.bldcnt) != 0 && bits::get_bit<2>(state.bldcnt);
+
+    return mode >= 3 && mode <= 5 && bits::get_bit<10>(state.dispcnt) && bits::get<12, 4>(state.dispcnt) == 0 && 
+        !effects && !state.bg[2].isRotatedOrScaled();
+}
+
+void Renderer::drawSimpleBitmapLine(const PPUState &state, u32 *output) {
+    const u8 mode = bits::get<0, 3>(state.dispcnt);
+    state.bg[2].getBitmapLine(mode, state.vram, state.palette, bits::get_bit<4>(state.dispcnt), bmp_col);
+    convertLine(bmp_col, output);
+}
+
+void Renderer::clearBuffers() {
+    std::memset(bmp_col, 0, sizeof(bmp_col));
+    std::memset(bg_col[0], 0, sizeof(bg_col[0]));
+    std::memset(bg_col[1], 0, sizeof(bg_col[1]));
+    std::memset(bg_col[2], 0, sizeof(bg_col[2]));
+    std::memset(bg_col[3], 0, sizeof(bg_col[3]));
+    std::memset(obj_col, 0, sizeof(obj_col));
+    std::memset(obj_info, 6, sizeof(obj_info));
+}
+
+void Renderer::getWindowLine(const PPUState &state) {
+    //Get objects that are windows and on this line
+    std::vector<Object> win_objs;
+
+    //TODO: Move to Window class
+    if(bits::get_bit<15>(state.dispcnt)) {
+        for(size_t i = 0; i < 128; i++) {
+            u8 mode = bits::get<2, 2>(state.oam[i * 8 + 1]);
+            u8 flags = bits::get<0, 2>(state.oam[i * 8 + 1]);
+            
+            if(mode == 2 && flags != 2) {
+                const int height = OBJECT_HEIGHT_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
+                const int y = state.oam[i * 8];
+                const int bottom = (y + (flags == 3 ? height * 2 : height)) & 0xFF;
+                bool in_vertical = y <= state.line && state.line < bottom;
+
+                if(bottom < y) {
+                    in_vertical = !(y > state.line && state.line >= bottom);
+                }
+
+                //Check if object is on this line
+                if(in_vertical) {
+                    const int width = OBJECT_WIDTH_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
+                    const int x = ((state.oam[i * 8 + 3] & 1) << 8) | state.oam[i * 8 + 2];
+
+                    //Check if object is visible on screen
+                    if(((x + width) & 0x1FF) < x || x < 240) {
+                        Object obj;
+                        obj.x = x;
+                        obj.y = y > bottom ? bits::sign_extend<8, int>(y) : y;
+                        obj.index = i;
+                        obj.width = width;
+                        obj.height = height;
+                        obj.affine = (flags & 1) == 1;
+                        obj.double_size = flags == 3;
+                        obj.param_select = bits::get<1, 5>(state.oam[i * 8 + 3]);
+                        win_objs.push_back(std::move(obj));
+                    }
+                }
+            }
+        }
+    }
+
+    //Everything is displayed when no windows are enabled
+    if(bits::get<13, 3>(state.dispcnt) == 0) {
+        for(auto &mask : win_mask) {
+            mask.fill();
+        }
+
+        return;
+    }
+
+    LineMask win_0, win_1, obj_win;
+    win_0.clear();
+    win_1.clear();
+    obj_win.clear();
+
+    if(bits::get_bit<13>(state.dispcnt)) {
+        win_0 = state.win.getLineMask(state.line, 0);
+    }
+    if(bits::get_bit<14>(state.dispcnt)) {
+        win_1 = state.win.getLineMask(state.line, 1) & ~win_0;
+    }
+
+    //Object window
+    for(const auto &obj : win_objs) {
+        int local_y = state.line - obj.y;
+        u32 obj_width = obj.double_size ? obj.width * 2 : obj.width;
+
+        for(size_t i = 0; i < obj_width; i++) {
+            int screen_x = obj.getScreenX(i);
+
+            if(screen_x >= 240) {
+                continue;
+            }
+
+            if(obj.getObjectPixel(i, local_y, state) != 0) {
+                obj_win.set(screen_x);
+            }
+        }
+    }
+
+    //Bit 0-3 are bg 0-3 display, bit 4 is obj display, and bit 5 is color effects
+    const u8 win_0_layers = bits::get<0, 6>(state.win.winin);
+    const u8 win_1_layers = bits::get<8, 6>(state.win.winin);
+    const u8 outside_layers = bits::get<0, 6>(state.win.winout);
+    const u8 obj_win_layers = bits::get<8, 6>(state.win.winout);
+
+    //The object window replaces any pixel that has the same settings as outside
+    //the windows, even when it's inside window 0 or 1
+    LineMask replaceable = ~(win_0 | win_1);
+    if(win_0_layers == outside_layers) replaceable = replaceable | win_0;
+    if(win_1_layers == outside_layers) replaceable = replaceable | win_1;
+    obj_win = obj_win & replaceable;
+
+    win_0 = win_0 & ~obj_win;
+    win_1 = win_1 & ~obj_win;
+    const LineMask outside = ~(win_0 | win_1 | obj_win);
+
+    for(int layer = 0; layer < 6; layer++) {
+        win_mask[layer].clear();
+
+        if(bits::get_bit(win_0_layers, layer)) win_mask[layer] = win_mask[layer] | win_0;
+        if(bits::get_bit(win_1_layers, layer)) win_mask[layer] = win_mask[layer] | win_1;
+        if(bits::get_bit(obj_win_layers, layer)) win_mask[layer] = win_mask[layer] | obj_win;
+        if(bits::get_bit(outside_layers, layer)) win_mask[layer] = win_mask[layer] | outside;
+    }
+}
+
+auto Renderer::getSpriteLines(const PPUState &state) -> std::vector<Object> {
+    std::vector<Object> lines;
+
+    for(size_t i = 0; i < 128; i++) {
+        u8 mode = bits::get<2, 2>(state.oam[i * 8 + 1]);
+        u8 flags = bits::get<0, 2>(state.oam[i * 8 + 1]);
+
+        if(mode < 2 && flags != 2) {
+            const int height = OBJECT_HEIGHT_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
+            const int y = state.oam[i * 8];
+            const int bottom = (y + (flags == 3 ? height * 2 : height)) & 0xFF;
+            bool in_vertical = y <= state.line && state.line < bottom;
+
+            if(bottom < y) {
+                in_vertical = !(y > state.line && state.line >= bottom);
+            }
+
+            //Check if object is on this line
+            if(in_vertical) {
+                const int width = OBJECT_WIDTH_LUT[(bits::get<6, 2>(state.oam[i * 8 + 1]) << 2) | bits::get<6, 2>(state.oam[i * 8 + 3])];
+                const int x = ((state.oam[i * 8 + 3] & 1) << 8) | state.oam[i * 8 + 2];
+
+                //Check if object is visible on screen
+                if(((x + width) & 0x1FF) < x || x < 240) {
+                    Object obj;
+                    obj.x = x;
+                    obj.y = y > bottom ? bits::sign_extend<8, int>(y) : y;
+                    obj.index = i;
+                    obj.width = width;
+                    obj.height = height;
+                    obj.affine = (flags & 1) == 1;
+                    obj.double_size = flags == 3;
+                    obj.param_select = bits::get<1, 5>(state.oam[i * 8 + 3]);
+                    lines.push_back(std::move(obj));
+                }
+            }
+        }
+    }
+
+    return lines;
+}
+
+void Renderer::drawObjects(const PPUState &state) {
+    if(!bits::get_bit<12>(state.dispcnt)) {
+        return;
+    }
+
+    std::vector<Object> active_objs = getSpriteLines(state);
+
+    for(const auto &obj : active_objs) {
+        int local_y = state.line - obj.y;
+        const int priority = bits::get<2, 2>(state.oam[obj.index * 8 + 5]);
+        const bool mosaic = bits::get_bit<4>(state.oam[obj.index * 8 + 1]);
+        u32 obj_width = obj.double_size ? obj.width * 2 : obj.width;
+
+        if(mosaic) {
+            int mosaic_h = (bits::get<12, 4>(state.mosaic) + 1);
+            local_y = (state.line / mosaic_h * mosaic_h) - obj.y;
+        }
+
+        for(size_t i = 0; i < obj_width; i++) {
+            int screen_x = obj.getScreenX(i);
+
+            if(screen_x >= 240) {
+                continue;
+            }
+
+            u8 palette_index = obj.getObjectPixel(i, local_y, state);
+
+            if(priority < (obj_info[screen_x] & 7) || obj_col[screen_x] == 0){
+                bool is_semi_transparent = false;
+
+                if(palette_index != 0) {
+                    obj_col[screen_x] = palette_index;
+                    is_semi_transparent = bits::get<2, 2>(state.oam[obj.index * 8 + 1]) == 1;
+                }
+
+                obj_info[screen_x] = priority | (is_semi_transparent  << 3) | (mosaic << 4);
+            }
+        }
+    }
+}
+
+void Renderer::drawBackground(const PPUState &state) {
+    switch(bits::get<0, 3>(state.dispcnt)) {
+        case 0 : //BG 0-3 Text
+            for(size_t i = 0; i < 240; i++) {
+                if(bits::get_bit<8>(state.dispcnt))  bg_col[0][i] = state.bg[0].getTextPixel(i, state.line, state.vram, state);
+                if(bits::get_bit<9>(state.dispcnt))  bg_col[1][i] = state.bg[1].getTextPixel(i, state.line, state.vram, state);
+                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getTextPixel(i, state.line, state.vram, state);
+                if(bits::get_bit<11>(state.dispcnt)) bg_col[3][i] = state.bg[3].getTextPixel(i, state.line, state.vram, state);
+            }
+            break;
+        case 1 : //BG 0-1 Text BG 2 Affine
+            for(size_t i = 0; i < 240; i++) {
+                if(bits::get_bit<8>(state.dispcnt))  bg_col[0][i] = state.bg[0].getTextPixel(i, state.line, state.vram, state);
+                if(bits::get_bit<9>(state.dispcnt))  bg_col[1][i] = state.bg[1].getTextPixel(i, state.line, state.vram, state);
+                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getAffinePixel(i, state.line, state.vram);
+            }
+            break;
+        case 2 : //BG 2-3 Affine
+            for(size_t i = 0; i < 240; i++) {
+                if(bits::get_bit<10>(state.dispcnt)) bg_col[2][i] = state.bg[2].getAffinePixel(i, state.line, state.vram);
+                if(bits::get_bit<11>(state.dispcnt)) bg_col[3][i] = state.bg[3].getAffinePixel(i, state.line, state.vram);
+            }
+            break;
+        case 3 : //BG 2 Bitmap 1x 240x160 Frame 15-bit color
+            if(bits::get_bit<10>(state.dispcnt)) {
+                for(size_t i = 0; i < 240; i++) {
+                    bmp_col[i] = state.bg[2].getBitmapPixelMode3(i, state.line, state.vram);
+                }
+            }
+            break;
+        case 4 : //BG 2 Bitmap 2x 240x160 Frames Paletted
+            if(bits::get_bit<10>(state.dispcnt)) {
+                for(size_t i = 0; i < 240; i++) {
+                    bmp_col[i] = state.bg[2].getBitmapPixelMode4(i, state.line, state.vram, state.palette, bits::get<4, 1>(state.dispcnt));
+                }
+            }
+            break;
+        case 5 : //BG 2 Bitmap 2x 160x128 Frames 15-bit color
+            if(bits::get_bit<10>(state.dispcnt)) {
+                for(size_t i = 0; i < 240; i++) {
+                    bmp_col[i] = state.bg[2].getBitmapPixelMode5(i, state.line, state.vram, bits::get<4, 1>(state.dispcnt));
+                }
+            }
+            break;
+    }
+}
+
+void Renderer::compositeLine(const PPUState &state, u32 *output) {
+    const u16 zero_color = (state.palette[1] << 8) | state.palette[0];
+    const bool bitmap = bits::get<0, 3>(state.dispcnt) >= 3;
+    u8 priorities[6];
+
+    for(size_t i = 0; i < 240; i++) {
+        for(size_t i = 0; i < 6; i++) {
+            priorities[i] = i << 3;
+        }
+
+        int mosaic = (bits::get<8, 4>(state.mosaic) + 1);
+        int i_mosaic = (obj_info[i] & 0x10) == 0x10 ? i / mosaic * mosaic : i;
+
+        //BG Pixels
+        priorities[0] |= bg_col[0][i] != 0 && win_mask[0].get(i) ? state.bg[0].priority + 1 : 6;
+        priorities[1] |= bg_col[1][i] != 0 && win_mask[1].get(i) ? state.bg[1].priority + 1 : 6;
+        priorities[2] |= (bitmap || bg_col[2][i] != 0) && win_mask[2].get(i) ? state.bg[2].priority + 1 : 6;
+        priorities[3] |= bg_col[3][i] != 0 && win_mask[3].get(i) ? state.bg[3].priority + 1 : 6;
+
+        //Object pixel
+        priorities[4] |= obj_col[i_mosaic] != 0 && win_mask[4].get(i) ? obj_info[i_mosaic] & 7 : 6;
+        
+        //Backdrop
+        priorities[5] |= 5;
+
+        std::sort(&priorities[0], &priorities[6], [](const u8 &a, const u8 &b) {
+            return (a & 7) < (b & 7);
+        });
+
+        u16 target_1 = 0;
+
+        //Find first target (Topmost pixel)
+        switch(priorities[0] >> 3) {
+            case 0 : target_1 = (state.palette[bg_col[0][i] * 2 + 1] << 8) | state.palette[bg_col[0][i] * 2]; break;
+            case 1 : target_1 = (state.palette[bg_col[1][i] * 2 + 1] << 8) | state.palette[bg_col[1][i] * 2]; break;
+            case 2 : target_1 = bitmap ? bmp_col[i] : (state.palette[bg_col[2][i] * 2 + 1] << 8) | state.palette[bg_col[2][i] * 2]; break;
+            case 3 : target_1 = (state.palette[bg_col[3][i] * 2 + 1] << 8) | state.palette[bg_col[3][i] * 2]; break;
+            case 4 : target_1 = (state.palette[0x200 + obj_col[i_mosaic] * 2 + 1] << 8) | state.palette[0x200 + obj_col[i_mosaic] * 2]; break;
+            case 5 : target_1 = zero_color; break;
+        }
+
+        u8 red   = bits::get<0, 5>(target_1);
+        u8 green = bits::get<5, 5>(target_1);
+        u8 blue  = bits::get<10, 5>(target_1);
+
+        //TODO: If semi-transparent obj is 2nd highest priority
+        bool semi_transparent = (priorities[0] >> 3) == 4 && (obj_info[i] & 0x8) == 0x8 && bits::get_bit(state.bldcnt, 8 + (priorities[1] >> 3));
+
+        //Color Effects
+        if((priorities[0] & 7) < 6 && (semi_transparent || bits::get_bit(state.bldcnt, priorities[0] >> 3)) && win_mask[5].get(i)) {
+            switch(semi_transparent ? 1 : bits::get<6, 2>(state.bldcnt)) {
+                case 1 : //Alpha Blending
+                    if(bits::get_bit(state.bldcnt, 8 + (priorities[1] >> 3))) {
+                        float blend_a1 = (float)(state.bldalpha & 0x1F) / 16.0f;
+                        if(blend_a1 > 1.0f) {
+                            blend_a1 = 1.0f;
+                        }
+                        float blend_a2 = (float)((state.bldalpha >> 8) & 0x1F) / 16.0f;
+                        if(blend_a2 > 1.0f) {
+                            blend_a2 = 1.0f;
+                        }
+                        u16 target_2 = 0;
+
+                        //Find second target (Next topmost pixel)
+                        switch(priorities[1] >> 3) {
+                            case 0 : target_2 = (state.palette[bg_col[0][i] * 2 + 1] << 8) | state.palette[bg_col[0][i] * 2]; break;
+                            case 1 : target_2 = (state.palette[bg_col[1][i] *  2 + 1] << 8) | state.palette[bg_col[1][i] * 2]; break;
+                            case 2 : target_2 = bitmap ? bmp_col[i] : (state.palette[bg_col[2][i] * 2 + 1] << 8) | state.palette[bg_col[2][i] * 2]; break;
+                            case 3 : target_2 = (state.palette[bg_col[3][i] * 2 + 1] << 8) | state.palette[bg_col[3][i] * 2]; break;
+                            case 4 : target_2 = (state.palette[0x200 + obj_col[i_mosaic] * 2 + 1] << 8) | state.palette[0x200 + obj_col[i_mosaic] * 2]; break;
+                            case 5 : target_2 = zero_color; break;
+                        } 
+
+                        const u8 red_2   = bits::get<0, 5>(target_2);
+                        const u8 green_2 = bits::get<5, 5>(target_2);
+                        const u8 blue_2  = bits::get<10, 5>(target_2);
+
+                        red   = blend_a1 * (float)red + blend_a2 * (float)red_2;
+                        green = blend_a1 * (float)green + blend_a2 * (float)green_2;
+                        blue  = blend_a1 * (float)blue + blend_a2 * (float)blue_2;
+                    }
+                    break;
+                case 2 : { //Brightness Increase
+                    float blend_y = (float)(state.bldy & 0x1F) / 16.0f;
+                    if(blend_y > 1.0f) {
+                        blend_y = 1.0f;
+                    }
+
+                    red   = (float)red + blend_y * (float)(31 - red);
+                    green = (float)green + blend_y * (float)(31 - green);
+                    blue  = (float)blue + blend_y * (float)(31 - blue);
+                    break;
+                }
+                case 3 : { //Brightness Decrease
+                    float blend_y = (float)(state.bldy & 0x1F) / 16.0f;
+                    if(blend_y > 1.0f) {
+                        blend_y = 1.0f;
+                    }
+
+                    red   = (float)red - blend_y * (float)red;
+                    green = (float)green - blend_y * (float)green;
+                    blue  = (float)blue - blend_y * (float)blue;
+                    break;
+                }
+            }
+
+            red   = red > 31 ? 31 : red;
+            green = green > 31 ? 31 : green;
+            blue  = blue > 31 ? 31 : blue;
+        }
+
+    
+        output[i] = (red * 8 << 24) | (green * 8 << 16) | (blue * 8 << 8) | 0xFF;
+    }
+}
+
+} //namespace emu
\ No newline at end of file
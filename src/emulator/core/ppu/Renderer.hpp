@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Types.hpp"
+#include <vector>
+
+
+namespace emu {
+
+/*
+ * Draws scanlines from a PPUState. It only holds the intermediate line buffers,
+ * so it can be used either directly by the PPU or from a separate render thread
+ * that has its own copy of the state.
+ */
+class Renderer final {
+public:
+
+    void drawLine(const PPUState &state, u32 *output);
+
+    //Converts a line of BGR555 colors to the RGBA8888 used by the video device,
+    //using SSE2 where it's available unless vectorized is false
+    static void convertLine(const u16 *colors, u32 *output, bool vectorized = true);
+
+private:
+
+    auto isSimpleBitmapLine(const PPUState &state) const -> bool;
+    void drawSimpleBitmapLine(const PPUState &state, u32 *output);
+
+    void clearBuffers();
+    void getWindowLine(const PPUState &state);
+    auto getSpriteLines(const PPUState &state) -> std::vector<Object>;
+    void drawObjects(const PPUState &state);
+    void drawBackground(const PPUState &state);
+    void compositeLine(const PPUState &state, u32 *output);
+
+    LineMask win_mask[6]; //BG 0-3, OBJ, and color effects
+    u16 bmp_col[240];
+    u16 bg_col[4][240];
+    u16 obj_col[240];
+    u8 obj_info[240];
+};
+
+} //namespace emu
\ No newline at end of file
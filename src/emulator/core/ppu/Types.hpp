@@ -5,6 +5,14 @@
 
 namespace emu {
 
+//Which frames the PPU actually draws. Timing, interrupts, and DMA are
+//unaffected by this, only the output to the video device is skipped.
+enum RenderPolicy {
+    RENDER_ALL,
+    RENDER_INTERVAL, //Only every Nth frame
+    RENDER_NONE
+};
+
 struct PPUState {
     u8 line;
     u16 dispcnt;
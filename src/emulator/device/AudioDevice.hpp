@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 
 namespace emu {
 
@@ -7,7 +8,8 @@ class AudioDevice {
 public:
 
     virtual void pushSample(float left, float right) = 0;
-    virtual auto full() -> bool = 0;
+    virtual void pushSamples(const float *samples, size_t count) = 0; //count stereo pairs, interleaved left/right
+    virtual auto full() -> bool = 0; //Enough samples are queued that the emulator can wait
     virtual void setSampleRate(int resolution) = 0;
 };
 
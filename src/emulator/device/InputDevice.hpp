@@ -1,7 +1,6 @@
 #pragma once
 
 #include "common/Types.hpp"
-#include <functional>
 
 
 namespace emu {
@@ -10,12 +9,8 @@ class InputDevice {
 public:
 
     //Returns the keys in the same format as the KEYINPUT register (i.e. 0 is pressed and only bits 0-9 are used).
+    //Polled by the keypad on the emulator thread, once every scanline.
     virtual auto getKeys() -> u16 = 0;
-    void onInput(const std::function<void()> &callback) { this->callback = callback; }
-
-protected:
-
-    std::function<void()> callback;
 };
 
 } //namespace emu
\ No newline at end of file
@@ -1,10 +1,29 @@
 #include "EmuThread.hpp"
+#include "common/Log.hpp"
+#include <chrono>
 
 
-EmuThread::EmuThread(std::shared_ptr<emu::GBA> core) : core(core) {
+//Only draw one in every few frames while fast forwarding, since the
+//screen can't show them all anyway
+constexpr u32 FASTFORWARD_RENDER_INTERVAL = 4;
+
+constexpr u32 CYCLES_PER_FRAME = 280896;
+constexpr std::chrono::nanoseconds FRAME_DURATION(1000000000ull * CYCLES_PER_FRAME / 16777216);
+
+//Small enough that commands and the audio device get checked often, but
+//large enough that the cost of calling into the core doesn't matter
+constexpr u32 CYCLES_PER_SLICE = CYCLES_PER_FRAME / 4;
+
+EmuThread::EmuThread(std::shared_ptr<emu::GBA> core) : core(core), run_ahead(*core) {
     cycle_diff = 0;
     running.store(false);
+    paused.store(false);
     fastforward.store(false);
+    pacing_mode.store(AUDIO_SYNC);
+    rewind_enabled = false;
+    rewind_interval = 1;
+    frames_since_capture = 0;
+    rewinding.store(false);
 
     core->debug.setCallback([this]() {
         mutex.lock();
@@ -16,29 +35,58 @@ EmuThread::EmuThread(std::shared_ptr<emu::GBA> core) : core(core) {
 }
 
 EmuThread::~EmuThread() {
-    if(thread.joinable()) {
-        thread.join();
-    }
+    stop();
 }
 
 void EmuThread::start() {
-    //Don't do anything if already running
+    //Don't do anything if already running, other than unpausing
     if(thread.joinable()) {
         if(!running.load()) {
             thread.join();
         } else {
+            resume();
             return;
         }
     }
 
+    cycle_diff = 0;
+    cmd_queue.clear();
+    paused.store(false);
+    running.store(true);
+
     thread = std::thread([this]() {
         processCommands();
     });
 }
 
+//Blocks until the thread has exited, interrupting the core if it's in the middle of running
 void EmuThread::stop() {
+    if(!thread.joinable()) {
+        return;
+    }
+
+    core->requestStop();
     sendCommand(TERMINATE);
-    while(running.load()) { }
+    thread.join();
+}
+
+//Blocks until the thread is idle, after which the core can be safely accessed until resume()
+void EmuThread::pause() {
+    if(!running.load() || paused.load()) {
+        return;
+    }
+
+    core->requestStop();
+    sendCommand(PAUSE);
+
+    std::unique_lock lock(mutex);
+    state_cv.wait(lock, [this]() { return paused.load() || !running.load(); });
+}
+
+void EmuThread::resume() {
+    if(paused.load()) {
+        sendCommand(RESUME);
+    }
 }
 
 void EmuThread::sendCommand(Command cmd) {
@@ -50,52 +98,236 @@ void EmuThread::sendCommand(Command cmd) {
 
 void EmuThread::setFastforward(bool enable) {
     fastforward.store(enable);
+
+    if(enable) {
+        core->ppu.setRenderPolicy(emu::RENDER_INTERVAL, FASTFORWARD_RENDER_INTERVAL);
+    } else {
+        core->ppu.setRenderPolicy(emu::RENDER_ALL);
+    }
 }
 
 auto EmuThread::fastforwarding() -> bool {
     return fastforward.load();
 }
 
+void EmuThread::setPacingMode(PacingMode mode) {
+    if(mode < VIDEO_SYNC || mode > FREE_RUN) {
+        LOG_WARNING("Unknown pacing mode {}, using audio sync", static_cast<int>(mode));
+        mode = AUDIO_SYNC;
+    }
+
+    pacing_mode.store(mode);
+
+    //Wake the thread in case it's waiting on something the new mode doesn't use
+    sendCommand(RUN);
+}
+
+auto EmuThread::getPacingMode() const -> PacingMode {
+    return pacing_mode.load();
+}
+
+//A state is captured every interval frames, older ones are dropped once capacity bytes are used
+void EmuThread::setRewind(bool enable, u32 interval, size_t capacity) {
+    bool was_running = isRunning();
+    pause();
+
+    rewind_enabled = enable;
+    rewind_interval = interval == 0 ? 1 : interval;
+    rewind.setCapacity(enable ? capacity : 0);
+    frames_since_capture = 0;
+
+    if(was_running) {
+        resume();
+    }
+}
+
+void EmuThread::clearRewind() {
+    bool was_running = isRunning();
+    pause();
+
+    rewind.clear();
+    frames_since_capture = 0;
+
+    if(was_running) {
+        resume();
+    }
+}
+
+//While set, the thread steps back one captured state every frame instead of running
+void EmuThread::setRewinding(bool enable) {
+    rewinding.store(enable);
+    sendCommand(RUN);
+}
+
+auto EmuThread::isRewinding() const -> bool {
+    return rewinding.load();
+}
+
+//Number of frames to run ahead of the real one and show instead, 0 to turn it off
+void EmuThread::setRunAhead(u32 frames) {
+    bool was_running = isRunning();
+    pause();
+
+    run_ahead.setFrames(frames);
+
+    if(was_running) {
+        resume();
+    }
+}
+
+//Not counting while paused
 auto EmuThread::isRunning() const -> bool {
-    return running.load();
+    return running.load() && !paused.load();
 }
 
 void EmuThread::processCommands() {
+    using clock = std::chrono::steady_clock;
+
     bool finished = false;
-    cycle_diff = 0;
-    cmd_queue.clear();
-    running.store(true);
+    clock::time_point next_frame = clock::now();
 
     while(!finished) {
-        Command cmd;
-
-        if(fastforward.load()) {
-            core->run(16777216 / 64);
-
-            if(cmd_queue.size() == 0) {
-                continue;
+        //Commands are handled between every slice, RUN only exists to wake the thread up
+        while(cmd_queue.size() > 0) {
+            switch(cmd_queue.pop()) {
+                case RUN : break;
+                case PAUSE : setPaused(true); break;
+                case RESUME : setPaused(false); next_frame = clock::now(); break;
+                case TERMINATE : finished = true; break;
             }
+        }
 
-            cmd = cmd_queue.pop();
-        } else {
+        if(finished) {
+            break;
+        }
+
+        if(paused.load()) {
             std::unique_lock lock(mutex);
             cv.wait(lock, [this]() { return cmd_queue.size() > 0; });
-            cmd = cmd_queue.pop();
-            lock.unlock();
+            continue;
         }
 
-        switch(cmd) {
-            case RUN : 
-                if(!fastforward) {
-                    cycle_diff += 16777216 / 64;
-                    u32 actual = core->run(cycle_diff);
-                    cycle_diff = cycle_diff - actual;
+        //Rewinding always goes at the GBA's frame rate, whatever the pacing mode
+        if(rewinding.load()) {
+            if(waitForFrame(next_frame)) {
+                stepBack();
+            }
+
+            continue;
+        }
+
+        const PacingMode mode = fastforward.load() ? FREE_RUN : pacing_mode.load();
+
+        switch(mode) {
+            case VIDEO_SYNC :
+                if(waitForFrame(next_frame)) {
+                    runCycles(CYCLES_PER_FRAME);
                 }
                 break;
 
-            case TERMINATE : finished = true; break;
+            case AUDIO_SYNC :
+            default :
+                //The audio device sends a RUN command every time it consumes samples
+                if(core->audio_device.full()) {
+                    std::unique_lock lock(mutex);
+                    cv.wait(lock, [this]() { return cmd_queue.size() > 0; });
+                    continue;
+                }
+
+                runCycles(CYCLES_PER_SLICE);
+                next_frame = clock::now();
+                break;
+
+            case FREE_RUN :
+                runCycles(CYCLES_PER_SLICE);
+                next_frame = clock::now();
+                break;
         }
     }
 
+    //The stop request came with the command that ended the loop, so it's been handled
+    core->clearStopRequest();
+
+    mutex.lock();
+    paused.store(false);
     running.store(false);
+    mutex.unlock();
+    state_cv.notify_all();
+}
+
+void EmuThread::setPaused(bool paused) {
+    //Same as when stopping, the request was only needed to get here quickly
+    core->clearStopRequest();
+
+    mutex.lock();
+    this->paused.store(paused);
+    mutex.unlock();
+    state_cv.notify_all();
+}
+
+//Waits until the next frame is due, returns false if woken up early by a command
+auto EmuThread::waitForFrame(std::chrono::steady_clock::time_point &next_frame) -> bool {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if(now < next_frame) {
+        std::unique_lock lock(mutex);
+        cv.wait_until(lock, next_frame, [this]() { return cmd_queue.size() > 0; });
+        return false;
+    }
+
+    //Don't try to make up for a long stall all at once, start pacing again from now
+    if(now - next_frame > FRAME_DURATION * 4) {
+        next_frame = now;
+    }
+
+    next_frame += FRAME_DURATION;
+    return true;
+}
+
+//Keeps track of how far the core overshot, so the average speed comes out exact.
+//Stops at every V-Blank on the way, so rewind captures and run-ahead happen at
+//the same point in every frame.
+void EmuThread::runCycles(u32 cycles) {
+    cycle_diff += cycles;
+
+    while(cycle_diff > 0) {
+        cycle_diff -= core->run(cycle_diff, true);
+
+        if(!core->frame_ended) {
+            break;
+        }
+
+        captureRewind();
+        run_ahead.run();
+    }
+}
+
+void EmuThread::captureRewind() {
+    if(!rewind_enabled || ++frames_since_capture < rewind_interval) {
+        return;
+    }
+
+    frames_since_capture = 0;
+    core->saveState(rewind_capture);
+    rewind.push(rewind_capture);
+}
+
+//Loads the previous captured state and runs a frame from it, so there's something to show
+void EmuThread::stepBack() {
+    if(!rewind.pop(rewind_state)) {
+        return;
+    }
+
+    //Nothing older can be reached without this one, so carry on from where it is
+    if(!core->loadState(rewind_state.data(), rewind_state.size())) {
+        LOG_ERROR("Failed to load rewind state!");
+        rewind.clear();
+        return;
+    }
+
+    //States are captured at V-Blank, so this runs exactly one frame
+    cycle_diff = 0;
+    frames_since_capture = 0;
+    core->runFrame();
+    run_ahead.run();
 }
\ No newline at end of file
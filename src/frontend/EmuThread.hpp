@@ -1,17 +1,29 @@
 #pragma once
 
 #include "emulator/core/GBA.hpp"
+#include "emulator/core/RunAhead.hpp"
+#include "common/RewindBuffer.hpp"
 #include "common/Types.hpp"
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <condition_variable>
 
 
 enum Command {
     RUN,
+    PAUSE,
+    RESUME,
     TERMINATE
 };
 
+//What the emulation thread times itself against
+enum PacingMode {
+    VIDEO_SYNC, //Run frames at the GBA's refresh rate using a high resolution clock
+    AUDIO_SYNC, //Run whenever the audio device needs more samples
+    FREE_RUN    //Run as fast as possible
+};
+
 class EmuThread final {
 public:
 
@@ -20,25 +32,52 @@ public:
 
     void start();
     void stop();
+    void pause();
+    void resume();
     void sendCommand(Command cmd);
     void setFastforward(bool enable);
     auto fastforwarding() -> bool;
+    void setPacingMode(PacingMode mode);
+    auto getPacingMode() const -> PacingMode;
+    void setRewind(bool enable, u32 interval, size_t capacity);
+    void clearRewind();
+    void setRewinding(bool enable);
+    auto isRewinding() const -> bool;
+    void setRunAhead(u32 frames);
 
     auto isRunning() const -> bool;
 
 private:
 
     void processCommands();
+    auto waitForFrame(std::chrono::steady_clock::time_point &next_frame) -> bool;
+    void runCycles(u32 cycles);
+    void captureRewind();
+    void stepBack();
+    void setPaused(bool paused);
 
     std::shared_ptr<emu::GBA> core;
 
     std::thread thread;
     std::atomic<bool> running;
+    std::atomic<bool> paused;
 
     std::condition_variable cv;
+    std::condition_variable state_cv; //Signaled when the thread pauses or exits
     std::mutex mutex;
     s32 cycle_diff;
 
     common::ThreadSafeRingBuffer<Command, 20> cmd_queue;
     std::atomic<bool> fastforward;
+    std::atomic<PacingMode> pacing_mode;
+
+    //Only touched by the emulation thread, or while it's paused
+    common::RewindBuffer rewind;
+    common::IncrementalSerializer rewind_capture;
+    std::vector<u8> rewind_state;
+    bool rewind_enabled;
+    u32 rewind_interval;
+    u32 frames_since_capture;
+    std::atomic<bool> rewinding;
+    emu::RunAhead run_ahead;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "common/Version.hpp"
 #include "common/Log.hpp"
 #include "common/File.hpp"
+#include "common/MappedFile.hpp"
+#include "common/StatePack.hpp"
 #include "fonts/RubikRegular.hpp"
 #include "fonts/NotoSansMonoMedium.hpp"
 #include <imgui.h>
@@ -13,7 +15,7 @@
 
 Frontend::Frontend(GLFWwindow *glfw_window) : window(glfw_window), input_device(glfw_window),
 audio_device([this](bool new_samples, float *samples, size_t buffer_size) { audioCallback(new_samples, samples, buffer_size); }),
-core(std::make_shared<emu::GBA>(video_device, input_device, audio_device)), emu_thread(core) {
+movie_recorder(input_device), core(std::make_shared<emu::GBA>(video_device, movie_recorder, audio_device)), emu_thread(core) {
     LOG_DEBUG("Initializing Frontend...");
 
     //Set window stuff
@@ -29,8 +31,9 @@ core(std::make_shared<emu::GBA>(video_device, input_device, audio_device)), emu_
     glfwSetWindowUserPointer(window, &user_data);
     glfwSetWindowSizeCallback(window, windowSizeCallback);
 
-    user_data = {this, core};
+    user_data = {this, core, &input_device};
     rom_loaded = false;
+    last_autosave = std::chrono::steady_clock::now();
     bios_loaded = false;
     show_bios_popup = false;
     bios_dirty = false;
@@ -68,6 +71,10 @@ void Frontend::init() {
     ImGui::EndFrame();
 
     settings.loadConfigFile();
+    core->ppu.setThreadedRendering(settings.threaded_renderer);
+    emu_thread.setPacingMode(static_cast<PacingMode>(settings.pacing_mode));
+    emu_thread.setRunAhead(settings.run_ahead);
+    emu_thread.setRewind(settings.rewind_enabled, settings.rewind_interval, settings.rewind_buffer_size * 1_MiB);
     refreshScreenDimensions();
     refreshGameList();
 }
@@ -75,6 +82,7 @@ void Frontend::init() {
 void Frontend::shutdown() {
     emu_thread.stop();
     audio_device.stop();
+    stopRecording();
 
     settings.writeConfigFile();
 
@@ -86,6 +94,24 @@ void Frontend::shutdown() {
 void Frontend::mainloop() {
     while(!glfwWindowShouldClose(window)) {
         glfwPollEvents();
+
+        //Held rather than pressed, so it's polled instead of going through the key callback
+        bool rewind_held = rom_loaded && settings.rewind_enabled && !ImGui::GetIO().WantCaptureKeyboard &&
+            glfwGetKey(window, settings.rewind_key) == GLFW_PRESS;
+
+        if(rewind_held != emu_thread.isRewinding()) {
+            emu_thread.setRewinding(rewind_held);
+        }
+
+        //Only counts time spent playing, saving doesn't stop the emulator for long enough to notice
+        auto now = std::chrono::steady_clock::now();
+        if(!rom_loaded || !settings.autosave_enabled || !emu_thread.isRunning()) {
+            last_autosave = now;
+        } else if(now - last_autosave >= std::chrono::seconds(settings.autosave_interval)) {
+            saveState(autosave_path);
+            last_autosave = now;
+        }
+
         drawInterface();
         glfwSwapBuffers(window);
     }
@@ -105,35 +131,40 @@ void Frontend::stopEmulation() {
     emu_thread.stop();
 }
 
+void Frontend::pauseEmulation() {
+    audio_device.stop();
+    emu_thread.pause();
+}
+
 void Frontend::resetEmulation() {
-    bool was_running = emu_thread.isRunning();
+    stopRecording();
 
-    if(was_running) {
-        stopEmulation();
-    }
+    bool was_running = emu_thread.isRunning();
+    emu_thread.pause();
 
     core->reset(settings.skip_bios, settings.enable_debugger);
+    emu_thread.clearRewind();
     audio_buffer_sizes.clear();
 
     if(was_running) {
-        startEmulation();
+        emu_thread.resume();
     }
 }
 
 void Frontend::resetAndLoad(const std::string &path) {
-    bool was_running = emu_thread.isRunning();
+    stopRecording();
 
-    if(was_running) {
-        stopEmulation();
-    }
+    bool was_running = emu_thread.isRunning();
+    emu_thread.pause();
     
     if(loadROM(path)) {
         core->reset(settings.skip_bios, settings.enable_debugger);
+        emu_thread.clearRewind();
         audio_buffer_sizes.clear();
     }
 
     if(was_running) {
-        startEmulation();
+        emu_thread.resume();
     }
 }
 
@@ -147,6 +178,7 @@ auto Frontend::loadROM(const std::string &path) -> bool {
     if(core->bus.pak.loadFile(path)) {
         core->cpu.flushPipeline();
         rom_loaded = true;
+        autosave_path = std::filesystem::path(path).replace_extension(".autosave").string();
 
         //Set Window title to the title in the ROM's header
         glfwSetWindowTitle(window, fmt::format("Gambit  [{}] - {}", common::GIT_DESC, core->bus.pak.getTitle()).c_str());
@@ -176,37 +208,97 @@ auto Frontend::loadBIOS(const std::string &path) -> bool {
 }
 
 void Frontend::loadState(const std::string &path) {
-    std::ifstream file(path, std::ios_base::binary);
-    if(!file.is_open()) {
+    //The file might still be on its way to disk
+    state_writer.wait();
+
+    common::MappedFile file;
+    if(!file.open(path)) {
         LOG_ERROR("Failed to open file '{}' for loading state!", path);
         return;
     }
+
+    //States that aren't compressed are loaded straight from the mapping, so only
+    //the pages that differ get copied. Compressed ones are unpacked into memory first
+    std::vector<u8> unpacked;
+    const u8 *state = file.data();
+    size_t state_size = file.size();
+
+    if(common::isPackedState(file.data(), file.size()) && !common::unpackState(file.data(), file.size(), unpacked, state, state_size)) {
+        return;
+    }
+
+    //Checked first so a bad file doesn't stop the recording
+    if(!core->checkState(state, state_size)) {
+        LOG_ERROR("Failed to load state from '{}'!", path);
+        return;
+    }
+
+    //The movie wouldn't lead to the loaded state anymore
+    stopRecording();
     
     bool was_running = emu_thread.isRunning();
-    stopEmulation();
-    core->loadState(file);
+    emu_thread.pause();
+
+    if(!core->loadState(state, state_size)) {
+        LOG_ERROR("Failed to load state from '{}'!", path);
+    }
     
     if(was_running) {
-        startEmulation();
+        emu_thread.resume();
     }
 }
 
+//Only snapshots the state here, it's packed and written out in the background
 void Frontend::saveState(const std::string &path) {
-    std::ofstream file(path, std::ios_base::binary);
-    if(!file.is_open()) {
-        LOG_ERROR("Failed to open file '{}' for saving state!", path);
-        return;
-    }
+    std::vector<u8> state;
     
     bool was_running = emu_thread.isRunning();
-    stopEmulation();
-    core->saveState(file);
+    emu_thread.pause();
+    core->saveState(state);
     
     if(was_running) {
-        startEmulation();
+        emu_thread.resume();
+    }
+
+    std::vector<u32> frame;
+    if(settings.state_thumbnails) {
+        const u32 *pixels = video_device.getPresentedFrame();
+        frame.assign(pixels, pixels + 240 * 160);
+    }
+
+    state_writer.write(path, std::move(state), std::move(frame), settings.compress_states);
+}
+
+//Starts from a snapshot of the current state, so the movie plays back from exactly here
+void Frontend::startRecording(const std::string &path) {
+    stopRecording();
+
+    bool was_running = emu_thread.isRunning();
+    emu_thread.pause();
+    movie_recorder.start(*core);
+    movie_path = path;
+
+    if(was_running) {
+        emu_thread.resume();
     }
 }
 
+void Frontend::stopRecording() {
+    if(!movie_recorder.isRecording()) {
+        return;
+    }
+
+    bool was_running = emu_thread.isRunning();
+    emu_thread.pause();
+    movie_recorder.stop();
+
+    if(was_running) {
+        emu_thread.resume();
+    }
+
+    movie_recorder.getMovie().save(movie_path);
+}
+
 auto Frontend::getWindow() -> GLFWwindow* {
     return window;
 }
@@ -220,6 +312,10 @@ void Frontend::setSettings(const Settings &new_settings) {
     bool rom_path_changed = settings.rom_path != new_settings.rom_path;
     bool bios_path_changed = settings.bios_path != new_settings.bios_path;
     bool input_source_changed = settings.input_source != new_settings.input_source;
+    bool run_ahead_changed = settings.run_ahead != new_settings.run_ahead;
+    bool rewind_changed = settings.rewind_enabled != new_settings.rewind_enabled ||
+        settings.rewind_interval != new_settings.rewind_interval ||
+        settings.rewind_buffer_size != new_settings.rewind_buffer_size;
     settings = new_settings;
 
     if(status_bar_changed) {
@@ -237,6 +333,17 @@ void Frontend::setSettings(const Settings &new_settings) {
     if(input_source_changed) {
         input_device.updateInputSource(settings.input_source);
     }
+
+    core->ppu.setThreadedRendering(settings.threaded_renderer);
+    emu_thread.setPacingMode(static_cast<PacingMode>(settings.pacing_mode));
+
+    if(run_ahead_changed) {
+        emu_thread.setRunAhead(settings.run_ahead);
+    }
+
+    if(rewind_changed) {
+        emu_thread.setRewind(settings.rewind_enabled, settings.rewind_interval, settings.rewind_buffer_size * 1_MiB);
+    }
 }
 
 auto Frontend::getGamePakHeader() -> const emu::GamePakHeader& {
@@ -381,7 +488,7 @@ void Frontend::drawInterface() {
         if(ImGui::BeginMenu("Emulation")) {
             if(ImGui::MenuItem("Pause", nullptr, rom_loaded && !emu_thread.isRunning(), rom_loaded)) {
                 if(emu_thread.isRunning()) {
-                    stopEmulation();
+                    pauseEmulation();
                 } else {
                     startEmulation();
                 }
@@ -400,9 +507,12 @@ void Frontend::drawInterface() {
             }
 
             if(ImGui::MenuItem("Stop", nullptr, nullptr, rom_loaded)) {
+                stopRecording();
                 stopEmulation();
                 core->bus.pak.unload();
                 emu_thread.setFastforward(false);
+                emu_thread.setRewinding(false);
+                emu_thread.clearRewind();
                 video_device.clear(0);
                 audio_device.clear();
                 rom_loaded = false;
@@ -417,6 +527,16 @@ void Frontend::drawInterface() {
             if(ImGui::MenuItem("Load State", nullptr, nullptr, rom_loaded)) {
                 file_dialog.open(ui::FileDialogType::STATE_LOAD);
             }
+
+            ImGui::Separator();
+
+            if(ImGui::MenuItem("Record Movie", nullptr, nullptr, rom_loaded && !movie_recorder.isRecording())) {
+                file_dialog.open(ui::FileDialogType::MOVIE_RECORD);
+            }
+
+            if(ImGui::MenuItem("Stop Recording", nullptr, nullptr, movie_recorder.isRecording())) {
+                stopRecording();
+            }
             ImGui::EndMenu();
         }
 
@@ -612,7 +732,10 @@ void Frontend::endFrame() {
 }
 
 void Frontend::audioCallback(bool new_samples, float *samples, size_t buffer_size) {
-    emu_thread.sendCommand(RUN);
+    if(emu_thread.getPacingMode() == AUDIO_SYNC) {
+        emu_thread.sendCommand(RUN);
+    }
+
     audio_buffer_sizes.push(buffer_size);
 
     if(!new_samples) {
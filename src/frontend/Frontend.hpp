@@ -1,7 +1,9 @@
 #pragma once
 
 #include "EmuThread.hpp"
+#include "StateWriter.hpp"
 #include "emulator/core/GBA.hpp"
+#include "emulator/core/InputMovie.hpp"
 #include "device/GLFWInputDevice.hpp"
 #include "device/OGLVideoDevice.hpp"
 #include "device/MAAudioDevice.hpp"
@@ -20,12 +22,15 @@ public:
     void mainloop();
     void startEmulation();
     void stopEmulation();
+    void pauseEmulation();
     void resetEmulation();
     void resetAndLoad(const std::string &path);
     auto loadROM(const std::string &path) -> bool;
     auto loadBIOS(const std::string &path) -> bool;
     void loadState(const std::string &path);
     void saveState(const std::string &path);
+    void startRecording(const std::string &path);
+    void stopRecording();
     auto getWindow() -> GLFWwindow*;
     auto getSettings() -> const Settings&;
     void setSettings(const Settings &new_settings);
@@ -54,13 +59,18 @@ private:
     OGLVideoDevice video_device;
     GLFWInputDevice input_device;
     MAAudioDevice audio_device;
+    emu::MovieRecorder movie_recorder;
     std::shared_ptr<emu::GBA> core;
     EmuThread emu_thread;
+    StateWriter state_writer;
 
     bool rom_loaded;
     bool bios_loaded;
     bool show_bios_popup;
     bool bios_dirty;
+    std::string autosave_path;
+    std::string movie_path;
+    std::chrono::time_point<std::chrono::steady_clock> last_autosave;
     float screen_width, screen_height;
     float frame_height;
     Settings settings;
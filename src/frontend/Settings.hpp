@@ -4,6 +4,7 @@
 #include "common/Log.hpp"
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <filesystem>
@@ -45,6 +46,19 @@ struct Settings {
     std::string rom_path;
     std::string bios_path;
     bool skip_bios = true;
+    bool threaded_renderer = false;
+    int pacing_mode = 1; //Audio sync
+    int run_ahead = 0; //Frames
+
+    bool rewind_enabled = true;
+    int rewind_interval = 2; //Frames between captured states
+    int rewind_buffer_size = 64; //MiB
+    int rewind_key = GLFW_KEY_BACKSPACE;
+
+    bool autosave_enabled = true;
+    int autosave_interval = 30; //Seconds
+    bool state_thumbnails = true;
+    bool compress_states = true; //Uncompressed ones are bigger, but load straight from the file
 
     int input_source = 0;
     int key_map[10];
@@ -84,6 +98,31 @@ struct Settings {
         if(config.values[settings_section].count("skip_bios") != 0) {
             skip_bios = config.values[settings_section]["skip_bios"] == "true";
         }
+        if(config.values[settings_section].count("threaded_renderer") != 0) {
+            threaded_renderer = config.values[settings_section]["threaded_renderer"] == "true";
+        }
+        readNumber(config.values[settings_section], "pacing_mode", pacing_mode, 0, 2);
+        readNumber(config.values[settings_section], "run_ahead", run_ahead, 0, 4);
+        if(config.values[settings_section].count("rewind_enabled") != 0) {
+            rewind_enabled = config.values[settings_section]["rewind_enabled"] == "true";
+        }
+        readNumber(config.values[settings_section], "rewind_interval", rewind_interval, 1, 60);
+        readNumber(config.values[settings_section], "rewind_buffer_size", rewind_buffer_size, 1, 1024);
+        if(config.values[settings_section].count("key/rewind") != 0) {
+            rewind_key = std::stoi(config.values[settings_section]["key/rewind"]);
+        }
+        if(config.values[settings_section].count("autosave_enabled") != 0) {
+            autosave_enabled = config.values[settings_section]["autosave_enabled"] == "true";
+        }
+        if(config.values[settings_section].count("autosave_interval") != 0) {
+            autosave_interval = std::stoi(config.values[settings_section]["autosave_interval"]);
+        }
+        if(config.values[settings_section].count("state_thumbnails") != 0) {
+            state_thumbnails = config.values[settings_section]["state_thumbnails"] == "true";
+        }
+        if(config.values[settings_section].count("compress_states") != 0) {
+            compress_states = config.values[settings_section]["compress_states"] == "true";
+        }
 
         //Load button maps
         for(int i = 0; i < 10; i++) {
@@ -105,6 +144,17 @@ struct Settings {
         config.values[0]["rom_path"] = rom_path;
         config.values[0]["bios_path"] = bios_path;
         config.values[0]["skip_bios"] = skip_bios ? "true" : "false";
+        config.values[0]["threaded_renderer"] = threaded_renderer ? "true" : "false";
+        config.values[0]["pacing_mode"] = std::to_string(pacing_mode);
+        config.values[0]["run_ahead"] = std::to_string(run_ahead);
+        config.values[0]["rewind_enabled"] = rewind_enabled ? "true" : "false";
+        config.values[0]["rewind_interval"] = std::to_string(rewind_interval);
+        config.values[0]["rewind_buffer_size"] = std::to_string(rewind_buffer_size);
+        config.values[0]["key/rewind"] = std::to_string(rewind_key);
+        config.values[0]["autosave_enabled"] = autosave_enabled ? "true" : "false";
+        config.values[0]["autosave_interval"] = std::to_string(autosave_interval);
+        config.values[0]["state_thumbnails"] = state_thumbnails ? "true" : "false";
+        config.values[0]["compress_states"] = compress_states ? "true" : "false";
         config.values[0]["enable_debugger"] = enable_debugger ? "true" : "false";
 
         //Write button maps
@@ -116,6 +166,19 @@ struct Settings {
         common::writeIniFile(config, std::filesystem::current_path().string() + "/config.ini");
     }
 
+    //Keeps value as it is if the key is missing or isn't a number, and within [min, max] otherwise
+    static void readNumber(std::unordered_map<std::string, std::string> &section, const std::string &key, int &value, int min, int max) {
+        if(section.count(key) == 0) {
+            return;
+        }
+
+        try {
+            value = std::clamp(std::stoi(section[key]), min, max);
+        } catch(const std::exception&) {
+            LOG_WARNING("Ignoring '{}' in 'config.ini', '{}' is not a number", key, section[key]);
+        }
+    }
+
     auto operator==(const Settings &other) -> bool {
         return show_status_bar == other.show_status_bar &&
             show_menu_bar == other.show_menu_bar &&
@@ -123,6 +186,17 @@ struct Settings {
             rom_path == other.rom_path &&
             bios_path == other.bios_path &&
             skip_bios == other.skip_bios &&
+            threaded_renderer == other.threaded_renderer &&
+            pacing_mode == other.pacing_mode &&
+            run_ahead == other.run_ahead &&
+            rewind_enabled == other.rewind_enabled &&
+            rewind_interval == other.rewind_interval &&
+            rewind_buffer_size == other.rewind_buffer_size &&
+            rewind_key == other.rewind_key &&
+            autosave_enabled == other.autosave_enabled &&
+            autosave_interval == other.autosave_interval &&
+            state_thumbnails == other.state_thumbnails &&
+            compress_states == other.compress_states &&
             enable_debugger == other.enable_debugger &&
             input_source == other.input_source &&
             std::memcmp(key_map, other.key_map, sizeof(key_map)) == 0 &&
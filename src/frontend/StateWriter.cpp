@@ -0,0 +1,105 @@
+#include "StateWriter.hpp"
+#include "common/StatePack.hpp"
+#include "common/Log.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+
+StateWriter::StateWriter() {
+    busy = false;
+    stopping = false;
+
+    thread = std::thread([this]() {
+        run();
+    });
+}
+
+//Anything still queued is written out first
+StateWriter::~StateWriter() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+}
+
+void StateWriter::write(const std::string &path, std::vector<u8> &&state, std::vector<u32> &&frame, bool compress) {
+    {
+        std::lock_guard lock(mutex);
+
+        //A newer state for the same file replaces one that hasn't been started on yet
+        auto found = std::find_if(jobs.begin(), jobs.end(), [&](const Job &job) { return job.path == path; });
+
+        if(found != jobs.end()) {
+            found->state = std::move(state);
+            found->frame = std::move(frame);
+            found->compress = compress;
+        } else {
+            jobs.push_back(Job{path, std::move(state), std::move(frame), compress});
+        }
+    }
+
+    cv.notify_one();
+}
+
+//Blocks until every state that was queued is on disk
+void StateWriter::wait() {
+    std::unique_lock lock(mutex);
+    idle_cv.wait(lock, [this]() { return jobs.empty() && !busy; });
+}
+
+void StateWriter::run() {
+    std::unique_lock lock(mutex);
+
+    while(true) {
+        cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+        if(jobs.empty()) {
+            break;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+
+        writeFile(job);
+
+        lock.lock();
+        busy = false;
+        idle_cv.notify_all();
+    }
+}
+
+void StateWriter::writeFile(const Job &job) {
+    std::vector<u8> packed;
+    common::packState(job.state, job.frame, job.compress, packed);
+
+    const std::string temp_path = job.path + ".tmp";
+    std::ofstream file(temp_path, std::ios_base::binary);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for saving state!", temp_path);
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    file.close();
+
+    std::error_code error;
+
+    if(!file) {
+        LOG_ERROR("Failed to write state to '{}'!", temp_path);
+        std::filesystem::remove(temp_path, error);
+        return;
+    }
+
+    std::filesystem::rename(temp_path, job.path, error);
+
+    if(error) {
+        LOG_ERROR("Failed to replace '{}' with the new state: {}", job.path, error.message());
+        std::filesystem::remove(temp_path, error);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common/Types.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/*
+ * Writes save states to disk on a worker thread, so the emulator only has to
+ * stop long enough to snapshot into memory. States can be compressed and can
+ * carry a thumbnail of the screen. Each is written to a temporary file and
+ * renamed over the old one, so a crash mid-write never leaves half a state.
+ */
+class StateWriter final {
+public:
+
+    StateWriter();
+    ~StateWriter();
+
+    //The frame is 240x160 RGBA8888 pixels, or empty to leave out the thumbnail
+    void write(const std::string &path, std::vector<u8> &&state, std::vector<u32> &&frame, bool compress);
+    void wait();
+
+private:
+
+    struct Job {
+        std::string path;
+        std::vector<u8> state;
+        std::vector<u32> frame;
+        bool compress;
+    };
+
+    void run();
+    static void writeFile(const Job &job);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;
+    std::deque<Job> jobs;
+    bool busy;
+    bool stopping;
+};
\ No newline at end of file
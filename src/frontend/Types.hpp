@@ -3,7 +3,10 @@
 #include "emulator/core/GBA.hpp"
 
 
+class GLFWInputDevice;
+
 struct CallbackUserData {
     void *frontend;
     std::shared_ptr<emu::GBA> core;
+    GLFWInputDevice *input_device;
 };
\ No newline at end of file
@@ -48,16 +48,11 @@ auto GLFWInputDevice::update(const Settings &settings) -> bool {
     }
 
     u16 keys = 0;
-    u16 keys_old = keyinput.load();
     for(size_t i = 0; i < 10; i++) {
         keys |= !pressed[i] << i;
     }
     keyinput.store(keys);
 
-    if(keys_old ^ keys) {
-        callback();
-    }
-
     return false;
 }
 
@@ -97,7 +92,7 @@ void GLFWInputDevice::keyCallback(GLFWwindow *window, int key, int scancode, int
     CallbackUserData *user_data = reinterpret_cast<CallbackUserData*>(glfwGetWindowUserPointer(window));
 
     if(user_data != nullptr && action != GLFW_REPEAT) {
-        GLFWInputDevice &device = dynamic_cast<GLFWInputDevice&>(user_data->core->input_device);
+        GLFWInputDevice &device = *user_data->input_device;
         const int *key_map = reinterpret_cast<Frontend*>(user_data->frontend)->getSettings().key_map;
 
         if(device.joystick_connected || !device.active) {
@@ -111,14 +106,9 @@ void GLFWInputDevice::keyCallback(GLFWwindow *window, int key, int scancode, int
         }
 
         u16 keys = 0;
-        u16 keys_old = device.keyinput.load();
         for(size_t i = 0; i < 10; i++) {
             keys |= !device.pressed[i] << i;
         }
         device.keyinput.store(keys);
-        
-        if(keys_old ^ keys) {
-            device.callback();
-        }
     }
 }
\ No newline at end of file
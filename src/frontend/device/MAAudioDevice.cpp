@@ -1,12 +1,20 @@
 #include "MAAudioDevice.hpp"
 #include "common/Log.hpp"
-#include <vector>
+#include <algorithm>
+
+
+//How far rate control is allowed to stray from the nominal ratio
+constexpr double MAX_RATE_ADJUST = 0.005;
 
 
 MAAudioDevice::MAAudioDevice(std::function<void (bool, float*, size_t)> &&callback) : callback(callback) {
     LOG_DEBUG("Initializing MAAudioDevice...");
 
-    samples.store(512);
+    resolution.store(0);
+    current_resolution = -1;
+    last_frame[0] = 0;
+    last_frame[1] = 0;
+
     ma_device_config config = ma_device_config_init(ma_device_type_playback);
     config.playback.format = ma_format_f32;
     config.playback.channels = 2;
@@ -36,55 +44,82 @@ void MAAudioDevice::stop() {
     }
 }
 
+//Only called while the device and emulator are both stopped
 void MAAudioDevice::clear() {
-    samples_l.clear();
-    samples_r.clear();
+    sample_buffer.clear();
+    resampler.reset();
+    last_frame[0] = 0;
+    last_frame[1] = 0;
 }
 
 void MAAudioDevice::pushSample(float left, float right) {
-    samples_l.push(left);
-    samples_r.push(right);
+    const float pair[2] = {left, right};
+    sample_buffer.push_many(pair, 2);
+}
+
+void MAAudioDevice::pushSamples(const float *samples, size_t count) {
+    //Samples are dropped if the device can't keep up
+    sample_buffer.push_many(samples, count * 2);
 }
 
+//Enough samples for the two callbacks rate control aims to keep buffered
 auto MAAudioDevice::full() -> bool {
-    return samples_l.size() == samples_l.capacity();
+    const size_t target = (32768 << resolution.load()) / 64 * 2;
+    return sample_buffer.size() / 2 >= target;
 }
 
 void MAAudioDevice::setSampleRate(int resolution) {
-    samples.store(512 << resolution);
-    sample_counter.store(0);
+    this->resolution.store(resolution);
 }
 
-void MAAudioDevice::resample(float *dst, size_t channel_size) {
-    size_t frame_size = samples.load();
-    std::vector<float> frame(frame_size * 2);
+void MAAudioDevice::audioCallback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
+    MAAudioDevice *audio_device = reinterpret_cast<MAAudioDevice*>(device->pUserData);
+    audio_device->fillOutput(reinterpret_cast<float*>(output), frame_count);
+}
 
-    samples_l.pop_many(frame.data(), frame_size);
-    samples_r.pop_many(frame.data() + frame_size, frame_size);
+void MAAudioDevice::fillOutput(float *output, size_t frame_count) {
+    const int new_resolution = resolution.load();
+    if(new_resolution != current_resolution) {
+        current_resolution = new_resolution;
+        resampler.setRates(32768 << current_resolution, device.sampleRate);
+    }
 
-    for(size_t i = 0; i < channel_size; i++) {
-        size_t index = (size_t)((i / (float)channel_size) * frame_size);
-        dst[i] = frame[index];
-        dst[i + channel_size] = frame[index + frame_size];
+    //Rate control: keep about two callbacks worth of samples buffered by
+    //consuming slightly faster or slower than the nominal ratio, which is
+    //small enough to not be audible, instead of letting the buffer drift
+    const double input_per_callback = (32768 << current_resolution) * frame_count / static_cast<double>(device.sampleRate);
+    const double target = input_per_callback * 2;
+    const double fill = sample_buffer.size() / 2;
+    const double error = std::clamp((fill - target) / target, -1.0, 1.0);
+    resampler.setRatioAdjust(1.0 + MAX_RATE_ADJUST * error);
+
+    //Not enough samples yet, hold the last output to avoid a pop and wait for the buffer to fill
+    if(resampler.inputNeeded(frame_count) > sample_buffer.size() / 2) {
+        for(size_t i = 0; i < frame_count; i++) {
+            output[i * 2 + 0] = last_frame[0];
+            output[i * 2 + 1] = last_frame[1];
+        }
+
+        callback(false, nullptr, sample_buffer.size() / 2);
+        return;
     }
-}
 
-void MAAudioDevice::audioCallback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
-    MAAudioDevice *audio_device = reinterpret_cast<MAAudioDevice*>(device->pUserData);
+    for(size_t done = 0; done < frame_count; done += CHUNK_FRAMES) {
+        const size_t chunk = std::min(CHUNK_FRAMES, frame_count - done);
+        const size_t needed = resampler.inputNeeded(chunk);
 
-    if(audio_device->samples_l.size() < 1024) {
-        audio_device->callback(false, nullptr, audio_device->samples_l.size());
-        // LOG_ERROR("Not enough samples for audio callback");
-        return;
+        sample_buffer.pop_many(input_frames, needed * 2);
+        resampler.process(input_frames, &output[done * 2], chunk);
     }
 
-    float samples[1500];
-    audio_device->resample(samples, 750);
-    audio_device->callback(true, samples, audio_device->samples_l.size());
+    last_frame[0] = output[(frame_count - 1) * 2 + 0];
+    last_frame[1] = output[(frame_count - 1) * 2 + 1];
 
-    float *f_output = reinterpret_cast<float*>(output);
-    for(size_t i = 0; i < frame_count; i++) {
-        f_output[i * 2 + 0] = samples[i];
-        f_output[i * 2 + 1] = samples[i + frame_count];
+    for(size_t i = 0; i < CHUNK_FRAMES; i++) {
+        const size_t index = std::min(i, frame_count - 1);
+        plot_samples[i] = output[index * 2 + 0];
+        plot_samples[i + CHUNK_FRAMES] = output[index * 2 + 1];
     }
+
+    callback(true, plot_samples, sample_buffer.size() / 2);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "emulator/device/AudioDevice.hpp"
 #include "common/Buffer.hpp"
+#include "common/Resampler.hpp"
 #define MA_NO_ENCODING
 #define MA_NO_DECODING
 #include <miniaudio.h>
@@ -20,18 +21,26 @@ public:
 
     void clear();
     void pushSample(float left, float right) override;
+    void pushSamples(const float *samples, size_t count) override;
     auto full() -> bool override;
     void setSampleRate(int resolution) override;
-    void resample(float *dst, size_t size);
 
 private:
 
     static void audioCallback(ma_device *device, void *output, const void *input, ma_uint32 frame_count);
+    void fillOutput(float *output, size_t frame_count);
     
     ma_device device;
     std::function<void (bool, float*, size_t)> callback;
-    common::ThreadSafeRingBuffer<float, 8192> samples_l;
-    common::ThreadSafeRingBuffer<float, 8192> samples_r;
-    std::atomic<int> samples;
-    std::atomic<int> sample_counter;
+    common::SPSCRingBuffer<float, 32768> sample_buffer; //Interleaved left/right
+    std::atomic<int> resolution;
+
+    //Only touched from the audio callback
+    static constexpr size_t CHUNK_FRAMES = 750;
+    static constexpr size_t MAX_INPUT_FRAMES = 8192;
+    common::Resampler resampler;
+    int current_resolution;
+    float input_frames[MAX_INPUT_FRAMES * 2];
+    float last_frame[2];
+    float plot_samples[CHUNK_FRAMES * 2]; //Left then right, for the frontend's audio plot
 };
\ No newline at end of file
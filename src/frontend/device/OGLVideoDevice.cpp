@@ -1,65 +1,81 @@
 #include "OGLVideoDevice.hpp"
 #include "common/Log.hpp"
+#include <algorithm>
+#include <cstring>
 
 
 OGLVideoDevice::OGLVideoDevice() {
     LOG_DEBUG("Initializing OGLVideoDevice...");
 
-    new_frame = false;
     createTexture();
+    createFramebuffers();
     clear(0);
-    updateTexture(present_framebuffer);
 }
 
 OGLVideoDevice::~OGLVideoDevice() {
-    delete[] internal_framebuffer;
-    delete[] present_framebuffer;
+    if(persistent) {
+        for(u8 i = 0; i < 3; i++) {
+            waitForUpload(i);
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &pixel_buffer);
+    } else {
+        for(auto framebuffer : framebuffers) {
+            delete[] framebuffer;
+        }
+    }
 
     if(texture_id != 0) {
         glDeleteTextures(1, &texture_id);
     }
 }
 
+//Clears every buffer and drops any frame still waiting to be shown, so it has
+//to be called from the UI thread while the emulator isn't drawing
 void OGLVideoDevice::clear(u32 color) {
-    std::lock_guard lock(update_mutex);
-
-    for(size_t i = 0; i < (240 * 160); i++) {
-        internal_framebuffer[i] = color;
-        present_framebuffer[i] = color;
+    for(u8 i = 0; i < 3; i++) {
+        waitForUpload(i);
+        std::fill(framebuffers[i], framebuffers[i] + 240 * 160, color);
     }
 
-    new_frame = true;
+    back_index = 0;
+    ready_index.store(1, std::memory_order_release);
+    front_index = 2;
+
+    updateTexture(front_index);
 }
 
 void OGLVideoDevice::setPixel(int x, int y, u32 color) {
-    std::lock_guard lock(update_mutex);
-
-    internal_framebuffer[x + y * 240] = color;
+    framebuffers[back_index][x + y * 240] = color;
 }
 
 void OGLVideoDevice::setLine(int y, const u32 *colors) {
-    std::lock_guard lock(update_mutex);
-    
-    std::memcpy(&internal_framebuffer[y * 240], colors, 240 * sizeof(u32));
+    std::memcpy(&framebuffers[back_index][y * 240], colors, 240 * sizeof(u32));
 }
 
 void OGLVideoDevice::presentFrame() {
-    std::lock_guard lock(update_mutex);
-    std::memcpy(present_framebuffer, internal_framebuffer, 240 * 160 * sizeof(u32));
-    new_frame = true;
+    back_index = ready_index.exchange(back_index | NEW_FRAME, std::memory_order_acq_rel) & ~NEW_FRAME;
 }
 
 auto OGLVideoDevice::getTextureID() -> GLuint {
-    std::lock_guard lock(update_mutex);
-    
-    if(new_frame) {
-        updateTexture(present_framebuffer);
-        new_frame = false;
+    if(ready_index.load(std::memory_order_acquire) & NEW_FRAME) {
+        //The emulator may start drawing into this buffer as soon as it's handed back
+        waitForUpload(front_index);
+        front_index = ready_index.exchange(front_index, std::memory_order_acq_rel) & ~NEW_FRAME;
+        updateTexture(front_index);
     }
 
     return texture_id;
 }
 
+//The frame that's on screen, only the UI thread can use it
+auto OGLVideoDevice::getPresentedFrame() const -> const u32* {
+    return framebuffers[front_index];
+}
+
 void OGLVideoDevice::createTexture() {
     glGenTextures(1, &texture_id);
     glBindTexture(GL_TEXTURE_2D, texture_id);
@@ -68,6 +84,13 @@ void OGLVideoDevice::createTexture() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    //Allocate storage once, every frame after that only updates the contents
+    if(GLAD_GL_VERSION_4_2) {
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, 240, 160);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 240, 160, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, nullptr);
+    }
+
     #ifndef NDEBUG
     glObjectLabel(GL_TEXTURE, texture_id, -1, "OGLVideoDevice Frame Texture");
     #endif
@@ -75,8 +98,73 @@ void OGLVideoDevice::createTexture() {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void OGLVideoDevice::updateTexture(u32 *pixels) {
+void OGLVideoDevice::createFramebuffers() {
+    persistent = GLAD_GL_VERSION_4_4;
+    pixel_buffer = 0;
+
+    for(auto &fence : upload_fences) {
+        fence = nullptr;
+    }
+
+    if(persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &pixel_buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, FRAME_SIZE * 3, nullptr, flags);
+        u8 *mapping = static_cast<u8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, FRAME_SIZE * 3, flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if(mapping != nullptr) {
+            #ifndef NDEBUG
+            glObjectLabel(GL_BUFFER, pixel_buffer, -1, "OGLVideoDevice Pixel Buffer");
+            #endif
+
+            for(size_t i = 0; i < 3; i++) {
+                framebuffers[i] = reinterpret_cast<u32*>(mapping + FRAME_SIZE * i);
+            }
+        } else {
+            LOG_WARNING("Failed to map pixel buffer, falling back to client memory uploads");
+            glDeleteBuffers(1, &pixel_buffer);
+            persistent = false;
+        }
+    }
+
+    if(!persistent) {
+        for(auto &framebuffer : framebuffers) {
+            framebuffer = new u32[240 * 160];
+        }
+    }
+
+    for(auto framebuffer : framebuffers) {
+        std::fill(framebuffer, framebuffer + 240 * 160, 0);
+    }
+}
+
+void OGLVideoDevice::updateTexture(u8 index) {
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 240, 160, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, pixels);
+
+    if(persistent) {
+        //Source is an offset into the bound pixel buffer
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 240, 160, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, reinterpret_cast<const void*>(FRAME_SIZE * index));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 240, 160, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, framebuffers[index]);
+    }
+
     glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//Blocks until the GPU is done reading a framebuffer, which has usually
+//happened long before since it's only handed back a frame later
+void OGLVideoDevice::waitForUpload(u8 index) {
+    if(upload_fences[index] == nullptr) {
+        return;
+    }
+
+    while(glClientWaitSync(upload_fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) { }
+    glDeleteSync(upload_fences[index]);
+    upload_fences[index] = nullptr;
 }
\ No newline at end of file
@@ -3,8 +3,7 @@
 #include "emulator/device/VideoDevice.hpp"
 #include "common/Buffer.hpp"
 #include <glad/gl.h>
-#include <mutex>
-#include <deque>
+#include <atomic>
 
 
 class OGLVideoDevice final : public emu::VideoDevice {
@@ -18,15 +17,29 @@ public:
     void setLine(int y, const u32 *colors) override;
     void presentFrame() override;
     auto getTextureID() -> GLuint;
+    auto getPresentedFrame() const -> const u32*;
 
 private:
 
     void createTexture();
-    void updateTexture(u32 *pixels);
+    void createFramebuffers();
+    void updateTexture(u8 index);
+    void waitForUpload(u8 index);
+
+    //Triple buffered so neither thread ever has to wait on the other. The
+    //emulator draws into the back buffer, and at V-Blank swaps it with the
+    //ready buffer, which the UI thread then swaps with the one it's showing.
+    static constexpr u8 NEW_FRAME = 0x80;
+    static constexpr size_t FRAME_SIZE = 240 * 160 * sizeof(u32);
+    u32 *framebuffers[3];
+    u8 back_index, front_index;
+    std::atomic<u8> ready_index;
+
+    //When persistent mapping is supported the framebuffers live in a mapped
+    //pixel buffer, so frames are uploaded without an extra copy or stall.
+    bool persistent;
+    GLuint pixel_buffer;
+    GLsync upload_fences[3];
 
-    u32 *internal_framebuffer = new u32[240 * 160];
-    u32 *present_framebuffer = new u32[240 * 160];
     GLuint texture_id;
-    std::mutex update_mutex;
-    bool new_frame;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <misc/cpp/imgui_stdlib.h>
+#include <algorithm>
 
 
 namespace ui {
@@ -59,6 +60,7 @@ void FileDialog::draw(Frontend &frontend) {
             case ROM_LOAD : ImGui::OpenPopup("Load ROM"); break;
             case STATE_LOAD : ImGui::OpenPopup("Load State"); break;
             case STATE_SAVE : ImGui::OpenPopup("Save State"); break;
+            case MOVIE_RECORD : ImGui::OpenPopup("Record Movie"); break;
         }
         open_popup = false;
         path_buf[0] = '\0';
@@ -100,6 +102,17 @@ void FileDialog::draw(Frontend &frontend) {
         }
     }
     ImGui::EndPopup();
+
+    ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+    if(ImGui::BeginPopupModal("Record Movie", &active, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove)) {
+        bool entered = ImGui::InputText("Path", path_buf, 100, ImGuiInputTextFlags_EnterReturnsTrue);
+
+        if(ImGui::Button("Record") || entered) {
+            frontend.startRecording(path_buf);
+            ImGui::CloseCurrentPopup();
+        }
+    }
+    ImGui::EndPopup();
 }
 
 void MetricsWindow::draw(Frontend &frontend) {
@@ -272,6 +285,45 @@ void SettingsWindow::drawGeneral(Settings &settings) {
 
     ImGui::Checkbox(" Skip BIOS Intro", &settings.skip_bios);
 
+    ImGui::Dummy(ImVec2(0.0f, ImGui::GetTextLineHeight()));
+    ImGui::Text("Video");
+    ImGui::Separator();
+
+    ImGui::Checkbox(" Render on Separate Thread", &settings.threaded_renderer);
+    ImGui::Text("Frame Pacing:");
+    ImGui::SameLine();
+    ImGui::Combo("##FramePacing", &settings.pacing_mode, "Video Sync\0Audio Sync\0Free Run\0");
+    ImGui::Text("Run-Ahead Frames:");
+    ImGui::SameLine();
+    ImGui::InputInt("##RunAhead", &settings.run_ahead);
+    settings.run_ahead = std::clamp(settings.run_ahead, 0, 4);
+
+    ImGui::Dummy(ImVec2(0.0f, ImGui::GetTextLineHeight()));
+    ImGui::Text("Rewind");
+    ImGui::Separator();
+
+    ImGui::Checkbox(" Enable Rewind", &settings.rewind_enabled);
+    ImGui::Text("Frames Between Snapshots:");
+    ImGui::SameLine();
+    ImGui::InputInt("##RewindInterval", &settings.rewind_interval);
+    settings.rewind_interval = std::clamp(settings.rewind_interval, 1, 60);
+    ImGui::Text("Buffer Size (MiB):");
+    ImGui::SameLine();
+    ImGui::InputInt("##RewindBufferSize", &settings.rewind_buffer_size);
+    settings.rewind_buffer_size = std::clamp(settings.rewind_buffer_size, 1, 1024);
+
+    ImGui::Dummy(ImVec2(0.0f, ImGui::GetTextLineHeight()));
+    ImGui::Text("Save States");
+    ImGui::Separator();
+
+    ImGui::Checkbox(" Autosave", &settings.autosave_enabled);
+    ImGui::Text("Seconds Between Autosaves:");
+    ImGui::SameLine();
+    ImGui::InputInt("##AutosaveInterval", &settings.autosave_interval);
+    settings.autosave_interval = std::clamp(settings.autosave_interval, 5, 600);
+    ImGui::Checkbox(" Save Screenshot Thumbnails", &settings.state_thumbnails);
+    ImGui::Checkbox(" Compress Save States", &settings.compress_states);
+
     ImGui::Dummy(ImVec2(0.0f, ImGui::GetTextLineHeight()));
     ImGui::Text("Debug");
     ImGui::Separator();
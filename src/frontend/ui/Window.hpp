@@ -24,7 +24,7 @@ private:
 };
 
 enum FileDialogType {
-    ROM_LOAD, STATE_LOAD, STATE_SAVE
+    ROM_LOAD, STATE_LOAD, STATE_SAVE, MOVIE_RECORD
 };
 
 struct FileDialog final : public Window {
@@ -0,0 +1,208 @@
+#include "BatchRunner.hpp"
+#include "common/File.hpp"
+#include "common/Log.hpp"
+#include <chrono>
+#include <thread>
+
+
+namespace headless {
+
+BatchRunner::BatchRunner(size_t threads, u64 slice_frames) : threads(threads == 0 ? 1 : threads), slice_frames(slice_frames == 0 ? 1 : slice_frames) {
+    for(size_t i = 0; i < this->threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    queued = 0;
+    remaining = 0;
+    idle = 0;
+    frames_run = 0;
+    steals = 0;
+    failed = 0;
+    seconds = 0;
+}
+
+//Sessions reference their devices, so they go before anything else
+BatchRunner::~BatchRunner() {
+    sessions.clear();
+}
+
+auto BatchRunner::add(const SessionOptions &options) -> bool {
+    std::shared_ptr<const std::vector<u8>> bios = loadImage(options.bios_path);
+    if(!bios || bios->size() != 16_KiB) {
+        LOG_ERROR("Unable to open BIOS file '{}'!", options.bios_path);
+        return false;
+    }
+
+    std::shared_ptr<const std::vector<u8>> rom = loadImage(options.rom_path);
+    if(!rom) {
+        LOG_ERROR("Failed to load file '{}'!", options.rom_path);
+        return false;
+    }
+
+    auto session = std::make_unique<Session>(options);
+    if(!session->load(bios, rom)) {
+        return false;
+    }
+
+    //Spread sessions evenly between workers to start with
+    size_t index = sessions.size();
+    workers[index % threads]->queue.push_back(index);
+    sessions.push_back(std::move(session));
+    queued++;
+    remaining++;
+
+    return true;
+}
+
+auto BatchRunner::run(const std::function<void(const BatchStats&)> &progress) -> BatchStats {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+
+    for(size_t i = 0; i < threads; i++) {
+        pool.emplace_back(&BatchRunner::work, this, i);
+    }
+
+    //Report progress every second until all of the sessions are done
+    while(true) {
+        {
+            std::unique_lock lock(idle_mutex);
+
+            if(idle_cv.wait_for(lock, std::chrono::seconds(1), [this]() { return remaining == 0; })) {
+                break;
+            }
+        }
+
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if(progress) {
+            progress(getStats());
+        }
+    }
+
+    for(auto &thread : pool) {
+        thread.join();
+    }
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return getStats();
+}
+
+auto BatchRunner::loadImage(const std::string &path) -> std::shared_ptr<const std::vector<u8>> {
+    auto iter = images.find(path);
+
+    if(iter != images.end()) {
+        return iter->second;
+    }
+
+    std::vector<u8> data = common::loadFileBytes(path.c_str());
+    if(data.empty()) {
+        return nullptr;
+    }
+
+    auto image = std::make_shared<const std::vector<u8>>(std::move(data));
+    images[path] = image;
+
+    return image;
+}
+
+void BatchRunner::push(Worker &worker, size_t index) {
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.queue.push_back(index);
+    }
+
+    queued++;
+
+    if(idle > 0) {
+        std::lock_guard lock(idle_mutex);
+        idle_cv.notify_one();
+    }
+}
+
+//The owner takes from the front and thieves take from the back
+auto BatchRunner::pop(Worker &worker, size_t &index) -> bool {
+    std::lock_guard lock(worker.mutex);
+
+    if(worker.queue.empty()) {
+        return false;
+    }
+
+    index = worker.queue.front();
+    worker.queue.pop_front();
+    queued--;
+
+    return true;
+}
+
+auto BatchRunner::steal(size_t thief, size_t &index) -> bool {
+    for(size_t i = 1; i < threads; i++) {
+        Worker &victim = *workers[(thief + i) % threads];
+        std::lock_guard lock(victim.mutex);
+
+        if(!victim.queue.empty()) {
+            index = victim.queue.back();
+            victim.queue.pop_back();
+            queued--;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BatchRunner::work(size_t id) {
+    Worker &worker = *workers[id];
+    size_t index;
+
+    while(true) {
+        if(!pop(worker, index)) {
+            if(steal(id, index)) {
+                steals++;
+            } else {
+                //Nothing to run until another worker puts a session back
+                std::unique_lock lock(idle_mutex);
+                idle++;
+                idle_cv.wait(lock, [this]() { return queued > 0 || remaining == 0; });
+                idle--;
+
+                if(remaining == 0) {
+                    return;
+                }
+
+                continue;
+            }
+        }
+
+        Session &session = *sessions[index];
+        frames_run += session.runFrames(slice_frames);
+
+        if(!session.finished()) {
+            push(worker, index);
+            continue;
+        }
+
+        if(!session.finish()) {
+            failed++;
+        }
+
+        if(--remaining == 0) {
+            std::lock_guard lock(idle_mutex);
+            idle_cv.notify_all();
+        }
+    }
+}
+
+auto BatchRunner::getStats() const -> BatchStats {
+    BatchStats stats;
+    stats.instances = sessions.size();
+    stats.failed = failed;
+    stats.frames = frames_run;
+    stats.steals = steals;
+    stats.seconds = seconds;
+
+    return stats;
+}
+
+} //namespace headless
\ No newline at end of file
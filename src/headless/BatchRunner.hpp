@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Session.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace headless {
+
+struct BatchStats {
+    u64 instances;
+    u64 failed;
+    u64 frames;
+    u64 steals;
+    double seconds;
+};
+
+/*
+ * Runs many independent sessions on a pool of threads. Every worker has its own
+ * queue of sessions and runs them a slice of frames at a time, putting unfinished
+ * ones back on its queue. A worker that runs out steals from the other end of
+ * another worker's queue, so the load stays even when sessions finish at
+ * different times. ROM and BIOS images are loaded once and shared between all
+ * of the sessions that use them.
+ */
+class BatchRunner final {
+public:
+
+    explicit BatchRunner(size_t threads, u64 slice_frames = 60);
+    ~BatchRunner();
+
+    auto add(const SessionOptions &options) -> bool;
+    auto run(const std::function<void(const BatchStats&)> &progress = nullptr) -> BatchStats;
+
+private:
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<size_t> queue;
+    };
+
+    auto loadImage(const std::string &path) -> std::shared_ptr<const std::vector<u8>>;
+    void push(Worker &worker, size_t index);
+    auto pop(Worker &worker, size_t &index) -> bool;
+    auto steal(size_t thief, size_t &index) -> bool;
+    void work(size_t id);
+    auto getStats() const -> BatchStats;
+
+    size_t threads;
+    u64 slice_frames;
+    std::unordered_map<std::string, std::shared_ptr<const std::vector<u8>>> images;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<size_t> queued;
+    std::atomic<size_t> remaining;
+    std::atomic<size_t> idle;
+    std::atomic<u64> frames_run;
+    std::atomic<u64> steals;
+    std::atomic<u64> failed;
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    double seconds;
+};
+
+} //namespace headless
\ No newline at end of file
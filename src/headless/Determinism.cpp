@@ -0,0 +1,120 @@
+#include "Determinism.hpp"
+#include "common/Log.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+
+namespace headless {
+
+//Runs up to count more frames, keeping the hashes from every V-Blank along the way
+auto recordHashes(Session &session, u64 count) -> std::vector<FrameHashes> {
+    std::vector<FrameHashes> hashes;
+    emu::DebugInterface &debug = session.getCore().debug;
+
+    debug.setFrameHashCallback([&hashes](u64 frame, const emu::StateHashes &state) {
+        hashes.push_back(FrameHashes{frame, state});
+    });
+    session.runFrames(count);
+    debug.setFrameHashCallback(nullptr);
+
+    return hashes;
+}
+
+//One line per frame, with the frame number and then each part's hash in hex
+auto saveHashes(const std::string &path, const std::vector<FrameHashes> &hashes) -> bool {
+    std::ofstream file(path);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for saving hashes!", path);
+        return false;
+    }
+
+    file << "#frame";
+    for(const char *name : emu::StateHashes::NAMES) {
+        file << ' ' << name;
+    }
+    file << '\n';
+
+    for(const auto &entry : hashes) {
+        file << fmt::format("{}", entry.frame);
+
+        for(u64 value : entry.hashes.values) {
+            file << fmt::format(" {:016x}", value);
+        }
+
+        file << '\n';
+    }
+
+    return file.good();
+}
+
+auto loadHashes(const std::string &path, std::vector<FrameHashes> &hashes) -> bool {
+    std::ifstream file(path);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open hashes '{}'!", path);
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    hashes.clear();
+
+    while(std::getline(file, line)) {
+        line_number++;
+
+        if(line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        FrameHashes entry{};
+        fields >> entry.frame >> std::hex;
+
+        for(u64 &value : entry.hashes.values) {
+            fields >> value;
+        }
+
+        if(fields.fail()) {
+            LOG_ERROR("Invalid hashes on line {} of '{}'!", line_number, path);
+            return false;
+        }
+
+        hashes.push_back(entry);
+    }
+
+    return true;
+}
+
+//Returns false if every frame matches. A run that stopped early diverges at the first frame it's missing
+auto findDivergence(const std::vector<FrameHashes> &a, const std::vector<FrameHashes> &b, Divergence &divergence) -> bool {
+    const size_t count = std::min(a.size(), b.size());
+
+    for(size_t i = 0; i < count; i++) {
+        divergence.frame = a[i].frame;
+        divergence.components.clear();
+
+        if(a[i].frame != b[i].frame) {
+            divergence.components.push_back("frame");
+        }
+
+        for(size_t j = 0; j < emu::StateHashes::COMPONENT_COUNT; j++) {
+            if(a[i].hashes.values[j] != b[i].hashes.values[j]) {
+                divergence.components.push_back(emu::StateHashes::NAMES[j]);
+            }
+        }
+
+        if(!divergence.components.empty()) {
+            return true;
+        }
+    }
+
+    if(a.size() != b.size()) {
+        divergence.frame = a.size() > count ? a[count].frame : b[count].frame;
+        divergence.components = {"frame count"};
+        return true;
+    }
+
+    return false;
+}
+
+} //namespace headless
\ No newline at end of file
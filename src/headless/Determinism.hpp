@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Session.hpp"
+#include "emulator/core/StateHash.hpp"
+#include <string>
+#include <vector>
+
+
+namespace headless {
+
+struct FrameHashes {
+    u64 frame;
+    emu::StateHashes hashes;
+};
+
+struct Divergence {
+    u64 frame; //First frame where the runs differ
+    std::vector<std::string> components; //Names of the parts that differ on that frame
+};
+
+/*
+ * For checking that a change doesn't affect emulation. The state is hashed at
+ * every V-Blank of a run, and two runs of the same movie, in the same build or
+ * in two different ones, should give the same hashes frame for frame. The
+ * first frame that doesn't match, and which parts of the state went wrong on
+ * it, show where to start looking.
+ */
+auto recordHashes(Session &session, u64 count) -> std::vector<FrameHashes>;
+auto saveHashes(const std::string &path, const std::vector<FrameHashes> &hashes) -> bool;
+auto loadHashes(const std::string &path, std::vector<FrameHashes> &hashes) -> bool;
+auto findDivergence(const std::vector<FrameHashes> &a, const std::vector<FrameHashes> &b, Divergence &divergence) -> bool;
+
+} //namespace headless
\ No newline at end of file
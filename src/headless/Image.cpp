@@ -0,0 +1,86 @@
+#include "Image.hpp"
+#include "common/StringUtils.hpp"
+#include "common/Log.hpp"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+
+namespace headless {
+
+auto writeBMP(const std::string &path, const u32 *pixels, int width, int height) -> bool {
+    std::ofstream file(path, std::ios_base::binary);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for writing image!", path);
+        return false;
+    }
+
+    //Rows are padded to a multiple of 4 bytes
+    const u32 row_size = (width * 3 + 3) & ~3;
+    const u32 data_size = row_size * height;
+    const u32 file_size = 54 + data_size;
+    const u32 data_offset = 54;
+    const u32 info_size = 40;
+    const s32 bmp_width = width;
+    const s32 bmp_height = -height; //Negative for top to bottom rows
+    const u16 planes = 1;
+    const u16 bits_per_pixel = 24;
+    const u32 zero = 0;
+
+    file.write("BM", 2);
+    file.write(reinterpret_cast<const char*>(&file_size), sizeof(file_size));
+    file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    file.write(reinterpret_cast<const char*>(&data_offset), sizeof(data_offset));
+    file.write(reinterpret_cast<const char*>(&info_size), sizeof(info_size));
+    file.write(reinterpret_cast<const char*>(&bmp_width), sizeof(bmp_width));
+    file.write(reinterpret_cast<const char*>(&bmp_height), sizeof(bmp_height));
+    file.write(reinterpret_cast<const char*>(&planes), sizeof(planes));
+    file.write(reinterpret_cast<const char*>(&bits_per_pixel), sizeof(bits_per_pixel));
+    for(int i = 0; i < 6; i++) {
+        file.write(reinterpret_cast<const char*>(&zero), sizeof(zero)); //No compression, default resolution and palette
+    }
+
+    std::vector<u8> row(row_size, 0);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            const u32 color = pixels[x + y * width];
+            row[x * 3 + 0] = (color >> 8) & 0xFF;
+            row[x * 3 + 1] = (color >> 16) & 0xFF;
+            row[x * 3 + 2] = (color >> 24) & 0xFF;
+        }
+
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+
+    return file.good();
+}
+
+auto writePPM(const std::string &path, const u32 *pixels, int width, int height) -> bool {
+    std::ofstream file(path, std::ios_base::binary);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for writing image!", path);
+        return false;
+    }
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<u8> data(width * height * 3);
+    for(int i = 0; i < width * height; i++) {
+        data[i * 3 + 0] = (pixels[i] >> 24) & 0xFF;
+        data[i * 3 + 1] = (pixels[i] >> 16) & 0xFF;
+        data[i * 3 + 2] = (pixels[i] >> 8) & 0xFF;
+    }
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return file.good();
+}
+
+auto writeImage(const std::string &path, const u32 *pixels, int width, int height) -> bool {
+    if(common::to_lower(std::filesystem::path(path).extension().string()) == ".ppm") {
+        return writePPM(path, pixels, width, height);
+    }
+
+    return writeBMP(path, pixels, width, height);
+}
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "common/Types.hpp"
+#include <string>
+
+
+namespace headless {
+
+//Pixels are RGBA8888 as drawn by the PPU, alpha is ignored
+auto writeBMP(const std::string &path, const u32 *pixels, int width, int height) -> bool;
+auto writePPM(const std::string &path, const u32 *pixels, int width, int height) -> bool;
+
+//Picks the format from the file extension, defaulting to BMP
+auto writeImage(const std::string &path, const u32 *pixels, int width, int height) -> bool;
+
+} //namespace headless
\ No newline at end of file
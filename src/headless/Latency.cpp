@@ -0,0 +1,83 @@
+#include "Latency.hpp"
+#include "emulator/core/RunAhead.hpp"
+#include <algorithm>
+#include <chrono>
+
+
+namespace headless {
+
+static auto hashFrame(const u32 *pixels) -> u64 {
+    u64 hash = 0xCBF29CE484222325;
+
+    for(size_t i = 0; i < 240 * 160; i++) {
+        hash ^= pixels[i];
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+}
+
+static void runFrame(emu::GBA &core, emu::RunAhead &run_ahead) {
+    core.runFrame();
+    run_ahead.run();
+}
+
+//Returns the time taken per frame, with the hash of every frame shown after the buttons are pressed
+static auto runTrial(Session &session, emu::RunAhead &run_ahead, const std::vector<u8> &state, u16 buttons, u32 window, std::vector<u64> &hashes) -> double {
+    emu::GBA &core = session.getCore();
+
+    core.loadState(state.data(), state.size());
+    session.getInputDevice().setHeld(0);
+    hashes.clear();
+
+    //Whether a frame gets drawn is decided a frame early, so let one go by first
+    runFrame(core, run_ahead);
+    session.getInputDevice().setHeld(buttons);
+
+    auto start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < window; i++) {
+        runFrame(core, run_ahead);
+        hashes.push_back(hashFrame(session.getVideoDevice().getFrame()));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    session.getInputDevice().setHeld(0);
+    return std::chrono::duration<double>(end - start).count() / window;
+}
+
+auto measureLatency(Session &session, u16 buttons, u32 max_run_ahead, u32 window) -> std::vector<LatencyResult> {
+    emu::GBA &core = session.getCore();
+    emu::RunAhead run_ahead(core);
+    std::vector<LatencyResult> results;
+    std::vector<u8> state;
+    std::vector<u64> released, pressed;
+
+    //Every frame has to be drawn to see when the buttons make a difference,
+    //whatever the session was drawing before
+    core.ppu.setRenderPolicy(emu::RENDER_ALL);
+    core.saveState(state);
+
+    for(u32 frames = 0; frames <= std::min(max_run_ahead, emu::RunAhead::MAX_FRAMES); frames++) {
+        run_ahead.setFrames(frames);
+
+        double time = runTrial(session, run_ahead, state, 0, window, released);
+        time += runTrial(session, run_ahead, state, buttons, window, pressed);
+
+        LatencyResult result{frames, -1, time / 2};
+        for(u32 i = 0; i < window; i++) {
+            if(released[i] != pressed[i]) {
+                result.frames = i + 1;
+                break;
+            }
+        }
+
+        results.push_back(result);
+    }
+
+    run_ahead.setFrames(0);
+    core.loadState(state.data(), state.size());
+
+    return results;
+}
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Session.hpp"
+#include <vector>
+
+
+namespace headless {
+
+struct LatencyResult {
+    u32 run_ahead;
+    s64 frames; //Until a press shows up on screen, -1 if it never did
+    double frame_time; //Seconds per frame, including the frames run ahead
+};
+
+/*
+ * Measures how many frames it takes for pressing buttons to change what's on
+ * screen, for each amount of run-ahead up to max_run_ahead. Both the pressed
+ * and unpressed runs start from the session's current state, which is put
+ * back afterwards.
+ */
+auto measureLatency(Session &session, u16 buttons, u32 max_run_ahead, u32 window = 60) -> std::vector<LatencyResult>;
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "Session.hpp"
+#include "Image.hpp"
+#include "device/NullDevices.hpp"
+#include "device/WavAudioDevice.hpp"
+#include "common/File.hpp"
+#include "common/Log.hpp"
+#include <fstream>
+
+
+namespace headless {
+
+Session::Session(const SessionOptions &options) : options(options) {
+    if(options.audio_path.empty()) {
+        audio_device = std::make_unique<NullAudioDevice>();
+    } else {
+        audio_device = std::make_unique<WavAudioDevice>(options.audio_path);
+    }
+
+    core = std::make_unique<emu::GBA>(video_device, input_device, *audio_device);
+    frame = 0;
+    cycle_diff = 0;
+}
+
+//The core has to go before the devices it refers to
+Session::~Session() {
+    core.reset();
+}
+
+auto Session::load() -> bool {
+    std::vector<u8> bios = common::loadFileBytes(options.bios_path.c_str());
+    if(bios.empty()) {
+        LOG_ERROR("Unable to open BIOS file '{}'!", options.bios_path);
+        return false;
+    }
+
+    core->loadBIOS(bios);
+
+    if(!core->bus.pak.loadFile(options.rom_path)) {
+        LOG_ERROR("Failed to load file '{}'!", options.rom_path);
+        return false;
+    }
+
+    return start();
+}
+
+//Uses images that may be shared with other sessions, saves are only kept in memory
+auto Session::load(std::shared_ptr<const std::vector<u8>> bios, std::shared_ptr<const std::vector<u8>> rom) -> bool {
+    core->loadBIOS(std::move(bios));
+
+    if(!core->bus.pak.loadImage(std::move(rom), "")) {
+        LOG_ERROR("Failed to load ROM image!");
+        return false;
+    }
+
+    return start();
+}
+
+auto Session::start() -> bool {
+    if(!options.movie_path.empty() && !input_device.load(options.movie_path)) {
+        return false;
+    }
+
+    //Whether the first frame is drawn is decided on reset
+    core->ppu.setRenderPolicy(wantsFrame(1) ? emu::RENDER_ALL : emu::RENDER_NONE);
+    core->reset(options.skip_bios, false);
+    frame = 0;
+    cycle_diff = 0;
+
+    return input_device.start(*core);
+}
+
+//Runs up to count more frames, stopping early at the end of the session
+auto Session::runFrames(u64 count) -> u64 {
+    u64 ran = 0;
+
+    while(ran < count && !finished()) {
+        //The render policy only takes effect at the next V-Blank, so a frame
+        //has to be requested while the one before it is running
+        core->ppu.setRenderPolicy(wantsFrame(frame + 1) || wantsFrame(frame + 2) ? emu::RENDER_ALL : emu::RENDER_NONE);
+        input_device.setFrame(frame);
+
+        cycle_diff += CYCLES_PER_FRAME;
+        cycle_diff -= core->run(cycle_diff);
+        frame++;
+        ran++;
+
+        takeScreenshots();
+    }
+
+    return ran;
+}
+
+auto Session::finish() -> bool {
+    bool success = true;
+
+    if(!options.state_path.empty()) {
+        std::ofstream file(options.state_path, std::ios_base::binary);
+
+        if(file.is_open()) {
+            core->saveState(file);
+        } else {
+            LOG_ERROR("Failed to open file '{}' for saving state!", options.state_path);
+            success = false;
+        }
+    }
+
+    if(WavAudioDevice *wav = dynamic_cast<WavAudioDevice*>(audio_device.get())) {
+        success = success && wav->isOpen();
+        wav->close();
+    }
+
+    return success;
+}
+
+auto Session::finished() const -> bool {
+    return frame >= options.frames;
+}
+
+auto Session::getFrame() const -> u64 {
+    return frame;
+}
+
+auto Session::getCore() -> emu::GBA& {
+    return *core;
+}
+
+auto Session::getVideoDevice() const -> const FrameVideoDevice& {
+    return video_device;
+}
+
+auto Session::getInputDevice() -> MovieInputDevice& {
+    return input_device;
+}
+
+auto Session::wantsFrame(u64 frame) const -> bool {
+    for(const auto &screenshot : options.screenshots) {
+        if(screenshot.frame == frame) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Session::takeScreenshots() {
+    for(const auto &screenshot : options.screenshots) {
+        if(screenshot.frame == frame) {
+            writeImage(screenshot.path, video_device.getFrame(), 240, 160);
+        }
+    }
+}
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "device/FrameVideoDevice.hpp"
+#include "device/MovieInputDevice.hpp"
+#include "emulator/core/GBA.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace headless {
+
+struct Screenshot {
+    u64 frame; //Taken once this many frames have run
+    std::string path;
+};
+
+struct SessionOptions {
+    std::string rom_path;
+    std::string bios_path = "bios.bin";
+    std::string movie_path;
+    std::string state_path; //Save state written after the last frame
+    std::string audio_path; //WAV file, no audio is kept if empty
+    std::vector<Screenshot> screenshots;
+    u64 frames = 60;
+    bool skip_bios = true;
+};
+
+/*
+ * A single emulator instance that runs without a window, as fast as possible.
+ * Nothing is drawn unless a screenshot needs it.
+ */
+class Session final {
+public:
+
+    explicit Session(const SessionOptions &options);
+    ~Session();
+
+    auto load() -> bool;
+    auto load(std::shared_ptr<const std::vector<u8>> bios, std::shared_ptr<const std::vector<u8>> rom) -> bool;
+    auto runFrames(u64 count) -> u64;
+    auto finish() -> bool;
+
+    auto finished() const -> bool;
+    auto getFrame() const -> u64;
+    auto getCore() -> emu::GBA&;
+    auto getVideoDevice() const -> const FrameVideoDevice&;
+    auto getInputDevice() -> MovieInputDevice&;
+
+private:
+
+    auto start() -> bool;
+    auto wantsFrame(u64 frame) const -> bool;
+    void takeScreenshots();
+
+    static constexpr u32 CYCLES_PER_FRAME = 280896;
+
+    SessionOptions options;
+    FrameVideoDevice video_device;
+    MovieInputDevice input_device;
+    std::unique_ptr<emu::AudioDevice> audio_device;
+    std::unique_ptr<emu::GBA> core;
+
+    u64 frame;
+    s32 cycle_diff;
+};
+
+} //namespace headless
\ No newline at end of file
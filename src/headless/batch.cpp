@@ -0,0 +1,168 @@
+#include "BatchRunner.hpp"
+#include "common/Version.hpp"
+#include "common/Types.hpp"
+#include "common/Log.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+
+//Replaces every "{}" in a path with the instance number
+auto instancePath(const std::string &pattern, size_t instance) -> std::string {
+    std::string path = pattern;
+    std::string number = std::to_string(instance);
+
+    for(size_t pos = path.find("{}"); pos != std::string::npos; pos = path.find("{}", pos + number.size())) {
+        path.replace(pos, 2, number);
+    }
+
+    return path;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> rom_paths, movie_paths;
+    std::string bios_path = "bios.bin", state_path;
+    size_t instances = 0;
+    size_t threads = std::thread::hardware_concurrency();
+    u64 frames = 60, slice = 60;
+    bool skip_bios = true, quiet = false;
+    u8 log_filter = 0xFF & ~common::log::LEVEL_DEBUG & ~common::log::LEVEL_TRACE;
+
+    for(int i = 1; i < argc; i++) {
+        const char *str = argv[i];
+
+        if(str[0] == '-') {
+            if(strlen(str) < 2) {
+                continue;
+            }
+
+            const char *substr = &argv[i][1];
+
+            if(strcmp(substr, "h") == 0 || strcmp(substr, "-help") == 0) {
+                fmt::print("Usage: gambit-batch [options] rom_path...\n");
+                fmt::print("\n");
+                fmt::print("Runs many instances at once, instance i uses ROM i modulo the number of ROMs.\n");
+                fmt::print("A {{}} in a movie or state path is replaced with the instance number.\n");
+                fmt::print("\n");
+                fmt::print("-h --help     Prints help text\n");
+                fmt::print("-v --version  Prints version information\n");
+                fmt::print("-b FILE       Specify path to a BIOS binary (defaults to bios.bin)\n");
+                fmt::print("-n N          Number of instances           (defaults to one per ROM)\n");
+                fmt::print("-j N          Number of threads             (defaults to one per core)\n");
+                fmt::print("-f N          Number of frames per instance (defaults to 60)\n");
+                fmt::print("-m FILE       Play back input from a movie file, can be repeated\n");
+                fmt::print("-o FILE       Save a state after the last frame\n");
+                fmt::print("--slice N     Frames run before switching instances (defaults to 60)\n");
+                fmt::print("--boot-bios   Run the BIOS boot sequence    (skipped by default)\n");
+                fmt::print("-q            Don't print progress\n");
+                fmt::print("-d            Enable debug level logging    (disabled by default)\n");
+                fmt::print("-t            Enable trace level logging    (disabled by default)\n");
+                fmt::print("-i            Disable info level logging    (enabled by default)\n");
+                fmt::print("-w            Disable warning level logging (enabled by default)\n");
+                fmt::print("-e            Disable error level logging   (enabled by default)\n");
+
+                return 0;
+            } else if(strcmp(substr, "v") == 0 || strcmp(substr, "-version") == 0) {
+                fmt::print("Gambit, Game Boy Advance Emulator,\n");
+                fmt::print("Copyright (c) 2021-2023 Wycube\n");
+                fmt::print("\n");
+                fmt::print("Version : {}\n", common::GIT_DESC);
+                fmt::print("Branch  : {}\n", common::GIT_BRANCH);
+                fmt::print("Commit  : {}\n", common::GIT_COMMIT);
+
+                return 0;
+            } else if(strcmp(substr, "b") == 0) {
+                if(i + 1 < argc) {
+                    bios_path = argv[++i];
+                }
+            } else if(strcmp(substr, "n") == 0) {
+                if(i + 1 < argc) {
+                    instances = std::strtoull(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "j") == 0) {
+                if(i + 1 < argc) {
+                    threads = std::strtoull(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "f") == 0) {
+                if(i + 1 < argc) {
+                    frames = std::strtoull(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "m") == 0) {
+                if(i + 1 < argc) {
+                    movie_paths.push_back(argv[++i]);
+                }
+            } else if(strcmp(substr, "o") == 0) {
+                if(i + 1 < argc) {
+                    state_path = argv[++i];
+                }
+            } else if(strcmp(substr, "-slice") == 0) {
+                if(i + 1 < argc) {
+                    slice = std::strtoull(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "-boot-bios") == 0) {
+                skip_bios = false;
+            } else if(strcmp(substr, "q") == 0) {
+                quiet = true;
+            } else if(strcmp(substr, "d") == 0) {
+                log_filter |= common::log::LEVEL_DEBUG;
+            } else if(strcmp(substr, "t") == 0) {
+                log_filter |= common::log::LEVEL_TRACE;
+            } else if(strcmp(substr, "i") == 0) {
+                log_filter &= ~common::log::LEVEL_INFO;
+            } else if(strcmp(substr, "w") == 0) {
+                log_filter &= ~common::log::LEVEL_WARNING;
+            } else if(strcmp(substr, "e") == 0) {
+                log_filter &= ~common::log::LEVEL_ERROR;
+            } else {
+                LOG_WARNING("Unknown option '{}'", substr);
+            }
+        } else {
+            rom_paths.push_back(str);
+        }
+    }
+
+    common::log::set_log_filter(log_filter);
+
+    if(rom_paths.empty()) {
+        LOG_ERROR("No ROM specified!");
+        return 1;
+    }
+
+    if(instances == 0) {
+        instances = rom_paths.size();
+    }
+
+    headless::BatchRunner runner(threads, slice);
+
+    for(size_t i = 0; i < instances; i++) {
+        headless::SessionOptions options;
+        options.rom_path = rom_paths[i % rom_paths.size()];
+        options.bios_path = bios_path;
+        options.frames = frames;
+        options.skip_bios = skip_bios;
+
+        if(!movie_paths.empty()) {
+            options.movie_path = instancePath(movie_paths[i % movie_paths.size()], i);
+        }
+
+        if(!state_path.empty()) {
+            options.state_path = instancePath(state_path, i);
+        }
+
+        if(!runner.add(options)) {
+            return 1;
+        }
+    }
+
+    headless::BatchStats stats = runner.run([&](const headless::BatchStats &stats) {
+        if(!quiet) {
+            fmt::print("{}/{} frames, {:.1f} fps\n", stats.frames, stats.instances * frames, stats.frames / stats.seconds);
+        }
+    });
+
+    double fps = stats.frames / stats.seconds;
+    fmt::print("Ran {} instances for {} frames in {:.3f}s on {} threads\n", stats.instances, stats.frames, stats.seconds, threads);
+    fmt::print("Throughput: {:.1f} fps ({:.2f}x speed), {:.1f} fps per instance, {} steals\n", fps, fps / 59.7275, fps / stats.instances, stats.steals);
+
+    return stats.failed == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "FrameVideoDevice.hpp"
+#include <cstring>
+
+
+namespace headless {
+
+FrameVideoDevice::FrameVideoDevice() {
+    std::memset(framebuffer, 0, sizeof(framebuffer));
+    std::memset(presented, 0, sizeof(presented));
+    frames_presented = 0;
+}
+
+void FrameVideoDevice::setPixel(int x, int y, u32 color) {
+    framebuffer[x + y * 240] = color;
+}
+
+void FrameVideoDevice::setLine(int y, const u32 *colors) {
+    std::memcpy(&framebuffer[y * 240], colors, 240 * sizeof(u32));
+}
+
+void FrameVideoDevice::presentFrame() {
+    std::memcpy(presented, framebuffer, sizeof(presented));
+    frames_presented++;
+}
+
+//RGBA8888, the same as what the PPU draws
+auto FrameVideoDevice::getFrame() const -> const u32* {
+    return presented;
+}
+
+auto FrameVideoDevice::getFramesPresented() const -> u64 {
+    return frames_presented;
+}
+
+} //namespace headless
\ No newline at end of file
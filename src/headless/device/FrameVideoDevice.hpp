@@ -0,0 +1,28 @@
+#pragma once
+
+#include "emulator/device/VideoDevice.hpp"
+
+
+namespace headless {
+
+//Keeps the last presented frame in memory, so it can be saved as a screenshot
+class FrameVideoDevice final : public emu::VideoDevice {
+public:
+
+    FrameVideoDevice();
+
+    void setPixel(int x, int y, u32 color) override;
+    void setLine(int y, const u32 *colors) override;
+    void presentFrame() override;
+
+    auto getFrame() const -> const u32*;
+    auto getFramesPresented() const -> u64;
+
+private:
+
+    u32 framebuffer[240 * 160];
+    u32 presented[240 * 160];
+    u64 frames_presented;
+};
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "MovieInputDevice.hpp"
+#include "emulator/core/GBA.hpp"
+#include "common/StringUtils.hpp"
+#include "common/Log.hpp"
+#include <fstream>
+#include <sstream>
+
+
+namespace headless {
+
+//Same order as the bits in KEYINPUT
+static const char *BUTTON_NAMES[10] = {
+    "A", "B", "SELECT", "START", "RIGHT", "LEFT", "UP", "DOWN", "R", "L"
+};
+
+auto MovieInputDevice::load(const std::string &path) -> bool {
+    std::ifstream file(path, std::ios_base::binary);
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open input movie '{}'!", path);
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    const std::string contents = text.str();
+
+    if(emu::InputMovie::isMovie(reinterpret_cast<const u8*>(contents.data()), contents.size())) {
+        entries.clear();
+        core = nullptr;
+
+        common::MemoryDeserializer deserializer(reinterpret_cast<const u8*>(contents.data()), contents.size());
+        return movie.deserialize(deserializer);
+    }
+
+    return parse(contents);
+}
+
+auto MovieInputDevice::parse(const std::string &text) -> bool {
+    std::istringstream stream(text);
+    std::string line;
+    size_t line_number = 0;
+
+    entries.clear();
+    movie.clear();
+    core = nullptr;
+    current = 0;
+    pressed = 0;
+
+    while(std::getline(stream, line)) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream tokens(line);
+        std::string frame, buttons;
+        if(!(tokens >> frame)) {
+            continue;
+        }
+
+        Entry entry{};
+        try {
+            entry.frame = std::stoull(frame);
+        } catch(const std::exception&) {
+            LOG_ERROR("Invalid frame '{}' on line {} of input movie!", frame, line_number);
+            return false;
+        }
+
+        if(!entries.empty() && entry.frame <= entries.back().frame) {
+            LOG_ERROR("Frames are out of order on line {} of input movie!", line_number);
+            return false;
+        }
+
+        tokens >> buttons;
+        if(!parseButtons(buttons, entry.pressed)) {
+            LOG_ERROR("Unknown button in '{}' on line {} of input movie!", buttons, line_number);
+            return false;
+        }
+
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+//Buttons joined with '+', or '-' for none
+auto MovieInputDevice::parseButtons(const std::string &buttons, u16 &pressed) -> bool {
+    pressed = 0;
+
+    if(buttons == "-" || buttons.empty()) {
+        return true;
+    }
+
+    std::istringstream names(common::to_upper(buttons));
+    std::string name;
+
+    while(std::getline(names, name, '+')) {
+        bool found = false;
+
+        for(int i = 0; i < 10; i++) {
+            if(name == BUTTON_NAMES[i]) {
+                pressed |= 1 << i;
+                found = true;
+            }
+        }
+
+        if(!found) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Should be called after the core is reset, recorded movies pick up from their own state
+auto MovieInputDevice::start(emu::GBA &core) -> bool {
+    if(movie.state.empty()) {
+        return true;
+    }
+
+    if(movie.title != core.bus.pak.getTitle()) {
+        LOG_WARNING("Input movie was recorded with '{}', not '{}'!", movie.title, core.bus.pak.getTitle());
+    }
+
+    if(!core.loadState(movie.state.data(), movie.state.size())) {
+        LOG_ERROR("Failed to load the state input movie starts from!");
+        return false;
+    }
+
+    this->core = &core;
+    return true;
+}
+
+//Should be called before running each frame
+void MovieInputDevice::setFrame(u64 frame) {
+    //Usually moves forward by one frame, so only start over when going backwards
+    if(current > 0 && entries[current - 1].frame > frame) {
+        current = 0;
+        pressed = 0;
+    }
+
+    while(current < entries.size() && entries[current].frame <= frame) {
+        pressed = entries[current].pressed;
+        current++;
+    }
+}
+
+void MovieInputDevice::setHeld(u16 held) {
+    this->held = held;
+}
+
+auto MovieInputDevice::getKeys() -> u16 {
+    if(core != nullptr) {
+        return movie.getKeys(core->scheduler.getCurrentTimestamp()) & ~held & 0x3FF;
+    }
+
+    return ~(pressed | held) & 0x3FF;
+}
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "emulator/device/InputDevice.hpp"
+#include "emulator/core/InputMovie.hpp"
+#include <string>
+#include <vector>
+
+
+namespace headless {
+
+/*
+ * Plays back a simple text input movie. Each line holds a frame number and the
+ * buttons held from that frame on, joined with '+', or '-' for none:
+ *
+ *   #Press start for a few frames, then hold right and A
+ *   120 START
+ *   125 -
+ *   300 RIGHT+A
+ *
+ * Lines have to be in increasing frame order, and anything after '#' is ignored.
+ *
+ * Movies recorded by the frontend are binary instead, and are played back
+ * from the save state they were recorded from, keyed by the scheduler's
+ * timestamp rather than the frame, so the run is reproduced exactly.
+ */
+class MovieInputDevice final : public emu::InputDevice {
+public:
+
+    auto load(const std::string &path) -> bool;
+    auto parse(const std::string &text) -> bool;
+    auto start(emu::GBA &core) -> bool;
+    static auto parseButtons(const std::string &buttons, u16 &pressed) -> bool;
+
+    void setFrame(u64 frame);
+    void setHeld(u16 held);
+    auto getKeys() -> u16 override;
+
+private:
+
+    struct Entry {
+        u64 frame;
+        u16 pressed; //Bits in KEYINPUT order, but 1 is pressed
+    };
+
+    std::vector<Entry> entries;
+    emu::InputMovie movie;
+    emu::GBA *core = nullptr; //Only set when playing a recorded movie
+    size_t current = 0;
+    u16 pressed = 0;
+    u16 held = 0; //Pressed on top of the movie
+};
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "emulator/device/VideoDevice.hpp"
+#include "emulator/device/InputDevice.hpp"
+#include "emulator/device/AudioDevice.hpp"
+
+
+namespace headless {
+
+//Devices that ignore everything, for when a job doesn't need any output
+
+class NullVideoDevice final : public emu::VideoDevice {
+public:
+
+    void setPixel(int, int, u32) override { }
+    void setLine(int, const u32*) override { }
+    void presentFrame() override { }
+};
+
+class NullInputDevice final : public emu::InputDevice {
+public:
+
+    auto getKeys() -> u16 override { return 0x3FF; }
+};
+
+class NullAudioDevice final : public emu::AudioDevice {
+public:
+
+    void pushSample(float, float) override { }
+    void pushSamples(const float*, size_t) override { }
+    auto full() -> bool override { return false; }
+    void setSampleRate(int) override { }
+};
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "WavAudioDevice.hpp"
+#include "common/Log.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+namespace headless {
+
+WavAudioDevice::WavAudioDevice(const std::string &path) : file(path, std::ios_base::binary) {
+    frames_written = 0;
+    input_fill = 0;
+
+    if(!file.is_open()) {
+        LOG_ERROR("Failed to open file '{}' for writing audio!", path);
+        return;
+    }
+
+    //Sizes are filled in once the file is closed
+    writeHeader();
+}
+
+WavAudioDevice::~WavAudioDevice() {
+    close();
+}
+
+auto WavAudioDevice::isOpen() const -> bool {
+    return file.is_open();
+}
+
+void WavAudioDevice::close() {
+    if(!file.is_open()) {
+        return;
+    }
+
+    flush();
+    file.seekp(0);
+    writeHeader();
+    file.close();
+}
+
+void WavAudioDevice::pushSample(float left, float right) {
+    input[input_fill * 2 + 0] = left;
+    input[input_fill * 2 + 1] = right;
+
+    if(++input_fill == BLOCK_FRAMES) {
+        flush();
+    }
+}
+
+void WavAudioDevice::pushSamples(const float *samples, size_t count) {
+    while(count > 0) {
+        const size_t amount = std::min(count, BLOCK_FRAMES - input_fill);
+        std::memcpy(&input[input_fill * 2], samples, amount * 2 * sizeof(float));
+        input_fill += amount;
+        samples += amount * 2;
+        count -= amount;
+
+        if(input_fill == BLOCK_FRAMES) {
+            flush();
+        }
+    }
+}
+
+auto WavAudioDevice::full() -> bool {
+    return false;
+}
+
+void WavAudioDevice::setSampleRate(int resolution) {
+    //Anything already buffered was generated at the old rate
+    flush();
+    resampler.setRates(32768 << resolution, SAMPLE_RATE);
+}
+
+void WavAudioDevice::writeHeader() {
+    const u32 data_size = frames_written * 4;
+    const u32 riff_size = 36 + data_size;
+    const u32 format_size = 16;
+    const u16 format = 1; //PCM
+    const u16 channels = 2;
+    const u32 sample_rate = SAMPLE_RATE;
+    const u32 byte_rate = SAMPLE_RATE * 4;
+    const u16 block_align = 4;
+    const u16 bits_per_sample = 16;
+
+    file.write("RIFF", 4);
+    file.write(reinterpret_cast<const char*>(&riff_size), sizeof(riff_size));
+    file.write("WAVEfmt ", 8);
+    file.write(reinterpret_cast<const char*>(&format_size), sizeof(format_size));
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(reinterpret_cast<const char*>(&channels), sizeof(channels));
+    file.write(reinterpret_cast<const char*>(&sample_rate), sizeof(sample_rate));
+    file.write(reinterpret_cast<const char*>(&byte_rate), sizeof(byte_rate));
+    file.write(reinterpret_cast<const char*>(&block_align), sizeof(block_align));
+    file.write(reinterpret_cast<const char*>(&bits_per_sample), sizeof(bits_per_sample));
+    file.write("data", 4);
+    file.write(reinterpret_cast<const char*>(&data_size), sizeof(data_size));
+}
+
+//Resamples and writes as much of the buffered input as possible
+void WavAudioDevice::flush() {
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    do {
+        produced = 0;
+
+        while(produced < BLOCK_FRAMES) {
+            const size_t needed = resampler.inputNeeded(1);
+            if(consumed + needed > input_fill) {
+                break;
+            }
+
+            resampler.process(&input[consumed * 2], &output[produced * 2], 1);
+            consumed += needed;
+            produced++;
+        }
+
+        s16 pcm[BLOCK_FRAMES * 2];
+        for(size_t i = 0; i < produced * 2; i++) {
+            pcm[i] = static_cast<s16>(std::clamp(output[i], -1.0f, 1.0f) * 32767.0f);
+        }
+
+        if(file.is_open()) {
+            file.write(reinterpret_cast<const char*>(pcm), produced * 2 * sizeof(s16));
+            frames_written += produced;
+        }
+    } while(produced == BLOCK_FRAMES);
+
+    std::memmove(input, &input[consumed * 2], (input_fill - consumed) * 2 * sizeof(float));
+    input_fill -= consumed;
+}
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "emulator/device/AudioDevice.hpp"
+#include "common/Resampler.hpp"
+#include <fstream>
+#include <string>
+
+
+namespace headless {
+
+/*
+ * Writes audio to a 16-bit stereo WAV file. The APU's sample rate can change
+ * at any time, so everything is resampled to a fixed rate for the file.
+ */
+class WavAudioDevice final : public emu::AudioDevice {
+public:
+
+    static constexpr u32 SAMPLE_RATE = 48000;
+
+    explicit WavAudioDevice(const std::string &path);
+    ~WavAudioDevice();
+
+    auto isOpen() const -> bool;
+    void close();
+
+    void pushSample(float left, float right) override;
+    void pushSamples(const float *samples, size_t count) override;
+    auto full() -> bool override;
+    void setSampleRate(int resolution) override;
+
+private:
+
+    void writeHeader();
+    void flush();
+
+    static constexpr size_t BLOCK_FRAMES = 1024;
+
+    std::ofstream file;
+    common::Resampler resampler;
+    u32 frames_written;
+
+    float input[BLOCK_FRAMES * 2];
+    size_t input_fill;
+    float output[BLOCK_FRAMES * 2];
+};
+
+} //namespace headless
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "Session.hpp"
+#include "Latency.hpp"
+#include "Determinism.hpp"
+#include "common/Version.hpp"
+#include "common/Types.hpp"
+#include "common/Log.hpp"
+#include "common/Trace.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+
+//Parses "N:FILE" into a screenshot taken after N frames
+auto parseScreenshot(const char *str, headless::Screenshot &screenshot) -> bool {
+    char *end = nullptr;
+    u64 frame = std::strtoull(str, &end, 10);
+
+    if(end == str || *end != ':' || end[1] == '\0') {
+        return false;
+    }
+
+    screenshot.frame = frame;
+    screenshot.path = end + 1;
+    return true;
+}
+
+auto reportDivergence(const std::vector<headless::FrameHashes> &expected, const std::vector<headless::FrameHashes> &actual) -> bool {
+    headless::Divergence divergence;
+
+    if(expected.size() != actual.size()) {
+        LOG_WARNING("Runs hashed {} and {} frames", expected.size(), actual.size());
+    }
+
+    if(headless::findDivergence(expected, actual, divergence)) {
+        std::string components;
+
+        for(const auto &component : divergence.components) {
+            components += components.empty() ? component : ", " + component;
+        }
+
+        fmt::print("Diverged at frame {} in {}\n", divergence.frame, components);
+        return false;
+    }
+
+    fmt::print("No divergence in {} frames\n", expected.size());
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    bool has_rom_path = false;
+    headless::SessionOptions options;
+    std::string latency_buttons;
+    u32 max_run_ahead = 2;
+    std::string hash_path, compare_path;
+    std::string log_path, trace_path;
+    bool check_determinism = false;
+    u8 log_filter = 0xFF & ~common::log::LEVEL_DEBUG & ~common::log::LEVEL_TRACE;
+
+    for(int i = 1; i < argc; i++) {
+        const char *str = argv[i];
+
+        if(str[0] == '-') {
+            if(strlen(str) < 2) {
+                continue;
+            }
+
+            const char *substr = &argv[i][1];
+
+            if(strcmp(substr, "h") == 0 || strcmp(substr, "-help") == 0) {
+                fmt::print("Usage: gambit-headless [options] rom_path\n");
+                fmt::print("\n");
+                fmt::print("-h --help     Prints help text\n");
+                fmt::print("-v --version  Prints version information\n");
+                fmt::print("-b FILE       Specify path to a BIOS binary (defaults to bios.bin)\n");
+                fmt::print("-f N          Number of frames to run       (defaults to 60)\n");
+                fmt::print("-m FILE       Play back input from a movie file\n");
+                fmt::print("-s N:FILE     Save a screenshot after N frames, can be repeated\n");
+                fmt::print("-o FILE       Save a state after the last frame\n");
+                fmt::print("-a FILE       Record audio to a WAV file\n");
+                fmt::print("-l BUTTONS    Measure input latency of pressing BUTTONS after the last frame\n");
+                fmt::print("-r N          Most run-ahead frames to measure latency with (defaults to 2)\n");
+                fmt::print("-H FILE       Save the state's hashes from every frame\n");
+                fmt::print("-c FILE       Compare the state's hashes from every frame to ones saved with -H\n");
+                fmt::print("--check       Run twice and compare the state's hashes from every frame\n");
+                fmt::print("-L FILE       Write log messages to a file as well\n");
+                fmt::print("-T FILE       Record a binary trace of emulator events, read with gambit-trace\n");
+                fmt::print("--boot-bios   Run the BIOS boot sequence    (skipped by default)\n");
+                fmt::print("-d            Enable debug level logging    (disabled by default)\n");
+                fmt::print("-t            Enable trace level logging    (disabled by default)\n");
+                fmt::print("-i            Disable info level logging    (enabled by default)\n");
+                fmt::print("-w            Disable warning level logging (enabled by default)\n");
+                fmt::print("-e            Disable error level logging   (enabled by default)\n");
+
+                return 0;
+            } else if(strcmp(substr, "v") == 0 || strcmp(substr, "-version") == 0) {
+                fmt::print("Gambit, Game Boy Advance Emulator,\n");
+                fmt::print("Copyright (c) 2021-2023 Wycube\n");
+                fmt::print("\n");
+                fmt::print("Version : {}\n", common::GIT_DESC);
+                fmt::print("Branch  : {}\n", common::GIT_BRANCH);
+                fmt::print("Commit  : {}\n", common::GIT_COMMIT);
+
+                return 0;
+            } else if(strcmp(substr, "b") == 0) {
+                if(i + 1 < argc) {
+                    options.bios_path = argv[++i];
+                }
+            } else if(strcmp(substr, "f") == 0) {
+                if(i + 1 < argc) {
+                    options.frames = std::strtoull(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "m") == 0) {
+                if(i + 1 < argc) {
+                    options.movie_path = argv[++i];
+                }
+            } else if(strcmp(substr, "s") == 0) {
+                if(i + 1 < argc) {
+                    headless::Screenshot screenshot;
+
+                    if(parseScreenshot(argv[++i], screenshot)) {
+                        options.screenshots.push_back(screenshot);
+                    } else {
+                        LOG_WARNING("Invalid screenshot '{}', expected N:FILE", argv[i]);
+                    }
+                }
+            } else if(strcmp(substr, "o") == 0) {
+                if(i + 1 < argc) {
+                    options.state_path = argv[++i];
+                }
+            } else if(strcmp(substr, "a") == 0) {
+                if(i + 1 < argc) {
+                    options.audio_path = argv[++i];
+                }
+            } else if(strcmp(substr, "l") == 0) {
+                if(i + 1 < argc) {
+                    latency_buttons = argv[++i];
+                }
+            } else if(strcmp(substr, "r") == 0) {
+                if(i + 1 < argc) {
+                    max_run_ahead = std::strtoul(argv[++i], nullptr, 10);
+                }
+            } else if(strcmp(substr, "H") == 0) {
+                if(i + 1 < argc) {
+                    hash_path = argv[++i];
+                }
+            } else if(strcmp(substr, "c") == 0) {
+                if(i + 1 < argc) {
+                    compare_path = argv[++i];
+                }
+            } else if(strcmp(substr, "L") == 0) {
+                if(i + 1 < argc) {
+                    log_path = argv[++i];
+                }
+            } else if(strcmp(substr, "T") == 0) {
+                if(i + 1 < argc) {
+                    trace_path = argv[++i];
+                }
+            } else if(strcmp(substr, "-check") == 0) {
+                check_determinism = true;
+            } else if(strcmp(substr, "-boot-bios") == 0) {
+                options.skip_bios = false;
+            } else if(strcmp(substr, "d") == 0) {
+                log_filter |= common::log::LEVEL_DEBUG;
+            } else if(strcmp(substr, "t") == 0) {
+                log_filter |= common::log::LEVEL_TRACE;
+            } else if(strcmp(substr, "i") == 0) {
+                log_filter &= ~common::log::LEVEL_INFO;
+            } else if(strcmp(substr, "w") == 0) {
+                log_filter &= ~common::log::LEVEL_WARNING;
+            } else if(strcmp(substr, "e") == 0) {
+                log_filter &= ~common::log::LEVEL_ERROR;
+            } else {
+                LOG_WARNING("Unknown option '{}'", substr);
+            }
+        } else if(!has_rom_path) {
+            options.rom_path = str;
+            has_rom_path = true;
+        }
+    }
+
+    common::log::set_log_filter(log_filter);
+
+    if(!log_path.empty() && !common::log::set_log_file(log_path)) {
+        LOG_ERROR("Failed to open log file '{}'!", log_path);
+        return 1;
+    }
+
+    if(!has_rom_path) {
+        LOG_ERROR("No ROM specified!");
+        return 1;
+    }
+
+    u16 buttons = 0;
+    if(!headless::MovieInputDevice::parseButtons(latency_buttons, buttons)) {
+        LOG_ERROR("Unknown button in '{}'!", latency_buttons);
+        return 1;
+    }
+
+    headless::Session session(options);
+
+    if(!session.load()) {
+        return 1;
+    }
+
+    const bool wants_hashes = !hash_path.empty() || !compare_path.empty() || check_determinism;
+    std::vector<headless::FrameHashes> hashes;
+
+    if(!trace_path.empty() && !common::trace::start(trace_path)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if(wants_hashes) {
+        hashes = headless::recordHashes(session, options.frames);
+    } else {
+        session.runFrames(options.frames);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    common::trace::stop();
+
+    if(!session.finish()) {
+        return 1;
+    }
+
+    //Anything logged while running goes first
+    common::log::flush();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double fps = session.getFrame() / seconds;
+    fmt::print("Ran {} frames in {:.3f}s ({:.1f} fps, {:.2f}x speed)\n", session.getFrame(), seconds, fps, fps / 59.7275);
+
+    if(!hash_path.empty() && !headless::saveHashes(hash_path, hashes)) {
+        return 1;
+    }
+
+    if(!compare_path.empty()) {
+        std::vector<headless::FrameHashes> expected;
+
+        if(!headless::loadHashes(compare_path, expected) || !reportDivergence(expected, hashes)) {
+            return 1;
+        }
+    }
+
+    //The second run only needs the same input, none of the files the first one wrote
+    if(check_determinism) {
+        headless::SessionOptions again = options;
+        again.state_path.clear();
+        again.audio_path.clear();
+        again.screenshots.clear();
+
+        headless::Session second(again);
+        if(!second.load() || !reportDivergence(hashes, headless::recordHashes(second, options.frames))) {
+            return 1;
+        }
+    }
+
+    if(!latency_buttons.empty()) {
+        for(const auto &result : headless::measureLatency(session, buttons, max_run_ahead)) {
+            if(result.frames < 0) {
+                fmt::print("Run-ahead {}: no change on screen, {:.3f}ms per frame\n", result.run_ahead, result.frame_time * 1000);
+            } else {
+                fmt::print("Run-ahead {}: {} frame latency, {:.3f}ms per frame\n", result.run_ahead, result.frames, result.frame_time * 1000);
+            }
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
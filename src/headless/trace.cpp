@@ -0,0 +1,38 @@
+#include "common/MappedFile.hpp"
+#include "common/Trace.hpp"
+#include "common/Log.hpp"
+#include <cstring>
+
+
+int main(int argc, char *argv[]) {
+    if(argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        fmt::print("Usage: gambit-trace trace_path\n");
+        fmt::print("\n");
+        fmt::print("Prints a trace recorded with gambit-headless -T, one event per line\n");
+        fmt::print("with the cycle it happened on.\n");
+
+        return argc < 2 ? 1 : 0;
+    }
+
+    common::MappedFile file;
+    if(!file.open(argv[1])) {
+        LOG_ERROR("Failed to open trace '{}'!", argv[1]);
+        return 1;
+    }
+
+    std::vector<common::trace::EventInfo> events;
+    std::vector<common::trace::Event> records;
+
+    if(!common::trace::read_trace(file.data(), file.size(), events, records)) {
+        return 1;
+    }
+
+    common::log::flush();
+
+    for(const auto &record : records) {
+        const common::trace::EventInfo &info = events[record.id];
+        fmt::print("{:>12} {:<12} {}\n", record.timestamp, info.name, common::trace::format_event(info, record));
+    }
+
+    return 0;
+}
\ No newline at end of file
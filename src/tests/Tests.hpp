@@ -3,7 +3,20 @@
 #include "tests/core/arm/DisassemblyTests.hpp"
 #include "tests/core/arm/DecodeTests.hpp"
 #include "tests/core/thumb/DisassemblyTests.hpp"
+#include "tests/core/apu/BlipBufferTests.hpp"
+#include "tests/core/apu/ChannelTests.hpp"
+#include "tests/core/apu/MixingTests.hpp"
+#include "tests/core/ppu/RenderTests.hpp"
+#include "tests/core/InputMovieTests.hpp"
+#include "tests/core/SaveStateTests.hpp"
 #include "tests/common/PatternTests.hpp"
+#include "tests/common/ResamplerTests.hpp"
+#include "tests/common/SerializerTests.hpp"
+#include "tests/common/RewindBufferTests.hpp"
+#include "tests/common/CompressionTests.hpp"
+#include "tests/common/StatePackTests.hpp"
+#include "tests/common/HashTests.hpp"
+#include "tests/common/TraceTests.hpp"
 
 #define TEST_VEC(specification) lest::tests(specification, specification + sizeof(specification) / sizeof(specification[0]))
 
@@ -12,5 +25,18 @@ const std::vector<lest::tests> all_tests = {
     TEST_VEC(arm_disassembly_tests),
     TEST_VEC(arm_decode_tests),
     TEST_VEC(thumb_disassembly_tests),
-    TEST_VEC(common_pattern_tests)
+    TEST_VEC(apu_blip_buffer_tests),
+    TEST_VEC(apu_channel_tests),
+    TEST_VEC(apu_mixing_tests),
+    TEST_VEC(ppu_render_tests),
+    TEST_VEC(core_input_movie_tests),
+    TEST_VEC(core_save_state_tests),
+    TEST_VEC(common_pattern_tests),
+    TEST_VEC(common_resampler_tests),
+    TEST_VEC(common_serializer_tests),
+    TEST_VEC(common_rewind_buffer_tests),
+    TEST_VEC(common_compression_tests),
+    TEST_VEC(common_state_pack_tests),
+    TEST_VEC(common_hash_tests),
+    TEST_VEC(common_trace_tests)
 };
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "common/Compression.hpp"
+
+#include <lest/lest.hpp>
+#include <vector>
+
+
+const lest::test common_compression_tests[] = {
+    CASE("Compression round trips runs, repeats, and noise") {
+        std::vector<u8> data(100000, 0);
+        u32 seed = 1;
+
+        //Noise up front, then a repeating pattern, then zeroes
+        for(size_t i = 0; i < 20000; i++) {
+            seed = seed * 1664525 + 1013904223;
+            data[i] = seed >> 24;
+        }
+        for(size_t i = 20000; i < 50000; i++) {
+            data[i] = "gambit"[i % 6];
+        }
+
+        std::vector<u8> compressed;
+        common::compress(data.data(), data.size(), compressed);
+        EXPECT(compressed.size() < 25000u);
+
+        std::vector<u8> decompressed(data.size());
+        EXPECT(common::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()));
+        EXPECT(decompressed == data);
+    },
+
+    CASE("Compression handles inputs too short to have matches") {
+        for(size_t size = 0; size < 8; size++) {
+            std::vector<u8> data(size, 7);
+            std::vector<u8> compressed;
+            common::compress(data.data(), data.size(), compressed);
+
+            std::vector<u8> decompressed(size);
+            EXPECT(common::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()));
+            EXPECT(decompressed == data);
+        }
+    },
+
+    CASE("Decompression fails on truncated data or the wrong size") {
+        std::vector<u8> data(4096, 0);
+        data[1000] = 1;
+        std::vector<u8> compressed;
+        common::compress(data.data(), data.size(), compressed);
+
+        std::vector<u8> decompressed(data.size());
+        EXPECT_NOT(common::decompress(compressed.data(), compressed.size() - 1, decompressed.data(), decompressed.size()));
+        EXPECT_NOT(common::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1));
+    }
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common/Hash.hpp"
+
+#include <lest/lest.hpp>
+#include <cstring>
+
+
+const lest::test common_hash_tests[] = {
+    CASE("Hash matches the XXH64 reference values") {
+        const char *text = "Nobody inspects the spammish repetition";
+
+        EXPECT(common::hash64("", 0) == 0xEF46DB3751D8E999u);
+        EXPECT(common::hash64("a", 1) == 0xD24EC4F1A98C6E5Bu);
+        EXPECT(common::hash64("abc", 3) == 0x44BC2CF5AD770999u);
+        EXPECT(common::hash64(text, std::strlen(text)) == 0xFBCEA83C8A378BF1u);
+    },
+
+    CASE("Hash changes with any single byte") {
+        u8 data[1000] = {};
+        const u64 base = common::hash64(data, sizeof(data));
+
+        for(size_t i = 0; i < sizeof(data); i += 37) {
+            data[i] = 1;
+            EXPECT(common::hash64(data, sizeof(data)) != base);
+            data[i] = 0;
+        }
+
+        EXPECT(common::hash64(data, sizeof(data), 1) != base);
+    }
+};
\ No newline at end of file
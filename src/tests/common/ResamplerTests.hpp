@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common/Resampler.hpp"
+
+#include <lest/lest.hpp>
+#include <cmath>
+#include <vector>
+
+
+const lest::test common_resampler_tests[] = {
+    CASE("Resampler consumes exactly the input it asks for") {
+        common::Resampler resampler;
+        resampler.setRates(65536, 48000);
+        resampler.setRatioAdjust(1.003);
+
+        size_t total_needed = 0;
+        for(int i = 0; i < 100; i++) {
+            total_needed += resampler.inputNeeded(750);
+
+            std::vector<float> input(resampler.inputNeeded(750) * 2, 0.0f);
+            std::vector<float> output(750 * 2);
+            resampler.process(input.data(), output.data(), 750);
+        }
+
+        size_t expected = static_cast<size_t>(65536.0 / 48000.0 * 1.003 * 750 * 100);
+        EXPECT(total_needed >= expected - 1);
+        EXPECT(total_needed <= expected + 1);
+    },
+
+    CASE("Resampler keeps a constant signal at unity gain") {
+        for(double input_rate : {32768.0, 65536.0, 131072.0, 262144.0}) {
+            common::Resampler resampler;
+            resampler.setRates(input_rate, 48000);
+
+            std::vector<float> output(750 * 2);
+            for(int i = 0; i < 4; i++) {
+                std::vector<float> input(resampler.inputNeeded(750) * 2, 0.5f);
+                resampler.process(input.data(), output.data(), 750);
+            }
+
+            for(size_t i = 0; i < output.size(); i++) {
+                EXPECT(std::abs(output[i] - 0.5f) < 0.0001f);
+            }
+        }
+    }
+};
\ No newline at end of file
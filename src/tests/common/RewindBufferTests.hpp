@@ -0,0 +1,121 @@
+#pragma once
+
+#include "common/RewindBuffer.hpp"
+
+#include <lest/lest.hpp>
+#include <vector>
+
+
+static auto makeRewindStates(size_t count) -> std::vector<std::vector<u8>> {
+    std::vector<std::vector<u8>> states;
+    std::vector<u8> state(4096, 0);
+    u32 seed = 1;
+
+    for(size_t i = 0; i < count; i++) {
+        //Change a few scattered bytes, and sometimes the length, between states
+        for(int j = 0; j < 20; j++) {
+            seed = seed * 1664525 + 1013904223;
+            state[(seed >> 8) % state.size()] = seed >> 24;
+        }
+
+        if(i % 7 == 3) {
+            state.resize(state.size() + 5, 0xAA);
+        } else if(i % 11 == 5) {
+            state.resize(state.size() - 9);
+        }
+
+        states.push_back(state);
+    }
+
+    return states;
+}
+
+const lest::test common_rewind_buffer_tests[] = {
+    CASE("Rewind buffer steps back through every state pushed") {
+        std::vector<std::vector<u8>> states = makeRewindStates(50);
+        common::RewindBuffer rewind(1_KiB * 1_KiB);
+
+        for(const auto &state : states) {
+            rewind.push(state);
+        }
+
+        EXPECT(rewind.size() == 49u);
+        EXPECT(rewind.memoryUsed() < states.size() * 1_KiB);
+
+        std::vector<u8> state;
+        for(size_t i = states.size() - 1; i > 0; i--) {
+            EXPECT(rewind.pop(state));
+            EXPECT(state == states[i - 1]);
+        }
+
+        EXPECT_NOT(rewind.pop(state));
+    },
+
+    CASE("Rewind buffer drops the oldest states when full") {
+        std::vector<std::vector<u8>> states = makeRewindStates(200);
+        common::RewindBuffer rewind(4_KiB);
+
+        for(const auto &state : states) {
+            rewind.push(state);
+        }
+
+        size_t available = rewind.size();
+        EXPECT(available > 0u);
+        EXPECT(available < 199u);
+
+        std::vector<u8> state;
+        for(size_t i = 0; i < available; i++) {
+            EXPECT(rewind.pop(state));
+            EXPECT(state == states[states.size() - 2 - i]);
+        }
+
+        //Continuing from a rewound state works the same as from any other
+        rewind.push(states[0]);
+        EXPECT(rewind.pop(state));
+        EXPECT(state == states[states.size() - 1 - available]);
+    },
+
+    CASE("Rewind buffer steps back through incremental captures") {
+        static u8 block[64_KiB] = {};
+        common::DirtyTracker<64_KiB, 4_KiB> pages;
+        common::IncrementalSerializer serializer;
+        common::RewindBuffer rewind(1_KiB * 1_KiB);
+        std::vector<std::vector<u8>> states;
+        u32 seed = 1;
+
+        pages.markAll();
+
+        for(u32 i = 0; i < 40; i++) {
+            for(int j = 0; j < 10; j++) {
+                seed = seed * 1664525 + 1013904223;
+                block[(seed >> 8) % sizeof(block)] = seed >> 24;
+                pages.mark((seed >> 8) % sizeof(block));
+            }
+
+            serializer.begin();
+            serializer.write(i);
+            serializer.writePages(block, pages);
+            serializer.end();
+            pages.clear();
+
+            rewind.push(serializer);
+            states.push_back(serializer.getBuffer());
+
+            //Going back a step in the middle has to make the next capture compare everything
+            if(i == 20) {
+                std::vector<u8> state;
+                EXPECT(rewind.pop(state));
+                EXPECT(state == states[19]);
+                states.pop_back();
+                rewind.push(states.back());
+                states.push_back(states.back());
+            }
+        }
+
+        std::vector<u8> state;
+        for(size_t i = states.size() - 1; i > 0; i--) {
+            EXPECT(rewind.pop(state));
+            EXPECT(state == states[i - 1]);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "common/Serializer.hpp"
+
+#include <lest/lest.hpp>
+#include <vector>
+
+
+const lest::test common_serializer_tests[] = {
+    CASE("Memory serializer round trips values and arrays") {
+        std::vector<u8> buffer;
+        common::MemorySerializer serializer(buffer);
+
+        u32 value = 0x12345678;
+        u16 array[3] = {1, 2, 3};
+        serializer.write(value);
+        serializer.write(array);
+        EXPECT(buffer.size() == sizeof(value) + sizeof(array));
+
+        u32 read_value = 0;
+        u16 read_array[3] = {};
+        common::MemoryDeserializer deserializer(buffer.data(), buffer.size());
+        deserializer.read(read_value);
+        deserializer.read(read_array);
+
+        EXPECT(deserializer.good());
+        EXPECT(read_value == value);
+        EXPECT(read_array[0] == 1);
+        EXPECT(read_array[2] == 3);
+    },
+
+    CASE("Memory deserializer fails instead of reading past the end") {
+        const u8 data[2] = {0xAA, 0xBB};
+        common::MemoryDeserializer deserializer(data, sizeof(data));
+
+        u32 value = 0xFFFFFFFF;
+        deserializer.read(value);
+
+        EXPECT_NOT(deserializer.good());
+        EXPECT(value == 0u);
+    },
+
+    CASE("Numbers are stored little-endian whatever the host is") {
+        std::vector<u8> buffer;
+        common::MemorySerializer serializer(buffer);
+
+        serializer.write(static_cast<u32>(0x12345678));
+        serializer.write(true);
+        serializer.write(static_cast<s16>(-2));
+
+        const std::vector<u8> expected = {0x78, 0x56, 0x34, 0x12, 0x01, 0xFE, 0xFF};
+        EXPECT(buffer == expected);
+    },
+
+    CASE("Chunks that aren't read, or aren't read all the way, are skipped") {
+        std::vector<u8> buffer;
+        common::MemorySerializer serializer(buffer);
+
+        serializer.beginChunk(1);
+        serializer.write(static_cast<u32>(10));
+        serializer.write(static_cast<u32>(20)); //A field a newer version added
+        serializer.endChunk();
+        serializer.beginChunk(2);
+        serializer.write(static_cast<u64>(30));
+        serializer.endChunk();
+        serializer.beginChunk(3);
+        serializer.write(static_cast<u16>(40));
+        serializer.endChunk();
+
+        common::MemoryDeserializer deserializer(buffer.data(), buffer.size());
+        std::vector<u32> ids;
+        u32 id = 0;
+        u32 first = 0;
+        u16 last = 0;
+
+        while(deserializer.beginChunk(id)) {
+            ids.push_back(id);
+
+            if(id == 1) {
+                deserializer.read(first);
+                EXPECT(deserializer.remaining() == 4u);
+            } else if(id == 3) {
+                deserializer.read(last);
+            }
+
+            deserializer.endChunk();
+        }
+
+        EXPECT(deserializer.good());
+        EXPECT(ids == (std::vector<u32>{1, 2, 3}));
+        EXPECT(first == 10u);
+        EXPECT(last == 40u);
+    },
+
+    CASE("Reading past the end of a chunk fails") {
+        std::vector<u8> buffer;
+        common::MemorySerializer serializer(buffer);
+
+        serializer.beginChunk(1);
+        serializer.write(static_cast<u16>(1));
+        serializer.endChunk();
+        serializer.beginChunk(2);
+        serializer.endChunk();
+
+        common::MemoryDeserializer deserializer(buffer.data(), buffer.size());
+        u32 id = 0;
+        u32 value = 0xFFFFFFFF;
+
+        EXPECT(deserializer.beginChunk(id));
+        deserializer.read(value);
+
+        EXPECT_NOT(deserializer.good());
+        EXPECT(value == 0u);
+    },
+
+    CASE("Incremental serializer only copies pages written since the last capture") {
+        static u8 block[16_KiB] = {};
+        common::DirtyTracker<16_KiB, 4_KiB> pages;
+        common::IncrementalSerializer serializer;
+        u32 header = 1;
+
+        pages.markAll();
+        serializer.begin();
+        serializer.write(header);
+        serializer.writePages(block, pages);
+        serializer.end();
+        pages.clear();
+        EXPECT(serializer.getBuffer().size() == sizeof(header) + sizeof(block));
+
+        //Written without being marked, so it shouldn't be picked up
+        block[100] = 0xAA;
+        block[9000] = 0xBB;
+        pages.mark(9000);
+        header = 2;
+
+        serializer.begin();
+        serializer.write(header);
+        serializer.writePages(block, pages);
+        serializer.end();
+
+        const std::vector<u8> &buffer = serializer.getBuffer();
+        EXPECT(buffer[0] == 2);
+        EXPECT(buffer[sizeof(header) + 100] == 0);
+        EXPECT(buffer[sizeof(header) + 9000] == 0xBB);
+
+        //The header, then the one page that was marked
+        const auto &changed = serializer.getChanged();
+        EXPECT(changed.size() == 2u);
+        EXPECT(changed[1].offset == sizeof(header) + 8_KiB);
+        EXPECT(changed[1].size == 4_KiB);
+    },
+
+    CASE("Reading pages only marks the ones that changed") {
+        static u8 source[8_KiB] = {};
+        static u8 block[8_KiB] = {};
+        common::DirtyTracker<8_KiB, 4_KiB> pages;
+        source[5000] = 1;
+
+        common::MemoryDeserializer deserializer(source, sizeof(source));
+        deserializer.readPages(block, pages);
+
+        EXPECT(deserializer.good());
+        EXPECT(block[5000] == 1);
+        EXPECT_NOT(pages.isDirty(0));
+        EXPECT(pages.isDirty(1));
+    }
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "common/StatePack.hpp"
+#include "common/Compression.hpp"
+
+#include <lest/lest.hpp>
+#include <cstring>
+#include <vector>
+
+
+//Mostly zeroes with some noise in it, like a real state
+static auto makeState(size_t size) -> std::vector<u8> {
+    std::vector<u8> state(size, 0);
+    u32 seed = 7;
+
+    for(size_t i = 0; i < size; i += 3) {
+        seed = seed * 1664525 + 1013904223;
+        state[i] = seed >> 24;
+    }
+
+    return state;
+}
+
+//Swaps out the size stored in front of the compressed state, which is the last chunk
+static void setStateSize(std::vector<u8> &packed, size_t compressed_size, u32 state_size) {
+    const size_t offset = packed.size() - compressed_size - sizeof(u32);
+    std::memcpy(&packed[offset], &state_size, sizeof(state_size));
+}
+
+const lest::test common_state_pack_tests[] = {
+    CASE("Packed states unpack to the same state, with or without a thumbnail") {
+        const std::vector<u8> state = makeState(300000);
+
+        for(size_t frame_size : {size_t(0), size_t(240 * 160)}) {
+            std::vector<u8> packed;
+            common::packState(state, std::vector<u32>(frame_size, 0x11223344), true, packed);
+            EXPECT(common::isPackedState(packed.data(), packed.size()));
+            EXPECT(packed.size() < state.size());
+
+            std::vector<u8> buffer;
+            const u8 *unpacked = nullptr;
+            size_t unpacked_size = 0;
+            EXPECT(common::unpackState(packed.data(), packed.size(), buffer, unpacked, unpacked_size));
+            EXPECT(std::vector<u8>(unpacked, unpacked + unpacked_size) == state);
+        }
+    },
+
+    CASE("Uncompressed states unpack to a block inside the packed data") {
+        const std::vector<u8> state = makeState(300000);
+
+        for(size_t frame_size : {size_t(0), size_t(240 * 160)}) {
+            std::vector<u8> packed;
+            common::packState(state, std::vector<u32>(frame_size, 0x11223344), false, packed);
+            EXPECT(common::isPackedState(packed.data(), packed.size()));
+
+            std::vector<u8> buffer;
+            const u8 *unpacked = nullptr;
+            size_t unpacked_size = 0;
+            EXPECT(common::unpackState(packed.data(), packed.size(), buffer, unpacked, unpacked_size));
+            EXPECT(buffer.empty());
+            EXPECT((unpacked >= packed.data() && unpacked + unpacked_size <= packed.data() + packed.size()));
+            EXPECT(std::vector<u8>(unpacked, unpacked + unpacked_size) == state);
+        }
+    },
+
+    CASE("States that aren't packed are told apart from ones that are") {
+        const std::vector<u8> state = makeState(1000);
+        EXPECT_NOT(common::isPackedState(state.data(), state.size()));
+        EXPECT_NOT(common::isPackedState(state.data(), 2));
+
+        std::vector<u8> buffer;
+        const u8 *unpacked = nullptr;
+        size_t unpacked_size = 0;
+        EXPECT_NOT(common::unpackState(state.data(), state.size(), buffer, unpacked, unpacked_size));
+    },
+
+    CASE("Packed states that are cut short, or claim a size that doesn't fit, are rejected") {
+        const std::vector<u8> state = makeState(50000);
+        std::vector<u8> compressed;
+        common::compress(state.data(), state.size(), compressed);
+
+        std::vector<u8> packed;
+        std::vector<u8> raw_packed;
+        common::packState(state, {}, true, packed);
+        common::packState(state, {}, false, raw_packed);
+
+        std::vector<u8> buffer;
+        const u8 *unpacked = nullptr;
+        size_t unpacked_size = 0;
+
+        for(const std::vector<u8> *whole : {&packed, &raw_packed}) {
+            const std::vector<u8> short_packed(whole->begin(), whole->end() - 100);
+            EXPECT_NOT(common::unpackState(short_packed.data(), short_packed.size(), buffer, unpacked, unpacked_size));
+        }
+
+        //Too small for what's in there, too big for the limit, and too big for a vector at all
+        for(u32 size : {u32(state.size() - 1), u32(common::MAX_STATE_SIZE + 1), u32(0xFFFFFFFF)}) {
+            std::vector<u8> bad_size = packed;
+            setStateSize(bad_size, compressed.size(), size);
+            EXPECT_NOT(common::unpackState(bad_size.data(), bad_size.size(), buffer, unpacked, unpacked_size));
+        }
+
+        //Uncompressed states can't claim more than the chunk has in it
+        for(u32 size : {u32(state.size() + 1), u32(common::MAX_STATE_SIZE + 1)}) {
+            std::vector<u8> bad_size = raw_packed;
+            setStateSize(bad_size, state.size(), size);
+            EXPECT_NOT(common::unpackState(bad_size.data(), bad_size.size(), buffer, unpacked, unpacked_size));
+        }
+    },
+
+    CASE("Thumbnails average each block of four pixels in every channel") {
+        std::vector<u32> frame(common::FRAME_WIDTH * common::FRAME_HEIGHT);
+
+        for(int y = 0; y < common::FRAME_HEIGHT; y++) {
+            for(int x = 0; x < common::FRAME_WIDTH; x++) {
+                const u32 value = (x % 2) * 2 + (y % 2) * 4 + (x / 2);
+                frame[x + y * common::FRAME_WIDTH] = value | (value + 8) << 8 | 0xFF0000 | (x % 2) * 0xFF000000;
+            }
+        }
+
+        const std::vector<u32> thumbnail = common::makeThumbnail(frame.data());
+        EXPECT(thumbnail.size() == size_t(common::THUMBNAIL_WIDTH * common::THUMBNAIL_HEIGHT));
+
+        bool matches = true;
+        for(int y = 0; y < common::THUMBNAIL_HEIGHT; y++) {
+            for(int x = 0; x < common::THUMBNAIL_WIDTH; x++) {
+                //(0 + 2 + 4 + 6) / 4 = 3 on top of the column, and the top byte rounds down from 127.5
+                const u32 value = 3 + x;
+                matches &= thumbnail[x + y * common::THUMBNAIL_WIDTH] == (value | (value + 8) << 8 | 0xFF0000 | 0x7F000000);
+            }
+        }
+
+        EXPECT(matches);
+    }
+};
\ No newline at end of file
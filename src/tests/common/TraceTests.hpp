@@ -0,0 +1,87 @@
+#pragma once
+
+#include "common/Buffer.hpp"
+#include "common/Trace.hpp"
+#include "common/MappedFile.hpp"
+
+#include <lest/lest.hpp>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+
+const lest::test common_trace_tests[] = {
+    CASE("Multi-producer queue hands over every value exactly once") {
+        common::MPSCRingBuffer<u32, 64> queue;
+        std::vector<std::thread> producers;
+        const u32 per_thread = 20000;
+
+        for(u32 t = 0; t < 4; t++) {
+            producers.emplace_back([&queue, t, per_thread]() {
+                for(u32 i = 0; i < per_thread; i++) {
+                    u32 value = (t << 24) | i;
+
+                    while(!queue.push(std::move(value))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        //Values from each producer come out in the order they were pushed
+        std::vector<u32> next(4, 0);
+        u32 received = 0;
+        bool in_order = true;
+
+        while(received < 4 * per_thread) {
+            u32 value;
+
+            if(queue.pop(value)) {
+                in_order = in_order && (value & 0xFFFFFF) == next[value >> 24];
+                next[value >> 24]++;
+                received++;
+            }
+        }
+
+        for(auto &producer : producers) {
+            producer.join();
+        }
+
+        u32 value;
+        EXPECT(in_order);
+        EXPECT_NOT(queue.pop(value));
+    },
+
+    CASE("Trace events read back the same as they were recorded") {
+        const common::trace::EventId first = common::trace::define_event("test_first", "value={:X}");
+        const common::trace::EventId second = common::trace::define_event("test_second", "a={} b={} c={}");
+        const std::string path = (std::filesystem::temp_directory_path() / "gambit_trace_test.bin").string();
+
+        EXPECT(common::trace::start(path));
+        TRACE_EVENT(first, 100, 0xDEADBEEFu);
+        TRACE_EVENT(second, 90, 1, 2, 3);
+        TRACE_EVENT(first, 1ull << 40, 0);
+        common::trace::stop();
+
+        //Nothing is recorded once the trace is stopped
+        TRACE_EVENT(first, 200, 1);
+
+        common::MappedFile file;
+        std::vector<common::trace::EventInfo> events;
+        std::vector<common::trace::Event> records;
+        EXPECT(file.open(path));
+        EXPECT(common::trace::read_trace(file.data(), file.size(), events, records));
+
+        EXPECT(records.size() == 3u);
+        EXPECT(records[0].id == first);
+        EXPECT(records[0].timestamp == 100u);
+        EXPECT(records[1].timestamp == 90u);
+        EXPECT(records[2].timestamp == 1ull << 40);
+        EXPECT(events[second].name == "test_second");
+        EXPECT(common::trace::format_event(events[first], records[0]) == "value=DEADBEEF");
+        EXPECT(common::trace::format_event(events[second], records[1]) == "a=1 b=2 c=3");
+
+        file.close();
+        std::filesystem::remove(path);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "emulator/core/InputMovie.hpp"
+
+#include <lest/lest.hpp>
+#include <vector>
+
+
+const lest::test core_input_movie_tests[] = {
+    CASE("Input movie keeps every change through a round trip") {
+        emu::InputMovie movie;
+        movie.title = "TEST";
+        movie.start_timestamp = 1000;
+        movie.state.assign(5000, 0x5A);
+
+        u64 timestamp = movie.start_timestamp;
+        for(u16 i = 0; i < 300; i++) {
+            timestamp += 1232 * (1 + i * 37);
+            movie.addKeys(timestamp, 0x3FF ^ (i & 0x3FF));
+        }
+
+        std::vector<u8> buffer;
+        common::MemorySerializer serializer(buffer);
+        movie.serialize(serializer);
+
+        emu::InputMovie loaded;
+        common::MemoryDeserializer deserializer(buffer.data(), buffer.size());
+        EXPECT(emu::InputMovie::isMovie(buffer.data(), buffer.size()));
+        EXPECT(loaded.deserialize(deserializer));
+        EXPECT(loaded.title == movie.title);
+        EXPECT(loaded.state == movie.state);
+        EXPECT(loaded.getLength() == movie.getLength());
+        EXPECT(loaded.entries.size() == movie.entries.size());
+
+        for(size_t i = 0; i < movie.entries.size(); i++) {
+            EXPECT(loaded.entries[i].timestamp == movie.entries[i].timestamp);
+            EXPECT(loaded.entries[i].keys == movie.entries[i].keys);
+        }
+
+        buffer.resize(buffer.size() - 3);
+        common::MemoryDeserializer truncated(buffer.data(), buffer.size());
+        EXPECT_NOT(loaded.deserialize(truncated));
+    },
+
+    CASE("Input movie gives the keys held at any time, going backwards too") {
+        emu::InputMovie movie;
+        movie.addKeys(100, 0x3FE);
+        movie.addKeys(200, 0x3FE);
+        movie.addKeys(300, 0x3F7);
+        movie.addKeys(400, 0x3FF);
+
+        EXPECT(movie.entries.size() == 3u);
+        EXPECT(movie.getKeys(50) == 0x3FF);
+        EXPECT(movie.getKeys(250) == 0x3FE);
+        EXPECT(movie.getKeys(300) == 0x3F7);
+        EXPECT(movie.getKeys(1000) == 0x3FF);
+        EXPECT(movie.getKeys(150) == 0x3FE);
+
+        //Polling earlier than the last change replaces what came after
+        movie.addKeys(250, 0x3EF);
+        EXPECT(movie.entries.size() == 2u);
+        EXPECT(movie.getKeys(1000) == 0x3EF);
+    },
+
+    CASE("Input movie stays in bounds when changes are replaced after looking ahead") {
+        emu::InputMovie movie;
+        movie.addKeys(100, 0x3FE);
+        movie.addKeys(200, 0x3FD);
+        movie.addKeys(300, 0x3FB);
+        movie.addKeys(400, 0x3F7);
+
+        EXPECT(movie.getKeys(1000) == 0x3F7);
+
+        movie.addKeys(150, 0x3FE);
+        EXPECT(movie.entries.size() == 1u);
+        EXPECT(movie.getKeys(1000) == 0x3FE);
+        EXPECT(movie.getKeys(50) == 0x3FF);
+    }
+};
\ No newline at end of file
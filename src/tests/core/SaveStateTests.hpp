@@ -0,0 +1,92 @@
+#pragma once
+
+#include "emulator/core/GBA.hpp"
+#include "tests/core/TestDevices.hpp"
+
+#include <lest/lest.hpp>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+const lest::test core_save_state_tests[] = {
+    CASE("States that can't be loaded leave the core as it was") {
+        IdleVideoDevice video_device;
+        IdleInputDevice input_device;
+        IdleAudioDevice audio_device;
+        auto core = std::make_unique<emu::GBA>(video_device, input_device, audio_device);
+        core->loadBIOS(std::vector<u8>(16_KiB, 0));
+        core->reset(false, false);
+
+        for(u32 i = 0; i < 256; i++) {
+            core->bus.write32(0x02000000 + i * 4, i * 0x01010101, emu::NONSEQUENTIAL);
+        }
+
+        std::vector<u8> state;
+        core->run(100000);
+        core->saveState(state);
+        const u64 saved_hash = core->stateHash();
+
+        core->bus.write32(0x02000000, 0xDEADBEEF, emu::NONSEQUENTIAL);
+        core->run(100000);
+        const u64 current_hash = core->stateHash();
+
+        //Cut off partway through the chunks, and before any of them
+        for(size_t size : {state.size() - 1, state.size() / 2, size_t(6), size_t(0)}) {
+            EXPECT_NOT(core->checkState(state.data(), size));
+            EXPECT_NOT(core->loadState(state.data(), size));
+            EXPECT(core->stateHash() == current_hash);
+        }
+
+        //The first component's chunk replaced with one that isn't known
+        std::vector<u8> missing = state;
+        missing[6] = 'X';
+        EXPECT_NOT(core->loadState(missing.data(), missing.size()));
+        EXPECT(core->stateHash() == current_hash);
+
+        EXPECT(core->loadState(state.data(), state.size()));
+        EXPECT(core->stateHash() == saved_hash);
+    },
+
+    CASE("A chunk shorter than its component leaves the core as it was") {
+        IdleVideoDevice video_device;
+        IdleInputDevice input_device;
+        IdleAudioDevice audio_device;
+        auto core = std::make_unique<emu::GBA>(video_device, input_device, audio_device);
+        core->loadBIOS(std::vector<u8>(16_KiB, 0));
+        core->reset(false, false);
+
+        std::vector<u8> state;
+        core->run(100000);
+        core->saveState(state);
+
+        for(u32 i = 0; i < 256; i++) {
+            core->bus.write32(0x02000000 + i * 4, i * 0x01010101, emu::NONSEQUENTIAL);
+        }
+        core->run(100000);
+
+        std::vector<u8> current;
+        core->saveState(current);
+
+        //The last word of the bus chunk is dropped, after the components before it would load fine
+        size_t offset = 6;
+        while(std::memcmp(&state[offset], "BUS ", 4) != 0) {
+            u32 length = 0;
+            std::memcpy(&length, &state[offset + 4], 4);
+            offset += 8 + length;
+        }
+
+        u32 length = 0;
+        std::memcpy(&length, &state[offset + 4], 4);
+        length -= 4;
+        std::memcpy(&state[offset + 4], &length, 4);
+        state.erase(state.begin() + offset + 8 + length, state.begin() + offset + 12 + length);
+
+        EXPECT(core->checkState(state.data(), state.size()));
+        EXPECT_NOT(core->loadState(state.data(), state.size()));
+
+        std::vector<u8> after;
+        core->saveState(after);
+        EXPECT(after == current);
+    }
+};
\ No newline at end of file
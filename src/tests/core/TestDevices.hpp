@@ -0,0 +1,30 @@
+#pragma once
+
+#include "emulator/device/VideoDevice.hpp"
+#include "emulator/device/InputDevice.hpp"
+#include "emulator/device/AudioDevice.hpp"
+
+
+//Devices for running the core in tests that don't look at what comes out of it
+class IdleVideoDevice final : public emu::VideoDevice {
+public:
+
+    void setPixel(int, int, u32) override { }
+    void setLine(int, const u32*) override { }
+    void presentFrame() override { }
+};
+
+class IdleInputDevice final : public emu::InputDevice {
+public:
+
+    auto getKeys() -> u16 override { return 0x3FF; }
+};
+
+class IdleAudioDevice final : public emu::AudioDevice {
+public:
+
+    void pushSample(float, float) override { }
+    void pushSamples(const float*, size_t) override { }
+    auto full() -> bool override { return false; }
+    void setSampleRate(int) override { }
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "emulator/core/apu/BlipBuffer.hpp"
+
+#include <lest/lest.hpp>
+
+
+const lest::test apu_blip_buffer_tests[] = {
+    CASE("BlipBuffer settles on the exact amplitude after a step") {
+        emu::BlipBuffer blip;
+        blip.setPeriod(512);
+        blip.reset(0);
+        blip.addDelta(700, 15);
+
+        float sample = 0;
+        for(u64 i = 1; i <= 32; i++) {
+            sample = blip.readSample(i * 512);
+        }
+
+        EXPECT(sample == 15.0f);
+    },
+
+    CASE("BlipBuffer doesn't drift after many steps") {
+        emu::BlipBuffer blip;
+        blip.setPeriod(64);
+        blip.reset(0);
+
+        //A square wave that doesn't line up with the sample period
+        s32 level = 0;
+        u64 time = 0;
+        for(u64 i = 1; i <= 100000; i++) {
+            while(time + 37 <= i * 64) {
+                time += 37;
+                blip.addDelta(time, level == 0 ? 8 : -8);
+                level = level == 0 ? 8 : 0;
+            }
+
+            blip.readSample(i * 64);
+        }
+
+        if(level != 0) {
+            blip.addDelta(time, -8);
+        }
+
+        float sample = 0;
+        for(u64 i = 1; i <= 32; i++) {
+            sample = blip.readSample((100000 + i) * 64);
+        }
+
+        EXPECT(sample == 0.0f);
+    }
+};
\ No newline at end of file
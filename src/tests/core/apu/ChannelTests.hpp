@@ -0,0 +1,151 @@
+#pragma once
+
+#include "emulator/core/apu/channels/PulseChannel.hpp"
+#include "emulator/core/apu/channels/WaveChannel.hpp"
+#include "emulator/core/apu/channels/NoiseChannel.hpp"
+#include "emulator/core/Scheduler.hpp"
+
+#include <lest/lest.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+
+struct ChannelWrite {
+    u64 timestamp;
+    u32 address;
+    u8 value;
+};
+
+//Plays a sequence of register writes on a channel, stepping the frame sequencer like the APU does,
+//and gives back every sample. Eager runs also rewrite the frequency's low byte every few cycles,
+//which changes nothing but makes the channel catch up one tick at a time
+template<typename Channel>
+static auto playChannel(const std::vector<ChannelWrite> &writes, u32 frequency_address, u64 end, bool eager) -> std::vector<float> {
+    constexpr u64 NEVER = std::numeric_limits<u64>::max();
+    constexpr u64 SAMPLE_PERIOD = 4096;
+    constexpr u64 STEP_PERIOD = 32768;
+    constexpr u64 EAGER_PERIOD = 8;
+
+    emu::Scheduler scheduler;
+    Channel channel(scheduler);
+    channel.reset();
+    channel.setSamplePeriod(SAMPLE_PERIOD);
+
+    std::vector<float> samples;
+    size_t write_index = 0;
+    u8 frequency = 0;
+    u64 next_sample = SAMPLE_PERIOD;
+    u64 next_step = STEP_PERIOD;
+    u64 next_eager = eager ? EAGER_PERIOD : NEVER;
+
+    while(next_sample <= end) {
+        const u64 next_write = write_index < writes.size() ? writes[write_index].timestamp : NEVER;
+        const u64 now = std::min({next_sample, next_step, next_eager, next_write});
+        scheduler.step(static_cast<u32>(now - scheduler.getCurrentTimestamp()));
+
+        if(now == next_step) {
+            channel.step(now);
+            next_step += STEP_PERIOD;
+        }
+
+        for(; write_index < writes.size() && writes[write_index].timestamp == now; write_index++) {
+            channel.write(writes[write_index].address, writes[write_index].value);
+
+            if(writes[write_index].address == frequency_address) {
+                frequency = writes[write_index].value;
+            }
+        }
+
+        if(now == next_eager) {
+            channel.write(frequency_address, frequency);
+            next_eager += EAGER_PERIOD;
+        }
+
+        if(now == next_sample) {
+            samples.push_back(channel.sample(now));
+            next_sample += SAMPLE_PERIOD;
+        }
+    }
+
+    return samples;
+}
+
+template<typename Channel>
+static auto lazyMatchesEager(const std::vector<ChannelWrite> &writes, u32 frequency_address) -> bool {
+    constexpr u64 END = 3000000;
+    const std::vector<float> lazy = playChannel<Channel>(writes, frequency_address, END, false);
+    const std::vector<float> eager = playChannel<Channel>(writes, frequency_address, END, true);
+
+    //Make sure the channel actually made a sound
+    const bool audible = std::any_of(lazy.begin(), lazy.end(), [](float sample) { return sample != 0; });
+
+    return audible && lazy == eager;
+}
+
+const lest::test apu_channel_tests[] = {
+    CASE("Pulse channel catches up to the same output as stepping every tick") {
+        const std::vector<ChannelWrite> writes = {
+            //50% duty at the highest frequency, full volume
+            {1000, 0x62, 0x80}, {1000, 0x63, 0xF0}, {1000, 0x64, 0xFF}, {1000, 0x65, 0x87},
+
+            //12.5% duty at a lower frequency, then a slow sweep up
+            {200003, 0x62, 0x00}, {200003, 0x64, 0x00},
+            {400007, 0x60, 0x13}, {400007, 0x64, 0x20}, {400007, 0x65, 0x84},
+
+            //Silent until the envelope brings the volume up
+            {700001, 0x60, 0x00}, {700001, 0x62, 0xC0}, {700001, 0x63, 0x09}, {700001, 0x64, 0x55}, {700001, 0x65, 0x86},
+
+            //Duty changes while running, and a length that runs out
+            {2200009, 0x62, 0x40}, {2500011, 0x62, 0x3C}, {2500011, 0x63, 0xA0}, {2500011, 0x65, 0xC6}
+        };
+
+        EXPECT(lazyMatchesEager<emu::PulseChannel>(writes, 0x64));
+    },
+
+    CASE("Wave channel catches up to the same output as stepping every tick") {
+        std::vector<ChannelWrite> writes;
+
+        //Both banks get a ramp, the second written while the first is selected
+        for(u32 i = 0; i < 16; i++) {
+            writes.push_back({100, 0x90 + i, static_cast<u8>(i * 0x11 + 0x01)});
+        }
+        writes.push_back({200, 0x70, 0x40});
+        for(u32 i = 0; i < 16; i++) {
+            writes.push_back({300, 0x90 + i, static_cast<u8>(0xF0 - i * 0x10 + i)});
+        }
+
+        const std::vector<ChannelWrite> sequence = {
+            //One bank at full volume
+            {1000, 0x70, 0x00}, {1000, 0x73, 0x20}, {1000, 0x74, 0xF0}, {1000, 0x75, 0x87},
+
+            //Both banks, then 75% volume
+            {300001, 0x70, 0x20}, {300001, 0x74, 0x00},
+            {600007, 0x73, 0x80},
+
+            //Muted for a while, then back at 50% volume
+            {900011, 0x73, 0x00}, {1700003, 0x73, 0x40}
+        };
+        writes.insert(writes.end(), sequence.begin(), sequence.end());
+
+        EXPECT(lazyMatchesEager<emu::WaveChannel>(writes, 0x74));
+    },
+
+    CASE("Noise channel catches up to the same output as stepping every tick") {
+        const std::vector<ChannelWrite> writes = {
+            //15-bit LFSR at the highest frequency
+            {1000, 0x79, 0xF0}, {1000, 0x7C, 0x00}, {1000, 0x7D, 0x80}, {1000, 0x79, 0x00},
+
+            //7-bit LFSR at a lower frequency
+            {300007, 0x7C, 0x2B},
+
+            //Silent for a while, switching back to the 15-bit LFSR
+            {600001, 0x79, 0xF0}, {900003, 0x7C, 0x01}, {1500007, 0x79, 0x00},
+
+            //Back to 7 bits with a length that runs out
+            {2000011, 0x7C, 0x19}, {2000011, 0x78, 0x3C}, {2000011, 0x79, 0xF0}, {2000011, 0x7D, 0xC0}, {2000011, 0x79, 0x00}
+        };
+
+        EXPECT(lazyMatchesEager<emu::NoiseChannel>(writes, 0x7C));
+    }
+};
\ No newline at end of file
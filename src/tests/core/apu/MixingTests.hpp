@@ -0,0 +1,86 @@
+#pragma once
+
+#include "emulator/core/GBA.hpp"
+#include "tests/core/TestDevices.hpp"
+
+#include <lest/lest.hpp>
+#include <memory>
+#include <vector>
+
+
+//Keeps the last sample pair pushed by the APU
+class LastSampleAudioDevice final : public emu::AudioDevice {
+public:
+
+    void pushSample(float l, float r) override {
+        left = l;
+        right = r;
+    }
+
+    void pushSamples(const float *samples, size_t count) override {
+        if(count != 0) {
+            left = samples[count * 2 - 2];
+            right = samples[count * 2 - 1];
+        }
+    }
+
+    auto full() -> bool override { return false; }
+    void setSampleRate(int) override { }
+
+    float left = 0;
+    float right = 0;
+};
+
+//Plays a constant level of 15 on the wave channel at each PSG volume in
+//SOUNDCNT_H, and gives back the right output once it has settled
+static auto mixPsgVolumes() -> std::vector<float> {
+    IdleVideoDevice video_device;
+    IdleInputDevice input_device;
+    LastSampleAudioDevice audio_device;
+
+    auto core = std::make_unique<emu::GBA>(video_device, input_device, audio_device);
+    core->loadBIOS(std::vector<u8>(16_KiB, 0));
+    core->reset(false, false);
+
+    auto write16 = [&core](u32 address, u16 value) {
+        core->bus.write16(address, value, emu::NONSEQUENTIAL);
+    };
+
+    //Wave RAM is written to the bank that isn't selected, so fill one and play it back
+    write16(0x04000084, 0x0080);
+    write16(0x04000070, 0x0000);
+    for(u32 i = 0; i < 16; i += 2) {
+        write16(0x04000090 + i, 0xFFFF);
+    }
+    write16(0x04000070, 0x0040);
+    write16(0x04000072, 0x2000);
+    write16(0x04000074, 0x8000);
+
+    //Wave channel on the right at the highest master volume
+    write16(0x04000080, 0x0407);
+
+    std::vector<float> levels;
+    for(u16 volume = 0; volume < 4; volume++) {
+        write16(0x04000082, volume);
+        core->run(280896);
+        levels.push_back(audio_device.right);
+    }
+
+    return levels;
+}
+
+const lest::test apu_mixing_tests[] = {
+    CASE("PSG volume scales the channels by 25%, 50% and 100%, with the prohibited setting at 100%") {
+        const std::vector<float> levels = mixPsgVolumes();
+
+        //Channel level times the master volume (7 + 1) at each PSG volume, the default bias doesn't add anything
+        const std::vector<float> expected = {
+            15 * 8 / 4 / static_cast<float>(0x800),
+            15 * 8 / 2 / static_cast<float>(0x800),
+            15 * 8 / static_cast<float>(0x800),
+            15 * 8 / static_cast<float>(0x800)
+        };
+
+        EXPECT(levels == expected);
+    }
+};
\ No newline at end of file
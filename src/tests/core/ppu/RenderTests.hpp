@@ -0,0 +1,214 @@
+#pragma once
+
+#include "emulator/core/GBA.hpp"
+#include "emulator/core/ppu/Renderer.hpp"
+#include "common/Hash.hpp"
+#include "tests/core/TestDevices.hpp"
+
+#include <lest/lest.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+//Keeps a hash of every frame presented, which may be from the render thread
+class FrameHashVideoDevice final : public emu::VideoDevice {
+public:
+
+    void setPixel(int x, int y, u32 color) override {
+        framebuffer[x + y * 240] = color;
+    }
+
+    void setLine(int y, const u32 *colors) override {
+        std::memcpy(&framebuffer[y * 240], colors, sizeof(u32) * 240);
+    }
+
+    void presentFrame() override {
+        hashes.push_back(common::hash64(framebuffer, sizeof(framebuffer)));
+    }
+
+    u32 framebuffer[240 * 160] = {};
+    std::vector<u64> hashes;
+};
+
+//Draws random scenes in every mode, with registers and memory written mid-frame
+//and a state loaded mid-frame, and gives back the hash of every frame
+static auto renderScenes(bool threaded, bool batched) -> std::vector<u64> {
+    FrameHashVideoDevice video_device;
+    IdleInputDevice input_device;
+    IdleAudioDevice audio_device;
+
+    {
+        //No ROM, so the CPU just runs through the empty BIOS
+        auto core = std::make_unique<emu::GBA>(video_device, input_device, audio_device);
+        core->loadBIOS(std::vector<u8>(16_KiB, 0));
+        core->ppu.setThreadedRendering(threaded);
+        core->ppu.setBatchedRendering(batched);
+
+        u32 seed = 1;
+        auto random = [&seed]() -> u16 {
+            seed = seed * 1664525 + 1013904223;
+            return seed >> 16;
+        };
+        auto write16 = [&core](u32 address, u16 value) {
+            core->bus.write16(address, value, emu::NONSEQUENTIAL);
+        };
+        auto runToLine = [&core](u16 line) {
+            while((core->bus.read16(0x04000006, emu::NONSEQUENTIAL) & 0xFF) != line) {
+                core->run(200);
+            }
+        };
+        auto writeRegisters = [&]() {
+            write16(0x04000000, (random() & 0xFF78) | random() % 6);
+
+            for(u32 address = 0x08; address < 0x56; address += 2) {
+                u16 value = random();
+
+                //Keep 8bpp backgrounds from reading past the end of VRAM
+                if(address < 0x10 && (value & 0x80)) {
+                    value &= ~0x8;
+                }
+
+                write16(0x04000000 + address, value);
+            }
+        };
+
+        std::vector<u8> state;
+
+        for(int scene = 0; scene < 12; scene++) {
+            core->reset(false, false);
+
+            for(u32 i = 0; i < 96_KiB; i += 2) {
+                write16(0x06000000 + i, random());
+            }
+            for(u32 i = 0; i < 1_KiB; i += 2) {
+                write16(0x05000000 + i, random());
+                write16(0x07000000 + i, random());
+            }
+
+            writeRegisters();
+            runToLine(160);
+
+            //Written after the frame has started drawing
+            writeRegisters();
+            runToLine(0);
+            runToLine(100);
+            write16(0x06000000 + (random() % 96_KiB & ~1), random());
+            writeRegisters();
+            runToLine(160);
+
+            writeRegisters();
+            runToLine(80);
+            core->saveState(state);
+            runToLine(160);
+
+            //Nothing is written this frame before the state is loaded
+            writeRegisters();
+            runToLine(80);
+            core->loadState(state.data(), state.size());
+            runToLine(160);
+        }
+    }
+
+    return video_device.hashes;
+}
+
+//Draws a frame of a bitmap mode over random VRAM, with the background moved to (x, y). Turning on
+//objects, all of them hidden, changes nothing on screen but keeps the PPU off its bitmap-only path
+static auto renderBitmap(u16 mode, bool frame_1, int x, int y, bool objects) -> std::vector<u32> {
+    FrameHashVideoDevice video_device;
+    IdleInputDevice input_device;
+    IdleAudioDevice audio_device;
+
+    auto core = std::make_unique<emu::GBA>(video_device, input_device, audio_device);
+    core->loadBIOS(std::vector<u8>(16_KiB, 0));
+    core->reset(false, false);
+
+    u32 seed = 1;
+    auto random = [&seed]() -> u16 {
+        seed = seed * 1664525 + 1013904223;
+        return seed >> 16;
+    };
+    auto write16 = [&core](u32 address, u16 value) {
+        core->bus.write16(address, value, emu::NONSEQUENTIAL);
+    };
+
+    for(u32 i = 0; i < 96_KiB; i += 2) {
+        write16(0x06000000 + i, random());
+    }
+    for(u32 i = 0; i < 1_KiB; i += 2) {
+        write16(0x05000000 + i, random());
+        write16(0x07000000 + i, i % 8 == 0 ? 0x0200 : random());
+    }
+
+    //BG2 only, not rotated or scaled, with its reference point at (x, y)
+    write16(0x04000000, mode | (frame_1 ? 0x0010 : 0) | 0x0400 | (objects ? 0x1000 : 0));
+    write16(0x04000020, 0x0100);
+    write16(0x04000022, 0x0000);
+    write16(0x04000024, 0x0000);
+    write16(0x04000026, 0x0100);
+    const u32 reference_x = static_cast<u32>(x * 256);
+    const u32 reference_y = static_cast<u32>(y * 256);
+    write16(0x04000028, reference_x & 0xFFFF);
+    write16(0x0400002A, reference_x >> 16);
+    write16(0x0400002C, reference_y & 0xFFFF);
+    write16(0x0400002E, reference_y >> 16);
+
+    //The reference point is only picked up at the start of a frame
+    while(video_device.hashes.size() < 2) {
+        core->run(1000);
+    }
+
+    return std::vector<u32>(video_device.framebuffer, video_device.framebuffer + 240 * 160);
+}
+
+const lest::test ppu_render_tests[] = {
+    CASE("Threaded and batched rendering draw the same frames as drawing every line") {
+        const std::vector<u64> reference = renderScenes(false, false);
+
+        //Filling memory at the start of each scene takes up a frame of its own
+        EXPECT(reference.size() == 60u);
+        EXPECT(renderScenes(false, true) == reference);
+        EXPECT(renderScenes(true, false) == reference);
+        EXPECT(renderScenes(true, true) == reference);
+    },
+
+    CASE("Bitmap modes draw the same frames on their own path as with everything else") {
+        //Lined up, scrolled both ways, and partly or fully off the bitmap
+        const int offsets[][2] = {{0, 0}, {37, 11}, {-53, -29}, {100, 90}, {-300, 0}, {0, 200}};
+
+        for(u16 mode = 3; mode <= 5; mode++) {
+            for(bool frame_1 : {false, true}) {
+                for(const auto &offset : offsets) {
+                    const std::vector<u32> simple = renderBitmap(mode, frame_1, offset[0], offset[1], false);
+                    const std::vector<u32> general = renderBitmap(mode, frame_1, offset[0], offset[1], true);
+                    EXPECT((simple == general));
+
+                    const bool shown = std::any_of(simple.begin(), simple.end(), [](u32 color) { return color != 0 && color != 0xFF; });
+                    EXPECT(shown == (offset[0] > -240 && offset[1] < 160));
+                }
+            }
+        }
+    },
+
+    CASE("Converting colors with SSE2 gives the same as one pixel at a time") {
+        std::vector<u16> colors(240);
+        u32 vectorized[240];
+        u32 plain[240];
+        bool matches = true;
+
+        //Every color, with and without the unused top bit
+        for(u32 first = 0; first < 0x10000; first += 240) {
+            for(u32 i = 0; i < 240; i++) {
+                colors[i] = static_cast<u16>(first + i);
+            }
+
+            emu::Renderer::convertLine(colors.data(), vectorized, true);
+            emu::Renderer::convertLine(colors.data(), plain, false);
+            matches &= std::memcmp(vectorized, plain, sizeof(plain)) == 0;
+        }
+
+        EXPECT(matches);
+    }
+};
\ No newline at end of file
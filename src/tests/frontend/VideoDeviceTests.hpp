@@ -0,0 +1,168 @@
+#pragma once
+
+#include "frontend/device/OGLVideoDevice.hpp"
+
+#include <lest/lest.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+//Fills a frame with colors that are different for every pixel and every seed
+static auto makeFrame(u32 seed) -> std::vector<u32> {
+    std::vector<u32> frame(240 * 160);
+
+    for(u32 i = 0; i < frame.size(); i++) {
+        seed = seed * 1664525 + 1013904223;
+        frame[i] = seed;
+    }
+
+    return frame;
+}
+
+static void submitFrame(OGLVideoDevice &device, const std::vector<u32> &frame) {
+    for(int y = 0; y < 160; y++) {
+        device.setLine(y, &frame[y * 240]);
+    }
+
+    device.presentFrame();
+}
+
+//The texture only stores RGB, so alpha is left out of every comparison
+static auto readTexture(GLuint texture_id) -> std::vector<u32> {
+    std::vector<u32> pixels(240 * 160);
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for(auto &pixel : pixels) {
+        pixel &= ~0xFFu;
+    }
+
+    return pixels;
+}
+
+static auto withoutAlpha(std::vector<u32> frame) -> std::vector<u32> {
+    for(auto &pixel : frame) {
+        pixel &= ~0xFFu;
+    }
+
+    return frame;
+}
+
+//Pushes frames through the triple buffer and checks the texture holds exactly
+//the latest one each time the UI thread asks for it
+static void checkUploads(lest::env &lest_env, bool persistent) {
+    //GL 4.4 is what decides whether the framebuffers live in a mapped pixel buffer
+    const int has_gl_4_4 = GLAD_GL_VERSION_4_4;
+    EXPECT((!persistent || has_gl_4_4));
+    GLAD_GL_VERSION_4_4 = persistent ? has_gl_4_4 : 0;
+
+    {
+        OGLVideoDevice device;
+        EXPECT(readTexture(device.getTextureID()) == std::vector<u32>(240 * 160, 0));
+
+        const std::vector<u32> first = makeFrame(1);
+        submitFrame(device, first);
+        EXPECT(readTexture(device.getTextureID()) == withoutAlpha(first));
+        EXPECT(std::equal(first.begin(), first.end(), device.getPresentedFrame()));
+
+        //Only the newest of several frames is shown, and nothing changes without a new one
+        submitFrame(device, makeFrame(2));
+        const std::vector<u32> third = makeFrame(3);
+        submitFrame(device, third);
+        EXPECT(readTexture(device.getTextureID()) == withoutAlpha(third));
+        EXPECT(readTexture(device.getTextureID()) == withoutAlpha(third));
+
+        //Every buffer gets reused a few times over
+        for(u32 seed = 4; seed < 16; seed++) {
+            const std::vector<u32> frame = makeFrame(seed);
+            submitFrame(device, frame);
+            EXPECT(readTexture(device.getTextureID()) == withoutAlpha(frame));
+        }
+
+        device.clear(0x336699FF);
+        EXPECT(readTexture(device.getTextureID()) == std::vector<u32>(240 * 160, 0x33669900));
+
+        //A frame drawn before the clear is dropped
+        submitFrame(device, makeFrame(16));
+        device.clear(0);
+        EXPECT(readTexture(device.getTextureID()) == std::vector<u32>(240 * 160, 0));
+    }
+
+    GLAD_GL_VERSION_4_4 = has_gl_4_4;
+}
+
+//The emulator thread draws frames that are a single color each while the UI
+//thread keeps uploading, every texture has to be one whole frame and they
+//can only go forwards
+static void checkThreadedUploads(lest::env &lest_env, bool persistent) {
+    const int has_gl_4_4 = GLAD_GL_VERSION_4_4;
+    GLAD_GL_VERSION_4_4 = persistent ? has_gl_4_4 : 0;
+
+    {
+        OGLVideoDevice device;
+        constexpr u32 FRAMES = 300;
+        std::atomic<bool> done = false;
+
+        std::thread emulator([&device, &done]() {
+            for(u32 frame = 1; frame <= FRAMES; frame++) {
+                const std::vector<u32> line(240, frame << 8);
+
+                for(int y = 0; y < 160; y++) {
+                    device.setLine(y, line.data());
+                }
+
+                device.presentFrame();
+            }
+
+            done.store(true);
+        });
+
+        u32 last_frame = 0;
+        bool torn = false;
+        bool backwards = false;
+
+        while(last_frame != FRAMES) {
+            const bool finished = done.load();
+            const std::vector<u32> pixels = readTexture(device.getTextureID());
+            const u32 frame = pixels[0] >> 8;
+
+            torn |= pixels != std::vector<u32>(240 * 160, pixels[0]);
+            backwards |= frame < last_frame;
+            last_frame = frame;
+
+            //Once every frame is in, the next upload has to be the last one
+            if(finished) {
+                EXPECT(frame == FRAMES);
+                break;
+            }
+        }
+
+        emulator.join();
+        EXPECT(!torn);
+        EXPECT(!backwards);
+    }
+
+    GLAD_GL_VERSION_4_4 = has_gl_4_4;
+}
+
+const lest::test frontend_video_device_tests[] = {
+    CASE("Frames uploaded from a persistently mapped pixel buffer match what was drawn") {
+        checkUploads(lest_env, true);
+    },
+
+    CASE("Frames uploaded from client memory match what was drawn") {
+        checkUploads(lest_env, false);
+    },
+
+    CASE("Frames drawn on another thread are uploaded whole and in order from a pixel buffer") {
+        checkThreadedUploads(lest_env, true);
+    },
+
+    CASE("Frames drawn on another thread are uploaded whole and in order from client memory") {
+        checkThreadedUploads(lest_env, false);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+//EGL has to come before glad, which defines some of the same macros differently
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "tests/frontend/VideoDeviceTests.hpp"
+
+#include <iostream>
+
+#define TEST_VEC(specification) lest::tests(specification, specification + sizeof(specification) / sizeof(specification[0]))
+
+
+const std::vector<lest::tests> all_tests = {
+    TEST_VEC(frontend_video_device_tests)
+};
+
+//Makes an offscreen GL 4.5 context current, preferring Mesa's surfaceless
+//platform so that no display server is needed
+static auto createContext() -> bool {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if(getPlatformDisplay != nullptr) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if(display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+
+    if(!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        return false;
+    }
+
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+        return false;
+    }
+
+    return gladLoadGL(reinterpret_cast<GLADloadfunc>(eglGetProcAddress)) != 0;
+}
+
+int main(int argc, char *argv[]) {
+    if(!createContext()) {
+        std::cout << "Failed to create an offscreen GL 4.5 context through EGL!\n";
+        return 1;
+    }
+
+    //For command line arguments
+    lest::run(lest::tests(), argc, argv);
+    
+    int failures = 0;
+    for(lest::tests t : all_tests) {
+        failures += lest::run(t, 1, argv);
+    }
+
+    if(failures != 0)
+        std::cout << "\n" << failures << " test(s) failed!\n";
+    else
+        std::cout << "\nAll tests passed!\n";
+
+    return failures;
+}
\ No newline at end of file